@@ -0,0 +1,44 @@
+#pragma once
+#include "game_utils.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Пакет независимых миров для статистики баланса: прогон i — свой
+// WorldContext с зерном first_seed + i и ровно ticks тиков. Если миров не
+// меньше, чем потоков, миры идут параллельно и каждый тикает в своём
+// потоке; иначе — по очереди, с фазами на всех потоках. Любой прогон
+// повторяется через main с теми же --seed, --ticks, --npcs, --spawn-rate и
+// --combat.
+struct BatchSetup {
+    std::uint64_t first_seed{1};
+    std::size_t runs{1000};
+    std::uint64_t ticks{200};
+    int npcs{50};
+    double spawn_rate{0};  // подкреплений в секунду времени симуляции
+    CombatMode combat{CombatMode::Sequential};
+    unsigned threads{0};   // 0 — по числу ядер
+};
+
+constexpr std::size_t NPC_TYPE_COUNT = static_cast<std::size_t>(NPCType::Count);
+
+// Итог одного мира по типам (индекс — NPCType)
+struct WorldOutcome {
+    std::uint64_t seed{0};
+    std::array<std::uint32_t, NPC_TYPE_COUNT> spawned{};
+    std::array<std::uint32_t, NPC_TYPE_COUNT> survivors{};
+    std::array<std::uint32_t, NPC_TYPE_COUNT> kills{};  // по типу убившего
+};
+
+std::vector<WorldOutcome> run_batch(const BatchSetup& setup);
+
+// Сводка по типам: среднее, разброс и крайние значения выживших, доля
+// вымерших и единственных выживших, убийства на мир
+bool write_batch_csv(const std::string& path, const std::vector<WorldOutcome>& results);
+// Строка на мир: зерно и счётчики по типам
+bool write_batch_runs_csv(const std::string& path, const std::vector<WorldOutcome>& results);
+
+// Прогнать пакет, напечатать сводку и записать CSV (runs_csv_path — если
+// не пуст). false — не удалось записать файл
+bool run_batch_study(const BatchSetup& setup, const std::string& csv_path, const std::string& runs_csv_path);
@@ -0,0 +1,67 @@
+#pragma once
+#include "render_commands.h"
+#include "sprite_atlas.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Встроенный растровый шрифт: глифы 5x7 лежат в атласе (sprite_atlas.h),
+// текст рисуется обычными квадами из атласа — без шрифтов ОС и без шейпинга.
+constexpr int FONT_GLYPH_W = 5;
+constexpr int FONT_GLYPH_H = 7;
+constexpr int FONT_CELL_W = 6;   // шаг по горизонтали
+constexpr int FONT_CELL_H = 8;   // высота строки
+constexpr int FONT_FIRST = 32;
+constexpr int FONT_LAST = 126;
+constexpr int FONT_PER_ROW = ATLAS_WIDTH / FONT_CELL_W;
+
+constexpr TextureRect font_glyph(char c) {
+    int code = static_cast<unsigned char>(c);
+    if (code < FONT_FIRST || code > FONT_LAST) code = '?';
+    int i = code - FONT_FIRST;
+    return {static_cast<std::uint16_t>((i % FONT_PER_ROW) * FONT_CELL_W),
+            static_cast<std::uint16_t>(ATLAS_FONT_Y + (i / FONT_PER_ROW) * FONT_CELL_H),
+            FONT_GLYPH_W, FONT_GLYPH_H};
+}
+
+// Целочисленный масштаб для кегля: пиксель-арт не растягиваем дробно
+constexpr int text_scale(unsigned size) {
+    return size < 14 ? 1 : static_cast<int>(size) / 7;
+}
+
+constexpr float text_width(std::size_t length, unsigned size) {
+    return static_cast<float>(length * FONT_CELL_W * text_scale(size));
+}
+
+constexpr float text_height(unsigned size) {
+    return static_cast<float>(FONT_CELL_H * text_scale(size));
+}
+
+// Один квад глифа относительно начала строки
+struct GlyphQuad {
+    float dx, dy;
+    float w, h;
+    TextureRect src;
+};
+
+// Раскладка строки, пересчитываемая только при смене текста или кегля
+class TextRun {
+public:
+    // true — строка изменилась и геометрия построена заново
+    bool set(std::string_view str, unsigned size);
+
+    const std::vector<GlyphQuad>& glyphs() const { return quads; }
+    float width() const { return text_width(text.size(), font_size); }
+    float height() const { return text_height(font_size); }
+
+private:
+    std::string text;
+    unsigned font_size{0};
+    std::vector<GlyphQuad> quads;
+};
+
+// Строка напрямую (подписи NPC: раскладка — только арифметика)
+void emit_text(RenderCommandList& out, std::string_view str, float x, float y, unsigned size, std::uint32_t color);
+
+// Готовая раскладка из кэша
+void emit_text(RenderCommandList& out, const TextRun& run, float x, float y, std::uint32_t color);
@@ -0,0 +1,40 @@
+#pragma once
+
+// Проекция мира на кадр для конкретного размера окна
+struct Viewport {
+    float scale_x{1}, scale_y{1};   // пикселей на единицу мира
+    float offset_x{0}, offset_y{0}; // экранная позиция мировой точки (0, 0)
+
+    float toScreenX(float wx) const { return wx * scale_x + offset_x; }
+    float toScreenY(float wy) const { return wy * scale_y + offset_y; }
+    float toWorldX(float sx) const { return (sx - offset_x) / scale_x; }
+    float toWorldY(float sy) const { return (sy - offset_y) / scale_y; }
+};
+
+// Камера: центр в координатах мира и масштаб.
+// zoom = 1 — весь мир растянут на окно (по осям независимо, как раньше).
+class Camera {
+public:
+    static constexpr float MIN_ZOOM = 0.05f;
+    static constexpr float MAX_ZOOM = 16.0f;
+
+    Camera(float world_w, float world_h);
+
+    Viewport view(float width, float height) const;
+
+    // Сдвиг на (dx, dy) пикселей экрана
+    void pan(float dx, float dy, const Viewport& vp);
+    // Масштабирование с неподвижной точкой (sx, sy) на экране
+    void zoomAt(float factor, float sx, float sy, const Viewport& vp);
+    void reset();
+
+    void setWorldSize(float w, float h);
+    float zoom() const { return zoom_level; }
+
+private:
+    float world_w, world_h;
+    float center_x, center_y;
+    float zoom_level{1.0f};
+
+    void clampCenter();
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include "render_commands.h"
+#include "sprites.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Программный растеризатор: исполняет список команд в RGBA-буфер в памяти.
+// Кадр делится на тайлы 64x64; команды раскладываются по тайлам, после чего
+// тайлы параллельно растеризуются пулом потоков (порядок команд внутри
+// тайла сохраняется, поэтому смешивание совпадает с оконным бэкендом).
+class CpuRasterBackend : public IRenderBackend {
+public:
+    static constexpr int TILE = 64;
+
+    // threads = 0 — по числу ядер
+    CpuRasterBackend(int width, int height, unsigned threads = 0);
+    ~CpuRasterBackend() override;
+
+    CpuRasterBackend(const CpuRasterBackend&) = delete;
+    CpuRasterBackend& operator=(const CpuRasterBackend&) = delete;
+
+    void setTexture(TextureId id, const PixelImage* image);
+    void execute(const RenderCommandList& list) override;
+
+    int width() const { return w; }
+    int height() const { return h; }
+    unsigned threadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Пиксели кадра, 0xRRGGBBAA, построчно
+    const std::uint32_t* pixels() const { return framebuffer.data(); }
+
+private:
+    int w, h;
+    int tiles_x, tiles_y;
+    std::vector<std::uint32_t> framebuffer;
+    std::vector<std::vector<std::uint32_t>> bins;  // индексы команд по тайлам
+    std::array<const PixelImage*, static_cast<std::size_t>(TextureId::Count)> textures{};
+    const RenderCommandList* current{nullptr};
+
+    // Пул потоков для тайлов
+    std::vector<std::thread> workers;
+    std::mutex pool_mtx;
+    std::condition_variable cv_start;
+    std::condition_variable cv_done;
+    std::uint64_t generation{0};
+    unsigned active{0};
+    bool stopping{false};
+    std::atomic<int> next_tile{0};
+
+    void workerLoop();
+    void runTiles();
+    void binCommands(const RenderCommandList& list);
+    void rasterTile(int tile);
+
+    void fillQuad(const RenderCommand& cmd, int x0, int y0, int x1, int y1);
+    void fillTexturedQuad(const RenderCommand& cmd, const PixelImage& tex, int x0, int y0, int x1, int y1);
+    void fillCircle(const RenderCommand& cmd, int x0, int y0, int x1, int y1);
+};
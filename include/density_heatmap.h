@@ -0,0 +1,32 @@
+#pragma once
+#include "spatial_index.h"
+#include "sprites.h"
+
+// Агрегированная карта плотности для сильного отдаления: один тексель на
+// клетку SnapshotGrid, цвет — преобладающий тип живых NPC, яркость — их число.
+// Обновляется инкрементально: переписываются только изменившиеся тексели,
+// а их ограничивающий прямоугольник отдаётся бэкенду для частичной загрузки.
+class DensityHeatmap {
+public:
+    struct DirtyRect {
+        int x{0}, y{0}, w{0}, h{0};
+        bool empty() const { return w <= 0 || h <= 0; }
+    };
+
+    void update(const SnapshotGrid& grid, const std::vector<NPCRenderState>& npcs);
+
+    const PixelImage& image() const { return img; }
+
+    // Изменившаяся область с прошлого вызова; сбрасывает её
+    DirtyRect takeDirty();
+
+    // Сколько текселей изменилось при последнем update()
+    std::size_t changedTexels() const { return changed; }
+
+private:
+    PixelImage img;
+    int dirty_x0{0}, dirty_y0{0}, dirty_x1{-1}, dirty_y1{-1};
+    std::size_t changed{0};
+
+    void markDirty(int x, int y);
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include "npc.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Типы визуальных эффектов
+enum class EffectType : std::uint8_t {
+    Kill,        // Взрыв частиц
+    Hurt,        // Жёлтая вспышка
+    Escape,      // Зелёные следы
+    Heal         // Голубое сияние
+};
+
+// Компактное событие взаимодействия: симуляция -> рендер (12 байт).
+// Ссылки целиком, с поколением: к кадру, в котором слот уже занят новым
+// NPC, событие не применяется (FrameSnapshot::find())
+struct EffectEvent {
+    NPCHandle actor;
+    NPCHandle target;
+    InteractionOutcome outcome{InteractionOutcome::NoInteraction};
+};
+
+// Один активный эффект (время — в миллисекундах рендер-часов)
+struct VisualEffect {
+    EffectType type;
+    float x, y;
+    std::uint32_t rgba;
+    std::int64_t start_ms;
+    std::int64_t end_ms;
+    bool active;
+
+    // Прогресс анимации (0.0 - 1.0)
+    float progress(std::int64_t now_ms) const {
+        float p = static_cast<float>(now_ms - start_ms) / static_cast<float>(end_ms - start_ms);
+        return p < 0.0f ? 0.0f : (p > 1.0f ? 1.0f : p);
+    }
+};
+
+// Хранилище эффектов с корзинами по времени окончания (колесо таймеров).
+// expire() просматривает только корзины, чьё время уже прошло, поэтому
+// стоимость пропорциональна числу истёкших эффектов, а не всех активных.
+// Используется только потоком рендера.
+class EffectStore {
+public:
+    static constexpr std::int64_t BUCKET_MS = 50;
+    static constexpr std::size_t BUCKETS = 64;  // горизонт 3.2 с
+
+    void add(EffectType type, float x, float y, float duration_ms, std::uint32_t rgba, std::int64_t now_ms);
+    void expire(std::int64_t now_ms);
+    void clear();
+
+    std::size_t size() const { return active_count; }
+
+    // Обход активных эффектов на месте, без копирования
+    template <typename Fn>
+    void forEach(std::int64_t now_ms, Fn&& fn) const {
+        for (const auto& e : effects)
+            if (e.active && e.end_ms > now_ms) fn(e);
+    }
+
+private:
+    std::vector<VisualEffect> effects;
+    std::vector<std::uint32_t> free_slots;
+    std::array<std::vector<std::uint32_t>, BUCKETS> buckets;
+    std::vector<std::uint32_t> scratch;
+    std::int64_t next_bucket{-1};  // первая ещё не обработанная корзина (в единицах BUCKET_MS)
+    std::size_t active_count{0};
+
+    void schedule(std::uint32_t index);
+};
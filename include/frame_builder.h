@@ -0,0 +1,104 @@
+#pragma once
+#include "bitmap_font.h"
+#include "camera.h"
+#include "density_heatmap.h"
+#include "frame_timing.h"
+#include "render_commands.h"
+#include "render_snapshot.h"
+#include "sim_clock.h"
+#include "spatial_index.h"
+#include "visual_observer.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Статистика последнего построенного кадра
+struct FrameBuildStats {
+    std::size_t sprites{0};
+    std::size_t corpses{0};
+    std::size_t culled{0};
+    std::size_t effects{0};
+    std::size_t particles{0};
+    std::size_t commands{0};
+    bool heatmap{false};  // кадр нарисован картой плотности вместо спрайтов
+};
+
+// Строит список команд кадра из снимка мира и состояния VisualObserver.
+// Не зависит от SFML, поэтому его стоимость можно измерять в headless-сборке.
+class FrameBuilder {
+public:
+    // Ниже этого масштаба (пикселей на единицу мира) спрайты сливаются —
+    // вместо них рисуется карта плотности
+    static constexpr float HEATMAP_SCALE = 4.0f;
+    // Размер клетки пространственного индекса и текселя карты плотности
+    static constexpr float INDEX_CELL = 2.0f;
+
+    FrameBuilder();
+
+    void build(const FrameSnapshot& snap,
+               VisualObserver& obs,
+               std::chrono::steady_clock::time_point now,
+               float width, float height,
+               const std::string& message,
+               RenderCommandList& out);
+
+    const FrameBuildStats& stats() const { return last_stats; }
+
+    // Интерполяция по времени симуляции; без часов — по настоящему времени
+    void setClock(const SimulationClock* clock) { sim_clock = clock; }
+
+    // Детализация эффектов и частиц, 1.0 — полная (задаётся FramePacer)
+    void setEffectQuality(float quality) { effect_quality = quality; }
+    float effectQuality() const { return effect_quality; }
+
+    // График времени кадра поверх уже построенного кадра (F3 в окне)
+    void emitTimingOverlay(RenderCommandList& out, const FrameTimer& timer, const FramePacer& pacer);
+
+    Camera& camera() { return cam; }
+    DensityHeatmap& heatmap() { return density; }
+    void setWorldSize(float w, float h);
+
+private:
+    FrameBuildStats last_stats;
+
+    float world_w, world_h;
+    Camera cam;
+
+    // Индекс и карта плотности перестраиваются только для нового снимка
+    SnapshotGrid grid;
+    DensityHeatmap density;
+    std::uint64_t indexed_version{0};
+    bool density_stale{true};
+    std::vector<std::uint32_t> visible_ids;  // переиспользуется между кадрами
+
+    // Кэш раскладки текста HUD
+    TextRun message_run;
+    TextRun stats_run;
+    int hud_alive{-1};
+    int hud_dead{-1};
+
+    float effect_quality{1.0f};
+    const SimulationClock* sim_clock = nullptr;
+    float hud_speed{1.0f};
+
+    // Подписи графика времени кадра обновляются несколько раз в секунду
+    TextRun timing_summary;
+    std::array<TextRun, FRAME_PHASE_COUNT> timing_phases;
+    std::uint32_t timing_frames{0};
+
+    void emitVisibleNPCs(RenderCommandList& out, const FrameSnapshot& snap, const Viewport& vp, float t, float width, float height);
+    void emitCorpse(RenderCommandList& out, const NPCRenderState& npc, float screen_x, float screen_y);
+    void emitNPC(RenderCommandList& out, const NPCRenderState& npc, float screen_x, float screen_y);
+    void emitHealthBar(RenderCommandList& out, float screen_x, float screen_y, int hp, int maxHp);
+    void emitEffects(RenderCommandList& out, const EffectStore& effects, std::int64_t now_ms, const Viewport& vp);
+    void emitParticles(RenderCommandList& out, const ParticlePool& pool, const Viewport& vp);
+    void emitHud(RenderCommandList& out, const std::string& message, int alive, int dead, float speed);
+
+    // Отрисовка конкретного эффекта
+    void emitKillEffect(RenderCommandList& out, float x, float y, float progress);
+    void emitHurtEffect(RenderCommandList& out, float x, float y, float progress);
+    void emitEscapeEffect(RenderCommandList& out, float x, float y, float progress);
+    void emitHealEffect(RenderCommandList& out, float x, float y, float progress);
+};
+
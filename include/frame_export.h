@@ -0,0 +1,59 @@
+#pragma once
+#include "cpu_raster.h"
+#include "frame_builder.h"
+#include "render_snapshot.h"
+#include "sprite_atlas.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+enum class ImageFormat {
+    PPM,
+    PNG
+};
+
+// Запись кадра 0xRRGGBBAA в файл (альфа отбрасывается)
+bool write_ppm(const std::string& path, int width, int height, const std::uint32_t* pixels);
+bool write_png(const std::string& path, int width, int height, const std::uint32_t* pixels);
+
+struct FrameExportConfig {
+    std::string directory;
+    int width{1920};
+    int height{1080};
+    double fps{10.0};            // кадров в секунду времени симуляции
+    ImageFormat format{ImageFormat::PNG};
+    unsigned threads{0};         // 0 — все ядра
+};
+
+// Выгрузка последовательности кадров без окна: снимок мира -> FrameBuilder ->
+// CpuRasterBackend -> frame_000000.png. Работает в отдельном потоке рядом
+// с симуляцией; run() возвращается, когда running становится false.
+class FrameExporter {
+public:
+    explicit FrameExporter(FrameExportConfig config);
+
+    void run(SnapshotPublisher& snapshots, const std::atomic<bool>& running);
+
+    // Интерполяция кадров по времени симуляции (--sim-speed)
+    void setClock(const SimulationClock* clock) { sim_clock = clock; }
+
+    // Сводка по времени построения, растеризации и записи
+    void printSummary() const;
+
+private:
+    FrameExportConfig cfg;
+    std::array<PixelImage, static_cast<std::size_t>(TextureId::Count)> images;
+
+    std::uint64_t frames{0};
+    double build_ms{0};
+    double raster_ms{0};
+    double write_ms{0};
+    unsigned raster_threads{0};
+    const SimulationClock* sim_clock = nullptr;
+
+    bool writeFrame(const CpuRasterBackend& raster, std::uint64_t index);
+};
+
+// Разбор "1920x1080"; false — строка не распознана
+bool parse_frame_size(const std::string& text, int& width, int& height);
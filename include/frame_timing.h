@@ -0,0 +1,108 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Фазы кадра окна в порядке выполнения. Idle — ожидание до следующего кадра
+// (пейсер), в «работу» кадра не входит.
+enum class FramePhase : std::uint8_t {
+    Events,
+    Snapshot,
+    Build,
+    Draw,
+    Display,
+    Idle,
+    Count
+};
+
+constexpr std::size_t FRAME_PHASE_COUNT = static_cast<std::size_t>(FramePhase::Count);
+
+const char* phase_name(FramePhase phase);
+
+// Длительности фаз одного кадра, мс
+struct FrameTiming {
+    std::array<float, FRAME_PHASE_COUNT> phase_ms{};
+    float total_ms{0};
+
+    float work_ms() const { return total_ms - phase_ms[static_cast<std::size_t>(FramePhase::Idle)]; }
+};
+
+// Скользящее окно последних кадров: кольцо замеров и гистограмма
+// длительностей, которая обновляется при добавлении и вытеснении кадра.
+// Не зависит от SFML.
+class FrameTimer {
+public:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t HISTORY = 120;
+    // Верхние границы корзин гистограммы, мс; последняя корзина — всё, что дольше
+    static constexpr std::array<float, 11> BUCKET_EDGES{1, 2, 4, 8, 12, 16.7f, 20, 25, 33.3f, 50, 100};
+    static constexpr std::size_t BUCKETS = BUCKET_EDGES.size() + 1;
+
+    void beginFrame(clock::time_point now);
+    // Время от предыдущей отметки засчитывается фазе phase
+    void mark(FramePhase phase, clock::time_point now);
+    void endFrame(clock::time_point now);
+    // Сколько прошло с начала текущего кадра
+    float elapsedMs(clock::time_point now) const;
+
+    // Последний завершённый кадр
+    const FrameTiming& last() const;
+    // age = 0 — последний кадр, HISTORY - 1 — самый старый
+    const FrameTiming& frame(std::size_t age) const;
+    std::size_t frames() const { return stored; }
+
+    const std::array<std::uint32_t, BUCKETS>& histogram() const { return buckets; }
+    static std::size_t bucketOf(float ms);
+
+    // Перцентиль полной длительности кадра по окну, p в [0, 1]
+    float percentile(float p) const;
+    // Средняя длительность фазы по окну
+    float average(FramePhase phase) const;
+
+private:
+    std::array<FrameTiming, HISTORY> ring{};
+    std::size_t head{0};  // куда запишется следующий кадр
+    std::size_t stored{0};
+    std::array<std::uint32_t, BUCKETS> buckets{};
+
+    FrameTiming current;
+    clock::time_point frame_start{};
+    clock::time_point last_mark{};
+
+    mutable std::vector<float> scratch;
+};
+
+// Адаптивный пейсер: держит целевую частоту кадров и понижает детализацию
+// эффектов и частиц, когда работа кадра не укладывается в бюджет.
+// Уровень меняется с гистерезисом, чтобы качество не «мигало».
+class FramePacer {
+public:
+    static constexpr int MAX_LEVEL = 3;
+
+    explicit FramePacer(double target_fps = 60.0);
+
+    void setTargetFps(double fps);
+    double targetFps() const { return target_fps; }
+    float budgetMs() const { return budget_ms; }
+
+    // Сколько ждать после работы кадра, чтобы не обогнать целевую частоту
+    std::chrono::microseconds idleTime(float work_ms) const;
+
+    // Учесть работу очередного кадра; true — уровень качества изменился
+    bool update(float work_ms);
+
+    int level() const { return quality_level; }  // 0 — полное качество
+    float quality() const;                       // 1.0 .. 0.15
+    float smoothedWorkMs() const { return work_avg; }
+
+private:
+    double target_fps;
+    float budget_ms;
+    float work_avg{0};
+    int quality_level{0};
+    int over_frames{0};
+    int under_frames{0};
+};
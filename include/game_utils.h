@@ -1,12 +1,16 @@
 #pragma once
 #include <vector>
-#include <queue>
 #include <memory>
 #include <string>
 #include <atomic>
 #include <condition_variable>
 #include <random>
+#include <functional>
+#include <array>
+#include <cstdint>
+#include <memory_resource>
 #include "npc.h"
+#include "npc_store.h"
 #include "bear.h"
 #include "dragon.h"
 #include "druid.h"
@@ -18,6 +22,7 @@ constexpr int MAP_X = 50;   // Уменьшено со 100 - теперь NPC б
 constexpr int MAP_Y = 50;   // Уменьшено со 100
 constexpr int GRID = 20;
 constexpr int CELL_SIZE = 5;  // Для 10x10 grid на 50x50 карте
+constexpr int MAX_DRAGONS = 1;
 
 // Custom hash для std::pair<int, int>
 struct PairHash {
@@ -36,8 +41,7 @@ private:
 
 public:
     static std::shared_ptr<IInteractionObserver> get();
-    void on_interaction(const std::shared_ptr<NPC> &actor,
-                  const std::shared_ptr<NPC> &target,
+    void on_interaction(const NPCStore &world, NPCHandle actor, NPCHandle target,
                   InteractionOutcome outcome) override;
 };
 
@@ -49,26 +53,36 @@ private:
 
 public:
     static std::shared_ptr<IInteractionObserver> get(const std::string& filename);
-    void on_interaction(const std::shared_ptr<NPC> &actor,
-                  const std::shared_ptr<NPC> &target,
+    void on_interaction(const NPCStore &world, NPCHandle actor, NPCHandle target,
                   InteractionOutcome outcome) override;
 };
 
 // ---------------- Логика боя ----------------
+class RandomSource;
+
+// Здоровье и жизнь участников визиторы читают через мир (NPCStore):
+// у ветвившегося мира они не в самих NPC
 struct AttackVisitor : public IInteractionVisitor {
-    explicit AttackVisitor(const std::shared_ptr<NPC> &actor_);
+    // Кубики из генератора мира (последовательный бой)
+    AttackVisitor(const NPC &actor_, const NPCStore& world_, RandomSource& random_);
+    // Кубики из собственного потока (splitmix64) вместо общего rng():
+    // для параллельного расчёта боя в двухфазном режиме
+    AttackVisitor(const NPC &actor_, const NPCStore& world_, std::uint64_t& dice_state_);
     InteractionOutcome visit([[maybe_unused]] Bear& target) override;
     InteractionOutcome visit([[maybe_unused]] Dragon& target) override;
     InteractionOutcome visit([[maybe_unused]] Druid& target) override;
     InteractionOutcome visit([[maybe_unused]] Orc& target) override;
     InteractionOutcome visit([[maybe_unused]] Squirrel& target) override;
 private:
-    std::shared_ptr<NPC> actor;
+    const NPC* actor;
+    const NPCStore* world;
+    RandomSource* random{nullptr};
+    std::uint64_t* dice_state{nullptr};
     bool dice();
 };
 
 struct SupportVisitor : public IInteractionVisitor {
-    explicit SupportVisitor(const std::shared_ptr<NPC>& actor_);
+    SupportVisitor(const NPC& actor_, const NPCStore& world_);
 
     InteractionOutcome visit(Bear&) override;
     InteractionOutcome visit(Dragon&) override;
@@ -77,44 +91,177 @@ struct SupportVisitor : public IInteractionVisitor {
     InteractionOutcome visit(Squirrel&) override;
 
 private:
-    std::shared_ptr<NPC> actor;
+    const NPC* actor;
+    const NPCStore* world;
 };
 
+// Пара на разрешение: две ссылки по 4 байта, без счётчиков shared_ptr
 struct InteractionEvent {
-    std::shared_ptr<NPC> actor;
-    std::shared_ptr<NPC> target;
+    NPCHandle actor;
+    NPCHandle target;
+};
+
+static_assert(sizeof(InteractionEvent) == 8, "InteractionEvent must stay two 32-bit handles");
+
+// Порядок разрешения боёв внутри тика
+enum class CombatMode {
+    Sequential,  // пары по очереди, каждая видит здоровье после предыдущих
+    TwoPhase     // все пары считаются от состояния на начало тика, затем одна фиксация
 };
 
+const char* combat_mode_name(CombatMode mode);
+
+// Разрешение взаимодействий внутри тика (TickScheduler): фаза обнаружения
+// кладёт пары, фаза разрешения разбирает их по порядку, фаза уведомлений
+// рассылает исходы наблюдателям. Своего потока у менеджера нет.
+// У каждого мира (WorldContext) свой менеджер; instance() — мир main.
 class InteractionManager {
 public:
+    InteractionManager();
     static InteractionManager& instance();
 
+    // Мир, по которому разыменовываются ссылки событий; задаётся до первого тика
+    void setStore(NPCStore* world) { store = world; }
+    // Генератор кубиков последовательного боя; по умолчанию default_random()
+    void setRandom(RandomSource* source) { random = source; }
+    // Память очередей тика (арена TickScheduler); nullptr — обычная куча.
+    // Менять только между тиками, когда очереди пусты.
+    void setArena(std::pmr::memory_resource* arena);
+    // Отдать пустые очереди арене перед её сбросом
+    void releaseTickStorage();
+
+    // Разметить очереди тика под events событий до их постановки
+    void reserve(std::size_t events);
     void push(InteractionEvent ev);
-    void apply_outcome(const std::shared_ptr<NPC>& actor,
-                   const std::shared_ptr<NPC>& target,
-                   InteractionOutcome outcome);
-    void operator()();
-    void stop();
+    std::size_t pending() const;
+
+    // Разобрать все накопленные события в порядке добавления;
+    // возвращает их число. Исходы копятся до notifyPending().
+    std::size_t resolvePending();
+    // Разослать исходы наблюдателям и разбудить рендер
+    std::size_t notifyPending();
+
+    // Двухфазный режим: beginCompute() готовит буферы под накопленные события
+    // и возвращает их число; computeRange() считает исходы событий [begin, end)
+    // без изменения NPC и может вызываться параллельно для разных диапазонов;
+    // commitComputed() суммирует урон и лечение по NPC и применяет их разом.
+    void setCombatMode(CombatMode mode) { combat_mode = mode; }
+    CombatMode combatMode() const { return combat_mode; }
+    std::size_t beginCompute(std::size_t npc_count, std::uint64_t seed);
+    void computeRange(std::size_t begin, std::size_t end);
+    std::size_t commitComputed();
+
+    void apply_outcome(NPC& actor, NPC& target, InteractionOutcome outcome);
     
-    std::mutex* getCVMtx() { return &cv_mtx; }
-    std::condition_variable* getEffectsCV() { return &effects_cv; }
+    ProfiledMutex* getCVMtx() { return &cv_mtx; }
+    ProfiledCondition* getEffectsCV() { return &effects_cv; }
 
 private:
-    InteractionManager() = default;
-    std::queue<InteractionEvent> queue;
-    std::mutex mtx;
-    std::atomic<bool> running{true};
-    std::condition_variable effects_cv;
-    std::mutex cv_mtx;  // Мьютекс для condition_variable (отдельный от global_npcs_mutex)
+    struct Notification {
+        NPCHandle actor;
+        NPCHandle target;
+        InteractionOutcome outcome;
+    };
+
+    // Исходы одного события: атака, контратака, лечение цели, лечение актёра
+    struct ComputedEvent {
+        std::array<InteractionOutcome, 4> outcomes;
+    };
+
+    // Накопитель фиксации для одного NPC
+    struct PendingDelta {
+        NPC* npc{nullptr};           // не nullptr — NPC уже в списке touched
+        int damage{0};
+        bool hit{false};
+        bool healed{false};
+        bool killed{false};
+        std::uint32_t first_hit{0};  // первый удар по порядку событий — ему засчитывается убийство
+    };
+
+    NPCStore* store{nullptr};
+    RandomSource* random;
+    std::pmr::vector<InteractionEvent> queue;  // события текущего тика, по порядку
+    // Задержка от постановки до применения меряется по выборке: время
+    // постановки запоминается для каждого LATENCY_SAMPLE-го события
+    static constexpr std::size_t LATENCY_SAMPLE = 64;
+    std::pmr::vector<std::int64_t> pushed_at;  // нс, для событий 0, LATENCY_SAMPLE, 2 * LATENCY_SAMPLE, ...
+    std::pmr::vector<Notification> notifications;
+
+    CombatMode combat_mode{CombatMode::Sequential};
+    std::uint64_t compute_seed{0};
+    std::pmr::vector<ComputedEvent> computed;
+    std::vector<PendingDelta> deltas;            // по NPC::id, живёт между тиками
+    std::pmr::vector<std::uint32_t> touched;     // id NPC с ненулевой дельтой
+
+    mutable ProfiledMutex mtx{"InteractionManager::mtx"};
+    ProfiledCondition effects_cv;
+    ProfiledMutex cv_mtx{"InteractionManager::cv_mtx"};  // Мьютекс для condition_variable (отдельный от apply_mtx)
+    ProfiledMutex apply_mtx{"InteractionManager::apply_mtx"};  // применение исходов к NPC мира
+
+    void resolve(const InteractionEvent& ev);
 };
 
 // ---------------- Вспомогательные функции ----------------
+// Общий мьютекс вывода в консоль: строки наблюдателей не перемешиваются
+extern ProfiledMutex print_mutex;
+
 void save_all(const std::vector<std::shared_ptr<NPC>> &list, const std::string &filename);
 std::vector<std::shared_ptr<NPC>> load_all(const std::string &filename);
 void print_all(const std::vector<std::shared_ptr<NPC>> &list);
 void print_survivors(const std::vector<std::shared_ptr<NPC>>& npcs);
 void draw_map(const std::vector<std::shared_ptr<NPC>>& list);
+
+// Генераторы одного мира: тип и координаты новых NPC, кубики
+// последовательного боя. Миры с разными RandomSource не делят случайность.
+class RandomSource {
+public:
+    RandomSource();  // каждый генератор — от std::random_device
+    explicit RandomSource(std::uint64_t seed);
+
+    // Пересеять все генераторы от одного зерна: после этого создание
+    // мира и бой повторяются от запуска к запуску
+    void seed(std::uint64_t seed);
+
+    NPCType type();
+    int coord(int min, int max);
+    int roll();  // d6
+    std::mt19937& engine() { return gen; }
+
+private:
+    std::mt19937 type_gen, coord_gen, gen;
+};
+
+// Генераторы мира main; функции ниже работают с ними
+RandomSource& default_random();
 NPCType random_type();
 int random_coord(int min, int max);
 std::mt19937& rng();
-int roll();
\ No newline at end of file
+int roll();
+void seed_random(std::uint64_t seed);
+
+// Случайные NPC для стартовой популяции и подкреплений: не больше
+// max_dragons драконов, имена «Тип_номер» по порядку создания
+class NPCFactory {
+public:
+    explicit NPCFactory(RandomSource& random = default_random(), int max_dragons = MAX_DRAGONS)
+        : random(&random), max_dragons(max_dragons) {}
+    // Та же нумерация и счёт драконов, но свой генератор (ветка мира)
+    NPCFactory(const NPCFactory& other, RandomSource& random)
+        : random(&random), max_dragons(other.max_dragons), dragons(other.dragons), number(other.number) {}
+    std::shared_ptr<NPC> make();
+
+private:
+    RandomSource* random;
+    int max_dragons;
+    int dragons{0};
+    int number{0};
+};
+
+// SplitMix64: дешёвый генератор для независимых потоков случайных чисел
+// (куски фаз тика, события двухфазного боя)
+inline std::uint64_t splitmix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "memory_tracker.h"
+#include "profiled_mutex.h"
+
+// Счётчик незавершённых задач группы. Ожидание группы — барьер фазы:
+// ждущий поток не спит, а выполняет задачи из очередей.
+class TaskGroup {
+public:
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<std::uint32_t> pending{0};
+};
+
+// Пул потоков с перехватом работы (work stealing). У каждого рабочего
+// своя очередь: владелец берёт задачи с конца (LIFO, горячий кэш), а
+// простаивающие потоки забирают их с начала чужих очередей.
+class JobSystem {
+public:
+    // threads — число потоков вместе с вызывающим; 0 — по числу ядер.
+    // При одном потоке всё выполняется прямо в wait().
+    explicit JobSystem(unsigned threads = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned threadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    void spawn(TaskGroup& group, std::function<void()> job);
+    // Вернуться, когда все задачи группы выполнены; пока ждём — помогаем
+    void wait(TaskGroup& group);
+
+    // fn(begin, end) для кусков [0, count) по grain элементов; возвращается
+    // после последнего куска. Разбиение зависит только от count и grain,
+    // поэтому результат по кускам не зависит от числа потоков.
+    // Куски ставятся в очередь как указатель на функцию и контекст, без
+    // std::function: в установившемся режиме постановка не трогает кучу.
+    template <typename Fn>
+    void parallelFor(std::size_t count, std::size_t grain, Fn&& fn) {
+        if (count == 0) return;
+        grain = grain ? grain : 1;
+        if (count <= grain || workers.empty()) {
+            for (std::size_t begin = 0; begin < count; begin += grain)
+                fn(begin, std::min(count, begin + grain));
+            return;
+        }
+        using Body = std::remove_reference_t<Fn>;
+        auto invoke = [](void* ctx, std::size_t begin, std::size_t end) {
+            (*static_cast<Body*>(ctx))(begin, end);
+        };
+        TaskGroup group;
+        for (std::size_t begin = 0; begin < count; begin += grain)
+            spawnRange(group, invoke, const_cast<void*>(static_cast<const void*>(&fn)),
+                       begin, std::min(count, begin + grain));
+        wait(group);
+    }
+
+    // Сколько задач выполнено чужими потоками (для отчёта о балансировке)
+    std::uint64_t stolenJobs() const { return stolen.load(std::memory_order_relaxed); }
+
+private:
+    using RangeFn = void (*)(void*, std::size_t, std::size_t);
+
+    struct Job {
+        std::function<void()> fn;     // spawn()
+        RangeFn range{nullptr};       // parallelFor(): range(ctx, begin, end)
+        void* ctx{nullptr};
+        std::size_t begin{0}, end{0};
+        TaskGroup* group{nullptr};
+        MemSubsystem subsystem{MemSubsystem::Other};  // учёт памяти ставившего потока
+    };
+
+    // Кольцевой буфер задач: растёт удвоением до пика, дальше без аллокаций.
+    // Владелец берёт с конца, воры — с начала.
+    struct WorkQueue {
+        ProfiledMutex mtx{"JobSystem::WorkQueue::mtx"};
+        std::vector<Job> ring{std::vector<Job>(64)};
+        std::size_t head{0};   // первая задача
+        std::size_t count{0};
+
+        void pushBack(Job&& job);
+        bool popBack(Job& job);
+        bool popFront(Job& job);
+    };
+
+    // queues[0] — очередь внешних потоков, queues[i + 1] — рабочего i
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::atomic<bool> stopping{false};
+    std::atomic<std::uint32_t> queued{0};
+    std::atomic<std::uint64_t> stolen{0};
+    ProfiledMutex sleep_mtx{"JobSystem::sleep_mtx"};
+    ProfiledCondition wake;
+
+    void spawnRange(TaskGroup& group, RangeFn fn, void* ctx, std::size_t begin, std::size_t end);
+    void enqueue(Job&& job);
+    void workerLoop(std::size_t index);
+    bool tryRun(std::size_t own);
+    bool popOwn(std::size_t own, Job& job);
+    bool steal(std::size_t thief, Job& job);
+    void execute(Job& job);
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include "game_utils.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Детерминированный прогон: все генераторы пересеяны от seed, число тиков
+// фиксировано, время стены не влияет ни на что, кроме скорости. Прогон с теми
+// же параметрами через основной цикл (--seed, --ticks) даёт те же хэши.
+struct LockstepSetup {
+    std::uint64_t seed{1};
+    std::uint64_t ticks{200};
+    int npcs{50};
+    double spawn_rate{0};  // подкреплений в секунду времени симуляции
+};
+
+// Конфигурация одной стороны сравнения: «THREADS» или «THREADS:two-phase»
+struct LockstepConfig {
+    unsigned threads{1};
+    CombatMode combat{CombatMode::Sequential};
+};
+
+bool parse_lockstep_config(const std::string& text, CombatMode default_combat, LockstepConfig& out);
+
+// Хэши мира после каждого тика
+std::vector<std::uint64_t> run_lockstep(const LockstepSetup& setup, const LockstepConfig& config);
+
+// Два прогона с одинаковым зерном; печатает первый расходящийся тик.
+// true — хэши совпали на всех тиках
+bool check_lockstep(const LockstepSetup& setup, const LockstepConfig& a, const LockstepConfig& b);
+
+// Проверка «тик без кучи» (сборка с PIXELRPG_TRACK_ALLOCATIONS): мир из
+// setup, warmup тиков на разогрев арены и буферов, затем setup.ticks тиков,
+// в каждом из которых TickStats::allocations должно быть нулём. Печатает
+// тики с выделениями; true — таких нет. Без учёта выделений — всегда false.
+bool check_steady_allocations(const LockstepSetup& setup, const LockstepConfig& config, std::uint64_t warmup);
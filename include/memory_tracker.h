@@ -0,0 +1,60 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Учёт памяти по подсистемам. При сборке с PIXELRPG_TRACK_ALLOCATIONS
+// глобальные operator new/delete считают каждое выделение и относят его
+// к подсистеме, активной в потоке (MemoryScope). Без опции все вызовы
+// пустые, а memory_snapshot() возвращает нули.
+enum class MemSubsystem : std::uint8_t {
+    Other,
+    World,         // NPC и NPCStore
+    Grid,          // индекс клеток и поиск пар
+    Interactions,  // очередь и разрешение боёв
+    Observers,     // рассылка исходов
+    Logs,          // консольный и файловый журналы
+    Snapshots,     // снимки для рендера
+    Effects,       // эффекты и частицы
+    Count
+};
+
+constexpr std::size_t MEM_SUBSYSTEM_COUNT = static_cast<std::size_t>(MemSubsystem::Count);
+
+const char* mem_subsystem_name(MemSubsystem subsystem);
+
+struct MemCounters {
+    std::uint64_t allocations{0};
+    std::uint64_t frees{0};
+    std::int64_t live_bytes{0};
+    std::int64_t peak_bytes{0};
+};
+
+using MemSnapshot = std::array<MemCounters, MEM_SUBSYSTEM_COUNT>;
+
+// Счётчики собраны в сборке (PIXELRPG_TRACK_ALLOCATIONS)
+bool memory_tracking_enabled();
+MemSnapshot memory_snapshot();
+// Сумма выделений по всем подсистемам
+std::uint64_t memory_total_allocations();
+
+// Подсистема текущего потока; JobSystem переносит её в задачи
+MemSubsystem memory_scope_current();
+void memory_scope_set(MemSubsystem subsystem);
+
+// Выделения внутри области относятся к subsystem; вложенные области
+// восстанавливают внешнюю при выходе
+class MemoryScope {
+public:
+    explicit MemoryScope(MemSubsystem subsystem) : saved(memory_scope_current()) { memory_scope_set(subsystem); }
+    ~MemoryScope() { memory_scope_set(saved); }
+
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+private:
+    MemSubsystem saved;
+};
+
+// Таблица по подсистемам: выделения, живые байты, пик
+void print_memory_report(std::size_t npc_count);
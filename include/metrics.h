@@ -0,0 +1,165 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Реестр метрик для наблюдения за долгими прогонами. Запись — без блокировок:
+// каждый поток пишет в свой шард (атомики на отдельных линиях кэша), шарды
+// складываются только при чтении. Регистрация — под мьютексом, при старте.
+
+constexpr std::size_t METRIC_SHARDS = 16;
+
+// Шард текущего потока; потоков больше, чем шардов, — шарды делятся,
+// атомарное сложение остаётся корректным
+inline std::size_t metric_shard() {
+    static std::atomic<std::size_t> next{0};
+    thread_local const std::size_t shard = next.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+// Монотонное время для метрик, нс
+inline std::int64_t metrics_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class Counter {
+public:
+    void add(std::uint64_t n = 1) { shards[metric_shard()].value.fetch_add(n, std::memory_order_relaxed); }
+    std::uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<std::uint64_t> value{0};
+    };
+    std::array<Shard, METRIC_SHARDS> shards;
+};
+
+// Последнее записанное значение (глубина очереди, число NPC)
+class Gauge {
+public:
+    void set(std::int64_t v) { current.store(v, std::memory_order_relaxed); }
+    std::int64_t value() const { return current.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::int64_t> current{0};
+};
+
+// Лог-линейная гистограмма в духе HDR: 8 корзин на каждую степень двойки,
+// относительная ошибка не больше 12.5% во всём диапазоне uint64
+class Histogram {
+public:
+    static constexpr unsigned SUB_BITS = 3;
+    static constexpr std::size_t SUB = std::size_t{1} << SUB_BITS;
+    static constexpr std::size_t BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+    static std::size_t bucketOf(std::uint64_t v) {
+        if (v < SUB) return static_cast<std::size_t>(v);
+        const unsigned e = static_cast<unsigned>(std::bit_width(v)) - 1;
+        return (e - SUB_BITS + 1) * SUB + ((v >> (e - SUB_BITS)) & (SUB - 1));
+    }
+    // Нижняя граница корзины и её ширина
+    static std::uint64_t bucketLow(std::size_t b);
+    static std::uint64_t bucketWidth(std::size_t b) { return b < SUB ? 1 : std::uint64_t{1} << (b / SUB - 1); }
+
+    void record(std::uint64_t v) {
+        Shard& s = shards[metric_shard()];
+        s.buckets[bucketOf(v)].fetch_add(1, std::memory_order_relaxed);
+        s.count.fetch_add(1, std::memory_order_relaxed);
+        s.sum.fetch_add(v, std::memory_order_relaxed);
+    }
+
+    // Сумма шардов на момент чтения
+    struct Snapshot {
+        std::array<std::uint64_t, BUCKETS> buckets{};
+        std::uint64_t count{0};
+        std::uint64_t sum{0};
+
+        // Верхняя граница корзины, в которую попал перцентиль p в [0, 1]
+        std::uint64_t percentile(double p) const;
+    };
+    Snapshot snapshot() const;
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<std::uint64_t>, BUCKETS> buckets{};
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> sum{0};
+    };
+    std::array<Shard, METRIC_SHARDS> shards;
+};
+
+// Метрики по имени и меткам. Ссылки на метрики стабильны до конца
+// программы, поэтому горячий путь берёт их один раз и хранит.
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance();
+
+    // labels — готовая строка меток Prometheus без скобок: phase="move".
+    // Повторный вызов с тем же именем и метками возвращает ту же метрику.
+    Counter& counter(const std::string& name, const std::string& help, const std::string& labels = {});
+    Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = {});
+    // scale переводит записанные значения в единицы экспорта (нс -> с: 1e-9)
+    Histogram& histogram(const std::string& name, const std::string& help, double scale = 1.0,
+                         const std::string& labels = {});
+
+    // Текстовый формат Prometheus; учёт памяти (PIXELRPG_TRACK_ALLOCATIONS)
+    // добавляется, если он собран
+    void writePrometheus(std::ostream& out) const;
+
+private:
+    enum class Kind : std::uint8_t { Counter, Gauge, Histogram };
+
+    struct Entry {
+        Kind kind;
+        std::string name;
+        std::string help;
+        std::string labels;
+        double scale{1.0};
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    MetricsRegistry() = default;
+    Entry& find(Kind kind, const std::string& name, const std::string& help, const std::string& labels);
+
+    mutable std::mutex mtx;
+    std::deque<Entry> entries;
+};
+
+// Периодическая выгрузка реестра в файл (например, для textfile-коллектора
+// node_exporter). Файл заменяется целиком через переименование, поэтому
+// читатель никогда не видит половину выгрузки.
+class MetricsFileExporter {
+public:
+    MetricsFileExporter(std::string path, double interval_s);
+    ~MetricsFileExporter();
+
+    MetricsFileExporter(const MetricsFileExporter&) = delete;
+    MetricsFileExporter& operator=(const MetricsFileExporter&) = delete;
+
+    // Записать немедленно; false — не удалось открыть или заменить файл
+    bool writeNow();
+    std::uint64_t writes() const { return written; }
+
+private:
+    std::string path;
+    std::chrono::duration<double> interval;
+    std::uint64_t written{0};
+
+    std::mutex mtx;
+    std::condition_variable wake;
+    bool stopping{false};
+    std::thread worker;
+};
@@ -5,8 +5,13 @@
 #include <iostream>
 #include <shared_mutex>
 #include <chrono>
+#include <cstdint>
+#include <mutex>
+#include "npc_handle.h"
+#include "profiled_mutex.h"
 
 struct NPC;
+class NPCStore;
 
 struct Bear;
 struct Dragon;
@@ -41,15 +46,20 @@ struct IInteractionVisitor {
     virtual ~IInteractionVisitor() = default;
 };
 
+// Наблюдатель получает ссылки на участников; имена и позиции при
+// необходимости читаются через world (участник может быть уже мёртв)
 struct IInteractionObserver {
-    virtual void on_interaction(const std::shared_ptr<NPC> &actor,
-                          const std::shared_ptr<NPC> &target,
+    virtual void on_interaction(const NPCStore &world,
+                          NPCHandle actor,
+                          NPCHandle target,
                           InteractionOutcome outcome) = 0;
     virtual ~IInteractionObserver() = default;
 };
 
 struct NPC : public std::enable_shared_from_this<NPC> {
-    mutable std::mutex mtx;
+    mutable ProfiledMutex mtx{"NPC::mtx"};
+    std::uint32_t id{0};  // Слот в NPCStore; позиция в списке мира может меняться
+    std::uint8_t generation{0};  // Поколение слота id, см. NPCHandle
     NPCType type{NPCType::Unknown};
     std::string name;
     int x{0};
@@ -72,14 +82,17 @@ struct NPC : public std::enable_shared_from_this<NPC> {
     virtual InteractionOutcome accept(IInteractionVisitor &visitor) = 0;
 
     void subscribe(const std::shared_ptr<IInteractionObserver> &obs);
-    void notify_interaction(const std::shared_ptr<NPC> &target, InteractionOutcome outcome);
+    void notify_interaction(const NPCStore &world, NPCHandle target, InteractionOutcome outcome);
+    NPCHandle handle() const { return NPCHandle::make(id, generation); }
 
     virtual void save(std::ostream &os) const;
     virtual void print(std::ostream &os) const;
 
     bool is_close(const std::shared_ptr<NPC> &other, int distance) const;
-    int get_distance_to(const std::shared_ptr<NPC> &other) const;
+    int get_distance_to(const NPC &other) const;
     void move(int shift_x, int shift_y, int max_x, int max_y);
+    // Запись позиции, уже посчитанной снаружи (ядро движения TickScheduler)
+    void move_to(int new_x, int new_y, std::chrono::steady_clock::time_point when);
 
     bool is_alive() const;
     void must_die();
@@ -98,7 +111,13 @@ struct NPC : public std::enable_shared_from_this<NPC> {
     int get_current_health() const;
 };
 
-std::string type_to_string(NPCType t);
+// Статическая строка: в журналах не создаёт временных std::string
+std::string_view type_to_string(NPCType t);
+// Короткое имя исхода для меток метрик
+const char* outcome_name(InteractionOutcome outcome);
 
 std::shared_ptr<NPC> createNPC(NPCType type, const std::string &name, int x, int y);
-std::shared_ptr<NPC> createNPCFromStream(std::istream &is);
\ No newline at end of file
+std::shared_ptr<NPC> createNPCFromStream(std::istream &is);
+// Копия NPC с тем же слотом, состоянием и (если keep_observers) наблюдателями —
+// ветка мира заменяет ею унаследованный NPC перед записью в объект (NPCStore::copyInherited)
+std::shared_ptr<NPC> cloneNPC(const NPC &src, bool keep_observers = true);
\ No newline at end of file
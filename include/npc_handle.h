@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+
+// Ссылка на NPC в мире: 24 бита индекса в списке мира и 8 бит поколения.
+// Копируется без атомарных счётчиков; разыменовывается через NPCStore,
+// который отвергает ссылку, если слот уже занят другим NPC.
+struct NPCHandle {
+    static constexpr std::uint32_t INDEX_BITS = 24;
+    static constexpr std::uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr std::uint32_t INVALID = 0xFFFFFFFFu;
+    // Слотов в мире не больше: индекс INDEX_MASK с поколением 255 совпал бы с INVALID
+    static constexpr std::uint32_t MAX_SLOTS = INDEX_MASK;
+
+    std::uint32_t bits{INVALID};
+
+    static constexpr NPCHandle make(std::uint32_t index, std::uint8_t generation) {
+        return NPCHandle{(static_cast<std::uint32_t>(generation) << INDEX_BITS) | (index & INDEX_MASK)};
+    }
+
+    constexpr std::uint32_t index() const { return bits & INDEX_MASK; }
+    constexpr std::uint8_t generation() const { return static_cast<std::uint8_t>(bits >> INDEX_BITS); }
+    constexpr bool valid() const { return bits != INVALID; }
+
+    constexpr bool operator==(const NPCHandle&) const = default;
+};
+
+static_assert(sizeof(NPCHandle) == 4, "NPCHandle must stay 32-bit");
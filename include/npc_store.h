@@ -0,0 +1,146 @@
+#pragma once
+#include "npc.h"
+#include "npc_handle.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Мир как плотный список живых (и только что погибших) NPC плюс таблица
+// слотов. NPC::id — номер слота: он не меняется, когда NPC переезжает в
+// списке при удалении соседей, поэтому NPCHandle остаются верными.
+// Удалённый слот уходит в список свободных с новым поколением, и старые
+// ссылки на него перестают разыменовываться.
+//
+// Изменяемое состояние NPC (позиция, здоровье, жизнь) тик читает и пишет
+// через хранилище. Пока мир не ветвился, оно лежит в самих NPC.
+//
+// Ветвление (fork): ветка получает свой список и таблицу слотов, а объекты
+// NPC (тип, имя, слот, наблюдатели) остаются общими с родителем и больше не
+// меняются. Изменяемое состояние родитель при первом ветвлении один раз
+// упаковывает в массивы по кускам из CHUNK_SLOTS слотов. Куски общие для
+// всех миров, которые их делят. Перед записью мир копирует себе только
+// массивы куска (copyChunk), а не NPC — обе стороны работают по правилу
+// copy-on-write. Снимок рендера читает поля самих NPC, поэтому ветвившийся
+// мир не рисуется.
+class NPCStore {
+public:
+    static constexpr std::size_t CHUNK_SLOTS = 256;
+
+    // Регистрирует NPC, уже лежащих в списке: слот i — i-й элемент
+    explicit NPCStore(std::vector<std::shared_ptr<NPC>>& npcs);
+    // Ветка parent: npcs (пустой) заполняется ссылками на NPC родителя,
+    // слоты и поколения копируются, куски состояния делятся. Наблюдатели
+    // унаследованных NPC — наблюдатели родителя, ветка их не вызывает
+    // (inherited); свои ветка подписывает через WorldContext::subscribe
+    NPCStore(std::vector<std::shared_ptr<NPC>>& npcs, NPCStore& parent);
+
+    // nullptr, если слот свободен или занят другим поколением.
+    // Погибшие NPC доступны до удаления из списка (remove()).
+    NPC* get(NPCHandle handle) const {
+        const std::uint32_t index = handle.index();
+        if (!handle.valid() || index >= slots.size()) return nullptr;
+        const Slot& slot = slots[index];
+        if (slot.dense == FREE || slot.generation != handle.generation()) return nullptr;
+        return npcs[slot.dense].get();
+    }
+
+    // Ссылка на элемент списка с позицией index
+    NPCHandle handle(std::size_t index) const { return npcs[index]->handle(); }
+
+    // Добавить NPC в конец списка, заняв свободный слот (или новый).
+    // std::length_error, если свободных нет и слотов уже NPCHandle::MAX_SLOTS:
+    // старший индекс не влез бы в ссылку и совпал бы с чужим слотом
+    NPCHandle spawn(std::shared_ptr<NPC> npc);
+    // Убрать элемент index: на его место встаёт последний элемент списка
+    void remove(std::size_t index);
+
+    std::vector<std::shared_ptr<NPC>>& list() { return npcs; }
+    const std::vector<std::shared_ptr<NPC>>& list() const { return npcs; }
+    std::size_t size() const { return npcs.size(); }
+    // Верхняя граница NPC::id — для буферов, индексируемых слотом
+    std::size_t capacity() const { return slots.size(); }
+    // Сколько NPC удалено из списка за всё время
+    std::uint64_t removed() const { return removed_count; }
+
+    // Состояние NPC этого мира. Запись — из одного потока либо в разные
+    // куски; общий кусок копируется при первой записи
+    bool isAlive(const NPC& npc) const {
+        if (!packed) return npc.is_alive();
+        return stateOf(npc.id).alive[npc.id % CHUNK_SLOTS] != 0;
+    }
+    int health(const NPC& npc) const {
+        if (!packed) return npc.get_current_health();
+        return stateOf(npc.id).health[npc.id % CHUNK_SLOTS];
+    }
+    std::pair<int, int> position(const NPC& npc) const;
+    // Как NPC::get_state: false (и x, y не трогаются), если NPC мёртв
+    bool getState(const NPC& npc, int& x, int& y) const;
+    // Как NPC::get_distance_to
+    int distance(const NPC& a, const NPC& b) const;
+    void moveTo(NPC& npc, int x, int y, std::chrono::steady_clock::time_point when) {
+        if (!packed) {
+            npc.move_to(x, y, when);
+            return;
+        }
+        ChunkState& state = writableState(npc.id);
+        state.x[npc.id % CHUNK_SLOTS] = x;
+        state.y[npc.id % CHUNK_SLOTS] = y;
+    }
+    // Новое здоровье; при value <= 0 — 0, и NPC погибает. false — NPC мёртв
+    bool setHealth(NPC& npc, int value);
+
+    // Объект NPC получен от родителя при ветвлении и общий с ним
+    bool inherited(const NPC& npc) const { return slots[npc.id].inherited; }
+    // Заменить унаследованные NPC своими копиями без наблюдателей
+    // (перед записью в сами объекты, см. WorldContext::subscribe)
+    void copyInherited();
+
+    // Есть ли куски состояния, общие с другим миром
+    bool sharesState() const { return sharing; }
+    std::size_t chunkCount() const { return chunks.size(); }
+    bool chunkShared(std::size_t chunk) const;
+    // Скопировать массивы куска себе, если кусок общий (и, при live_only, в
+    // нём есть живые — только их меняет тик). Для разных кусков можно
+    // вызывать параллельно. true — кусок скопирован
+    bool copyChunk(std::size_t chunk, bool live_only = true);
+    // Сбросить sharesState(), если общих кусков не осталось
+    void refreshSharing();
+    std::uint64_t copiedChunks() const { return copied_chunks.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::uint32_t FREE = 0xFFFFFFFFu;
+
+    struct Slot {
+        std::uint32_t dense{FREE};  // позиция в npcs
+        std::uint8_t generation{0};
+        bool inherited{false};      // NPC слота — объект родителя (в паддинге, размер тот же)
+    };
+
+    // Упакованное состояние куска слотов; пока use_count() > 1, его делит ещё кто-то
+    struct ChunkState {
+        std::array<std::int32_t, CHUNK_SLOTS> x{};
+        std::array<std::int32_t, CHUNK_SLOTS> y{};
+        std::array<std::int32_t, CHUNK_SLOTS> health{};
+        std::array<std::uint8_t, CHUNK_SLOTS> alive{};
+    };
+
+    std::vector<std::shared_ptr<NPC>>& npcs;
+    std::vector<Slot> slots;
+    std::vector<std::uint32_t> free_slots;
+    std::uint64_t removed_count{0};
+
+    bool packed{false};  // состояние в chunks, а не в NPC
+    std::vector<std::shared_ptr<ChunkState>> chunks;
+    bool sharing{false};
+    std::atomic<std::uint64_t> copied_chunks{0};
+
+    const ChunkState& stateOf(std::uint32_t slot) const { return *chunks[slot / CHUNK_SLOTS]; }
+    ChunkState& writableState(std::uint32_t slot);
+    // Перенести состояние NPC в куски (первое ветвление)
+    void pack();
+    void trackChunks();
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Пул частиц фиксированной ёмкости.
+// Каждое поле хранится отдельным массивом (SoA), поэтому интеграция
+// в update() компилируется в векторные инструкции, а удаление мёртвых
+// частиц — это swap-remove без сдвига остальных.
+class ParticlePool {
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 8192;
+    static constexpr std::size_t DEFAULT_FRAME_BUDGET = 512;
+
+    explicit ParticlePool(std::size_t capacity = DEFAULT_CAPACITY);
+
+    // Сколько новых частиц разрешено породить за один кадр
+    void setFrameBudget(std::size_t budget);
+    std::size_t frameBudget() const { return frame_budget; }
+
+    // Породить до count частиц; возвращает, сколько реально создано.
+    // При исчерпании бюджета или заполнении пула количество плавно уменьшается.
+    std::size_t spawn(float x, float y, int count, std::uint32_t rgba, float lifetime = 0.5f);
+
+    // Шаг интеграции + удаление погибших частиц; открывает новый кадр бюджета
+    void update(float dt);
+
+    void clear();
+
+    std::size_t size() const { return count; }
+    std::size_t capacity() const { return cap; }
+    bool empty() const { return count == 0; }
+
+    // Прямой доступ к массивам для построения вершинного буфера
+    const float* xs() const { return x.data(); }
+    const float* ys() const { return y.data(); }
+    const float* lifetimes() const { return life.data(); }
+    const float* invMaxLifetimes() const { return inv_max_life.data(); }
+    const std::uint32_t* colors() const { return rgba.data(); }
+
+    // Прозрачность частицы i (1.0 — только родилась, 0.0 — умирает)
+    float alpha(std::size_t i) const { return life[i] * inv_max_life[i]; }
+
+private:
+    std::size_t cap;
+    std::size_t count{0};
+    std::size_t frame_budget{DEFAULT_FRAME_BUDGET};
+    std::size_t spawned_this_frame{0};
+
+    std::vector<float> x, y;
+    std::vector<float> vx, vy;
+    std::vector<float> life, inv_max_life;
+    std::vector<std::uint32_t> rgba;
+
+    std::uint32_t rng_state{0x9E3779B9u};
+    float nextUnit();  // [0, 1)
+
+    void removeAt(std::size_t i);
+};
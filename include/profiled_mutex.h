@@ -0,0 +1,96 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Мьютекс с профилированием конкуренции. При сборке с PIXELRPG_PROFILE_LOCKS
+// каждое место блокировки (имя в конструкторе) копит число захватов, число
+// захватов с ожиданием и гистограммы ожидания и удержания; отчёт — в
+// print_lock_report() и в реестре метрик. Без опции ProfiledMutex — это
+// std::mutex, а имя места отбрасывается при компиляции.
+//
+// С условной переменной использовать ProfiledCondition и
+// std::unique_lock<ProfiledMutex>.
+
+#ifdef PIXELRPG_PROFILE_LOCKS
+
+struct LockSite;
+
+class ProfiledMutex {
+public:
+    explicit ProfiledMutex(const char* site_name);
+
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    void lock();
+    bool try_lock();
+    void unlock();
+
+private:
+    std::mutex m;
+    LockSite* site;
+    std::int64_t locked_at{0};  // пишет только владелец
+};
+
+// Обычная std::condition_variable принимает только std::unique_lock<std::mutex>
+using ProfiledCondition = std::condition_variable_any;
+
+#else
+
+class ProfiledMutex : public std::mutex {
+public:
+    explicit constexpr ProfiledMutex(const char*) noexcept {}
+};
+
+// std::condition_variable над ProfiledMutex: замок на время ожидания
+// перекладывается в std::unique_lock<std::mutex> и обратно, без накладных расходов
+class ProfiledCondition {
+public:
+    void notify_one() noexcept { cv.notify_one(); }
+    void notify_all() noexcept { cv.notify_all(); }
+
+    template <typename Predicate>
+    void wait(std::unique_lock<ProfiledMutex>& lock, Predicate pred) {
+        std::unique_lock<std::mutex> inner = adopt(lock);
+        cv.wait(inner, std::move(pred));
+        restore(lock, inner);
+    }
+
+    template <typename Rep, typename Period>
+    std::cv_status wait_for(std::unique_lock<ProfiledMutex>& lock, const std::chrono::duration<Rep, Period>& rel) {
+        std::unique_lock<std::mutex> inner = adopt(lock);
+        const std::cv_status status = cv.wait_for(inner, rel);
+        restore(lock, inner);
+        return status;
+    }
+
+    template <typename Clock, typename Duration, typename Predicate>
+    bool wait_until(std::unique_lock<ProfiledMutex>& lock, const std::chrono::time_point<Clock, Duration>& deadline,
+                    Predicate pred) {
+        std::unique_lock<std::mutex> inner = adopt(lock);
+        const bool result = cv.wait_until(inner, deadline, std::move(pred));
+        restore(lock, inner);
+        return result;
+    }
+
+private:
+    std::condition_variable cv;
+
+    static std::unique_lock<std::mutex> adopt(std::unique_lock<ProfiledMutex>& lock) {
+        return std::unique_lock<std::mutex>(*lock.release(), std::adopt_lock);
+    }
+    static void restore(std::unique_lock<ProfiledMutex>& lock, std::unique_lock<std::mutex>& inner) {
+        lock = std::unique_lock<ProfiledMutex>(static_cast<ProfiledMutex&>(*inner.release()), std::adopt_lock);
+    }
+};
+
+#endif
+
+// Собрано ли профилирование (PIXELRPG_PROFILE_LOCKS)
+bool lock_profiling_enabled();
+
+// Места блокировок по суммарному ожиданию: захваты, доля с ожиданием,
+// ожидание и удержание (сумма и p99)
+void print_lock_report();
@@ -0,0 +1,8 @@
+#pragma once
+
+// Замер стоимости построения кадра (снимок -> эффекты -> список команд)
+// без окна и GPU: команды исполняются NullRenderBackend.
+// Возвращает код завершения для main().
+// zoom — масштаб камеры (1 — весь мир; меньше FrameBuilder::HEATMAP_SCALE
+// в пересчёте на пиксели — режим карты плотности).
+int run_render_benchmark(int frames, int npc_count, float zoom = 1.0f);
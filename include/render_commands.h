@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Цвет в формате 0xRRGGBBAA (совпадает с sf::Color::toInteger)
+constexpr std::uint32_t rgba(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a = 255) {
+    return (std::uint32_t(r) << 24) | (std::uint32_t(g) << 16) | (std::uint32_t(b) << 8) | a;
+}
+
+constexpr std::uint32_t with_alpha(std::uint32_t color, std::uint8_t a) {
+    return (color & 0xFFFFFF00u) | a;
+}
+
+// Текстуры, на которые могут ссылаться команды
+enum class TextureId : std::uint8_t {
+    None = 0,
+    Atlas,     // спрайты NPC и глифы эффектов (sprite_atlas.h)
+    Heatmap,   // динамическая: карта плотности при сильном отдалении
+    Count
+};
+
+// Прямоугольник внутри текстуры, в текселях
+struct TextureRect {
+    std::uint16_t x{0}, y{0}, w{0}, h{0};
+};
+
+enum class RenderCommandType : std::uint8_t {
+    Quad,    // прямоугольник (x, y — левый верхний угол; w, h — размер)
+    Circle   // круг (x, y — центр; w — радиус)
+};
+
+// Текст — это квады глифов из атласа (bitmap_font.h), отдельной команды нет
+struct RenderCommand {
+    RenderCommandType type;
+    TextureId texture;      // только для Quad
+    float x, y;
+    float w, h;
+    std::uint32_t color;    // для текстурированных квадов — модуляция
+    TextureRect src;        // только для Quad: область текстуры (w = 0 — вся текстура)
+};
+
+// Список команд одного кадра, не зависящий от графической библиотеки.
+// Строится FrameBuilder, исполняется SFML-, null- или CPU-бэкендом.
+class RenderCommandList {
+public:
+    std::uint32_t clear_color{rgba(50, 50, 100)};
+    float width{0};
+    float height{0};
+
+    void clear();
+
+    void quad(float x, float y, float w, float h, std::uint32_t color);
+    void texturedQuad(TextureId tex, float x, float y, float w, float h, std::uint32_t color = rgba(255, 255, 255));
+    // Квад с частью текстуры (спрайт из атласа)
+    void sprite(TextureId tex, TextureRect src, float x, float y, float w, float h, std::uint32_t color = rgba(255, 255, 255));
+    void circle(float cx, float cy, float radius, std::uint32_t color);
+
+    // Рамка из четырёх квадов (аналог outline у sf::RectangleShape)
+    void outline(float x, float y, float w, float h, float thickness, std::uint32_t color);
+
+    const std::vector<RenderCommand>& commands() const { return cmds; }
+    std::size_t size() const { return cmds.size(); }
+
+private:
+    std::vector<RenderCommand> cmds;
+};
+
+// Исполнитель списка команд
+struct IRenderBackend {
+    virtual void execute(const RenderCommandList& list) = 0;
+    virtual ~IRenderBackend() = default;
+};
+
+// Ничего не рисует — только считает команды (бенчмарки без GPU)
+class NullRenderBackend : public IRenderBackend {
+public:
+    void execute(const RenderCommandList& list) override;
+
+    std::uint64_t frames{0};
+    std::uint64_t quads{0};
+    std::uint64_t circles{0};
+};
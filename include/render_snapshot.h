@@ -0,0 +1,116 @@
+#pragma once
+#include "npc.h"
+#include "sim_clock.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Состояние одного NPC на конец тика — всё, что нужно рендеру
+struct NPCRenderState {
+    float x{0}, y{0};
+    float prev_x{0}, prev_y{0};
+    int health{0};
+    int max_health{1};
+    NPCType type{NPCType::Unknown};
+    bool alive{false};
+    NPCHandle handle;     // слот NPCStore и его поколение
+    char name[16]{};
+};
+
+// Неизменяемый кадр симуляции, опубликованный для рендера
+struct FrameSnapshot {
+    std::uint64_t tick{0};
+    std::uint64_t version{0};  // растёт при каждой публикации (в т.ч. внутри тика)
+    std::chrono::steady_clock::time_point tick_time;  // момент последнего шага движения
+    double tick_sim_ms{0};  // время симуляции того же шага (SimulationClock)
+    std::vector<NPCRenderState> npcs;
+    // NPC::id (слот) -> индекс в npcs (NO_INDEX — NPC нет в кадре)
+    static constexpr std::uint32_t NO_INDEX = 0xFFFFFFFFu;
+    std::vector<std::uint32_t> slot_index;
+    int alive_count{0};
+    int dead_count{0};  // включая уже удалённых из мира
+
+    // nullptr, если NPC нет в кадре или слот уже занят другим поколением
+    // (например, новым NPC, появившимся после уплотнения)
+    const NPCRenderState* find(NPCHandle handle) const {
+        const std::uint32_t slot = handle.index();
+        if (!handle.valid() || slot >= slot_index.size() || slot_index[slot] == NO_INDEX) return nullptr;
+        const NPCRenderState& st = npcs[slot_index[slot]];
+        return st.handle == handle ? &st : nullptr;
+    }
+};
+
+// Тройной буфер: один писатель, один читатель, ни один никого не ждёт.
+// Писатель заполняет writeBuffer() и вызывает publish(); читатель вызывает
+// update() и читает readBuffer(), пока не захочет взять более свежий кадр.
+template <typename T>
+class TripleBuffer {
+public:
+    T& writeBuffer() { return slots[back]; }
+
+    void publish() {
+        int prev = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+        back = prev & INDEX_MASK;
+    }
+
+    // Забрать последний опубликованный кадр; false — новых данных нет
+    bool update() {
+        if (!(middle.load(std::memory_order_acquire) & FRESH)) return false;
+        int prev = middle.exchange(front, std::memory_order_acq_rel);
+        front = prev & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const { return slots[front]; }
+
+private:
+    static constexpr int INDEX_MASK = 3;
+    static constexpr int FRESH = 4;
+
+    std::array<T, 3> slots{};
+    std::atomic<int> middle{1};
+    int back{0};   // принадлежит писателю
+    int front{2};  // принадлежит читателю
+};
+
+// Публикация снимков мира из потоков симуляции в рендер
+class SnapshotPublisher {
+public:
+    // Вызывается симуляцией. new_tick = true — после шага движения
+    // (сдвигает точку отсчёта интерполяции), false — после изменения
+    // здоровья/смертей внутри того же тика. removed — погибшие, которых
+    // уже нет в списке (NPCStore::removed()); входят в dead_count.
+    void publish(const std::vector<std::shared_ptr<NPC>>& npcs, bool new_tick, std::uint64_t removed = 0);
+    // Готовый кадр (просмотр записи): тик берётся из кадра, время — как у
+    // нового тика, так что интерполяция идёт от prev_x/prev_y кадра
+    void publishFrame(const FrameSnapshot& frame);
+
+    // Вызывается рендером раз за кадр; возвращает последний кадр
+    const FrameSnapshot& acquire();
+
+    // Часы, по которым помечаются тики (tick_sim_ms); без них — только настоящее время
+    void setClock(const SimulationClock* clock) { sim_clock = clock; }
+
+private:
+    TripleBuffer<FrameSnapshot> buffer;
+    ProfiledMutex writer_mtx{"SnapshotPublisher::writer_mtx"};  // move- и interaction-потоки пишут по очереди; читатель не блокируется
+    std::uint64_t tick{0};
+    std::uint64_t version{0};
+    std::chrono::steady_clock::time_point tick_time{std::chrono::steady_clock::now()};
+    double tick_sim_ms{0};
+    const SimulationClock* sim_clock = nullptr;
+};
+
+// Коэффициент интерполяции (0..1, ease-out quartic) — считается один раз за кадр
+float snapshot_interpolation(const FrameSnapshot& snap,
+                             std::chrono::steady_clock::time_point now,
+                             float interpolation_time_ms);
+
+// То же по времени симуляции: interpolation_time_ms — доля тика в мс
+// симуляции, поэтому при ускорении движение ускоряется вместе с ней
+float snapshot_interpolation(const FrameSnapshot& snap, double sim_now_ms, float interpolation_time_ms);
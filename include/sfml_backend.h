@@ -0,0 +1,36 @@
+#pragma once
+#include "render_commands.h"
+#include <SFML/Graphics.hpp>
+#include <array>
+
+// Исполняет список команд через SFML.
+// Подряд идущие квады и круги с одной текстурой собираются в один
+// вершинный буфер и рисуются одним вызовом draw. Если задан сплошной
+// тексель, нетекстурированные фигуры рисуются через него и не разрывают
+// пакет спрайтов из той же текстуры.
+class SfmlRenderBackend : public IRenderBackend {
+public:
+    explicit SfmlRenderBackend(sf::RenderTarget& target);
+
+    void setTexture(TextureId id, const sf::Texture* texture);
+    // Белый тексель внутри текстуры id (координаты в текселях)
+    void setSolidTexel(TextureId id, sf::Vector2f uv);
+    void execute(const RenderCommandList& list) override;
+
+    std::size_t drawCalls() const { return draw_calls; }
+
+private:
+    sf::RenderTarget& target;
+    std::array<const sf::Texture*, static_cast<std::size_t>(TextureId::Count)> textures{};
+
+    sf::VertexArray batch{sf::Triangles};
+    TextureId batch_texture{TextureId::None};
+    TextureId solid_texture{TextureId::None};
+    sf::Vector2f solid_uv;
+    std::size_t draw_calls{0};
+
+    void flush();
+    TextureId batchTextureFor(const RenderCommand& cmd) const;
+    void appendQuad(const RenderCommand& cmd);
+    void appendCircle(const RenderCommand& cmd);
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include "profiled_mutex.h"
+
+// Время симуляции, отвязанное от частоты кадров.
+// Шаг движения (тик) длится TICK_MS миллисекунд времени симуляции; при
+// скорости N один тик занимает TICK_MS / N настоящего времени. Скорость 0 —
+// без ограничения: тики идут подряд, рендер показывает последний.
+// Поток симуляции вызывает waitForNextTick(), рендер — now().
+class SimulationClock {
+public:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr double TICK_MS = 500.0;
+    static constexpr float UNTHROTTLED = 0.0f;
+
+    SimulationClock();
+
+    void setSpeed(float speed);
+    float speed() const;
+
+    // На паузе время симуляции стоит
+    void setPaused(bool paused);
+
+    // Текущее время симуляции, мс. Без ограничения скорости — конец
+    // последнего тика, так что интерполяция сразу доходит до 1.
+    double now() const;
+    // Время симуляции последнего начатого тика
+    double tickTime() const;
+
+    // Ждать, пока наступит время следующего тика, и начать его.
+    // false — running сброшен во время ожидания.
+    bool waitForNextTick(const std::atomic<bool>& running);
+
+private:
+    mutable ProfiledMutex mtx{"SimulationClock::mtx"};
+    float sim_speed{1.0f};
+    bool paused{false};
+    // now() = base_sim + (wall - base_wall) * speed
+    double base_sim{0};
+    clock::time_point base_wall;
+    double frontier{-TICK_MS};  // время последнего начатого тика
+
+    double nowLocked(clock::time_point wall) const;
+    void rebase(clock::time_point wall);
+};
+
+// Подпись скорости для HUD и консоли: "x4", "max"
+const char* speed_label(float speed);
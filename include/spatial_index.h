@@ -0,0 +1,56 @@
+#pragma once
+#include "render_snapshot.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Равномерная сетка над снимком мира. Строится раз на новый снимок
+// (сортировка подсчётом, без аллокаций в установившемся режиме);
+// в каждом кадре рендер запрашивает только видимый прямоугольник.
+class SnapshotGrid {
+public:
+    void build(const std::vector<NPCRenderState>& npcs, float world_w, float world_h, float cell_size);
+
+    // Индексы NPC, чьи клетки пересекают прямоугольник мира
+    template <typename Fn>
+    void query(float min_x, float min_y, float max_x, float max_y, Fn&& fn) const {
+        if (cols == 0 || rows == 0) return;
+        const int c0 = std::clamp(cellOf(min_x), 0, cols - 1);
+        const int r0 = std::clamp(cellOf(min_y), 0, rows - 1);
+        const int c1 = std::clamp(cellOf(max_x), 0, cols - 1);
+        const int r1 = std::clamp(cellOf(max_y), 0, rows - 1);
+        if (max_x < 0 || max_y < 0 || min_x > cols * cell || min_y > rows * cell) return;
+
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                const std::size_t k = static_cast<std::size_t>(r) * cols + c;
+                for (std::uint32_t i = cell_start[k]; i < cell_start[k + 1]; ++i)
+                    fn(items[i]);
+            }
+        }
+    }
+
+    int columns() const { return cols; }
+    int rowCount() const { return rows; }
+    float cellSize() const { return cell; }
+
+    // NPC в клетке (c, r): items()[cellBegin .. cellEnd)
+    std::uint32_t cellBegin(int c, int r) const { return cell_start[static_cast<std::size_t>(r) * cols + c]; }
+    std::uint32_t cellEnd(int c, int r) const { return cell_start[static_cast<std::size_t>(r) * cols + c + 1]; }
+    const std::vector<std::uint32_t>& entries() const { return items; }
+
+    // Максимальный сдвиг за тик: на столько расширяется запрос,
+    // чтобы не потерять NPC, интерполируемых от prev к текущей позиции
+    float maxDisplacement() const { return max_step; }
+
+private:
+    int cols{0}, rows{0};
+    float cell{1.0f};
+    float max_step{0};
+    std::vector<std::uint32_t> cell_start;  // cols * rows + 1 смещений
+    std::vector<std::uint32_t> items;       // индексы NPC, сгруппированные по клеткам
+    std::vector<std::uint32_t> cell_of;     // клетка каждого NPC (временный буфер)
+    std::vector<std::uint32_t> fill;        // позиция записи в каждой клетке (временный буфер)
+
+    int cellOf(float v) const { return static_cast<int>(v / cell); }
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include "effect_store.h"
+#include "npc.h"
+#include "render_commands.h"
+#include "sprites.h"
+#include <cstdint>
+
+// Единый атлас спрайтов: пиксели генерируются при компиляции (constexpr)
+// и загружаются в GPU одной текстурой при старте.
+//
+//   y = 0  : спрайты NPC 32x32 — Bear, Dragon, Druid, Orc, Squirrel; белый тексель
+//   y = 32 : глифы эффектов 16x16 — Kill, Hurt, Escape, Heal
+//   y = 48 : растровый шрифт 5x7 в ячейках 6x8 (bitmap_font.h)
+constexpr int ATLAS_WIDTH = 256;
+constexpr int ATLAS_HEIGHT = 128;
+constexpr int ATLAS_FONT_Y = 48;
+constexpr int ATLAS_SPRITE = 32;
+constexpr int ATLAS_GLYPH = 16;
+
+constexpr TextureRect atlas_sprite(NPCType type) {
+    int slot = static_cast<int>(type) - 1;
+    if (slot < 0 || slot >= 5) slot = 3;  // неизвестный тип — как орк
+    return {static_cast<std::uint16_t>(slot * ATLAS_SPRITE), 0, ATLAS_SPRITE, ATLAS_SPRITE};
+}
+
+constexpr TextureRect atlas_glyph(EffectType type) {
+    return {static_cast<std::uint16_t>(static_cast<int>(type) * ATLAS_GLYPH), ATLAS_SPRITE, ATLAS_GLYPH, ATLAS_GLYPH};
+}
+
+// Непрозрачный белый блок 4x4: нетекстурированные квады и круги берут цвет
+// из его центра и попадают в тот же пакет, что и спрайты
+constexpr TextureRect ATLAS_WHITE{5 * ATLAS_SPRITE, 0, 4, 4};
+
+// Пиксели атласа, 0xRRGGBBAA построчно (ATLAS_WIDTH * ATLAS_HEIGHT)
+const std::uint32_t* atlas_pixels();
+// Те же пиксели байтами R, G, B, A — готово для sf::Texture::update
+const std::uint8_t* atlas_rgba8();
+
+// Копия атласа для CPU-растеризатора
+PixelImage make_atlas_image();
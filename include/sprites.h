@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Изображение в памяти, пиксели в формате 0xRRGGBBAA (как в render_commands.h).
+// Не зависит от SFML: используется и для текстур окна, и CPU-растеризатором.
+struct PixelImage {
+    int width{0};
+    int height{0};
+    std::vector<std::uint32_t> pixels;
+
+    PixelImage() = default;
+    PixelImage(int w, int h, std::uint32_t fill = 0);
+
+    std::uint32_t get(int x, int y) const { return pixels[static_cast<std::size_t>(y) * width + x]; }
+    std::uint8_t alpha(int x, int y) const { return static_cast<std::uint8_t>(get(x, y) & 0xFF); }
+
+    // Байты R, G, B, A подряд — формат sf::Image и PNG
+    void toRGBA8(std::vector<std::uint8_t>& out) const;
+    // То же для прямоугольника (x, y, w, h) — частичная загрузка текстуры
+    void toRGBA8(std::vector<std::uint8_t>& out, int x, int y, int w, int h) const;
+};
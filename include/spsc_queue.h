@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Кольцевая очередь фиксированной ёмкости: один производитель, один потребитель.
+// Без блокировок и без аллокаций; при переполнении push() возвращает false.
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool push(const T& value) {
+        const std::size_t head = write_pos.load(std::memory_order_relaxed);
+        if (head - read_cache == Capacity) {
+            read_cache = read_pos.load(std::memory_order_acquire);
+            if (head - read_cache == Capacity) return false;
+        }
+        slots[head & (Capacity - 1)] = value;
+        write_pos.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out) {
+        const std::size_t tail = read_pos.load(std::memory_order_relaxed);
+        if (tail == write_cache) {
+            write_cache = write_pos.load(std::memory_order_acquire);
+            if (tail == write_cache) return false;
+        }
+        out = slots[tail & (Capacity - 1)];
+        read_pos.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t size_approx() const {
+        return write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T, Capacity> slots{};
+
+    // Позиции разнесены по разным кэш-линиям, чтобы потоки не мешали друг другу
+    alignas(64) std::atomic<std::size_t> write_pos{0};
+    std::size_t read_cache{0};   // последнее увиденное производителем read_pos
+    alignas(64) std::atomic<std::size_t> read_pos{0};
+    std::size_t write_cache{0};  // последнее увиденное потребителем write_pos
+};
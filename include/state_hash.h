@@ -0,0 +1,73 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+// Хэш упакованного состояния в духе xxHash64: четыре независимых
+// аккумулятора (полосы) и те же константы и раунды. Не совместим с
+// эталонным xxHash побайтно — нужен только для сравнения прогонов.
+namespace state_hash {
+
+constexpr std::uint64_t P1 = 0x9E3779B185EBCA87ull;
+constexpr std::uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+constexpr std::uint64_t P3 = 0x165667B19E3779F9ull;
+constexpr std::uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+constexpr std::uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+inline std::uint64_t round(std::uint64_t acc, std::uint64_t input) {
+    acc += input * P2;
+    acc = std::rotl(acc, 31);
+    return acc * P1;
+}
+
+inline std::uint64_t merge(std::uint64_t acc, std::uint64_t lane) {
+    acc ^= round(0, lane);
+    return acc * P1 + P4;
+}
+
+inline std::uint64_t avalanche(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    return h ^ (h >> 32);
+}
+
+// Потоковый хэш: слова раскладываются по четырём полосам по кругу
+class Hasher {
+public:
+    explicit Hasher(std::uint64_t seed = 0)
+        : lanes{seed + P1 + P2, seed + P2, seed, seed - P1} {}
+
+    void add(std::uint64_t word) {
+        lanes[count & 3] = round(lanes[count & 3], word);
+        ++count;
+    }
+
+    std::uint64_t digest() const {
+        std::uint64_t h = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) +
+                          std::rotl(lanes[3], 18);
+        for (std::uint64_t lane : lanes) h = merge(h, lane);
+        return avalanche(h + count * 8 + P5);
+    }
+
+private:
+    std::uint64_t lanes[4];
+    std::uint64_t count{0};
+};
+
+// Хэш шестнадцатью hex-цифрами с ведущими нулями. Флаги и заполнитель
+// потока восстанавливаются, поэтому вызов внутри таблицы с std::left
+// не сбивает ни сам хэш, ни следующие колонки
+inline std::ostream& write_hex(std::ostream& os, std::uint64_t value) {
+    const std::ios_base::fmtflags flags = os.flags();
+    const char fill = os.fill();
+    os << std::hex << std::right << std::setw(16) << std::setfill('0') << value;
+    os.flags(flags);
+    os.fill(fill);
+    return os;
+}
+
+} // namespace state_hash
@@ -0,0 +1,78 @@
+#pragma once
+#include "render_snapshot.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ANSI-цвет NPC (SGR без ESC[ и m): общий для draw_map и TerminalView
+const char* ansi_sgr(NPCType type, bool alive);
+// Символ NPC на карте в терминале
+char npc_glyph(NPCType type, bool alive);
+
+struct TerminalViewConfig {
+    int cols{50};
+    int rows{25};
+    double hz{30.0};
+    // Окно обзора в координатах мира: левый верхний угол и единиц мира на
+    // столбец (0 — вся ширина карты). Строка вдвое выше столбца — символы
+    // терминала вытянуты по вертикали.
+    float origin_x{0};
+    float origin_y{0};
+    float cell{0};
+};
+
+// Живая ASCII-карта для headless-серверов (например, по SSH).
+// Хранит то, что уже на экране, и выводит только изменившиеся клетки:
+// переходы курсора и смены цвета собираются в один буфер и уходят одной
+// записью, так что спокойный кадр стоит десятки байт, а не всю карту.
+class TerminalView {
+public:
+    TerminalView(TerminalViewConfig config, float world_w, float world_h);
+
+    // Нарисовать снимок; возвращает число записанных байт
+    std::size_t present(const FrameSnapshot& snap, std::FILE* out);
+
+    // Следующий present() перерисует экран целиком
+    void invalidate() { full_redraw = true; }
+
+    // Цикл с частотой cfg.hz до сброса running; экран очищается в начале
+    // и курсор возвращается в конце
+    void run(SnapshotPublisher& snapshots, const std::atomic<bool>& running, std::FILE* out = stdout);
+
+    void printSummary() const;
+
+private:
+    struct Cell {
+        char ch{' '};
+        std::uint8_t color{0};
+        bool operator==(const Cell& o) const { return ch == o.ch && color == o.color; }
+    };
+
+    TerminalViewConfig cfg;
+    float cell_w, cell_h;
+    int map_rows;  // строк карты под строкой состояния
+
+    std::vector<Cell> front;  // то, что сейчас на терминале
+    std::vector<Cell> back;   // кадр, который собираем
+    std::string buf;          // выход одного кадра, ёмкость переиспользуется
+    bool full_redraw{true};
+
+    // Положение курсора и текущий цвет терминала после последнего вывода
+    int cur_row{-1};
+    int cur_col{-1};
+    std::uint8_t cur_color{0};
+
+    std::string status;
+    std::uint64_t frames{0};
+    std::uint64_t bytes{0};
+    double compose_us{0};
+
+    void compose(const FrameSnapshot& snap);
+    void putText(int row, int col, std::string_view text, std::uint8_t color);
+    void diff();
+    void moveTo(int row, int col);
+    void setColor(std::uint8_t color);
+};
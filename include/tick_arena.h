@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Арена тика: линейное выделение из одного буфера, освобождение только
+// целиком в reset() в конце тика. Контейнеры тика (std::pmr) берут память
+// отсюда. Если тик не уместился, недостающее добирается из кучи отдельными
+// блоками, а при reset() буфер вырастает до полутора объёмов этого тика —
+// следующие тики снова обходятся без кучи. После всплеска буфер ужимается:
+// если за SHRINK_WINDOW тиков занято меньше четверти, он уменьшается до
+// полутора пиков окна. heapAllocations() позволяет проверить это снаружи.
+//
+// Арена однопоточная: выделять из неё можно только из одного потока за раз
+// (задачи фаз пишут в заранее выделенные буферы). Растущий контейнер бросает
+// старые буферы до reset(), поэтому размер контейнеров тика лучше задавать
+// сразу (reserve/resize).
+class TickArena : public std::pmr::memory_resource {
+public:
+    explicit TickArena(std::size_t initial_bytes = 64 * 1024);
+
+    TickArena(const TickArena&) = delete;
+    TickArena& operator=(const TickArena&) = delete;
+
+    // Всё, что было выдано, становится недействительным
+    void reset();
+
+    static constexpr std::uint64_t SHRINK_WINDOW = 256;
+
+    std::size_t used() const { return used_bytes; }         // за текущий тик
+    std::size_t peak() const { return peak_bytes; }         // максимум за тик, за всё время
+    std::size_t capacity() const { return buffer_size; }
+    std::uint64_t heapAllocations() const { return heap_allocs; }
+    std::uint64_t resets() const { return reset_count; }
+    std::uint64_t lastGrowth() const { return last_growth; }  // номер reset(), на котором рос буфер
+    std::uint64_t lastShrink() const { return last_shrink; }  // номер reset(), на котором буфер ужат
+
+private:
+    std::unique_ptr<std::byte[]> buffer;
+    std::size_t buffer_size{0};
+    std::size_t initial_size{0};
+
+    // Текущий блок выделения: основной буфер или блок переполнения
+    std::byte* cursor{nullptr};
+    std::byte* limit{nullptr};
+    std::vector<std::unique_ptr<std::byte[]>> overflow;
+
+    std::size_t used_bytes{0};
+    std::size_t peak_bytes{0};
+    std::uint64_t heap_allocs{0};
+    std::uint64_t reset_count{0};
+    std::uint64_t last_growth{0};
+    std::uint64_t last_shrink{0};
+    std::size_t window_peak{0};  // максимум за тик в текущем окне SHRINK_WINDOW
+
+    void replaceBuffer(std::size_t bytes);
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+// Вернуть память контейнера арене (пустой контейнер с тем же ресурсом).
+// Вызывается перед TickArena::reset() для контейнеров, переживающих тик.
+template <typename Container>
+void release_tick_storage(Container& c) {
+    Container(c.get_allocator()).swap(c);
+}
@@ -0,0 +1,172 @@
+#pragma once
+#include "job_system.h"
+#include "npc.h"
+#include "npc_store.h"
+#include "render_snapshot.h"
+#include "tick_arena.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+class TrajectoryRecorder;
+class InteractionManager;
+
+// Фазы одного тика симуляции в порядке выполнения. Между фазами — барьер:
+// следующая начинается, когда все задачи предыдущей завершены.
+enum class TickPhase : std::uint8_t {
+    Compact,   // удаление погибших в прошлых тиках, приём новых NPC
+    Move,      // ядро движения по упакованным координатам (параллельно по кускам)
+    Index,     // сортировка живых NPC по клеткам сетки
+    Detect,    // поиск пар в пределах дистанции взаимодействия (параллельно по клеткам)
+    Resolve,   // бой и лечение по найденным парам (по порядку или в две фазы, см. CombatMode)
+    Notify,    // рассылка исходов наблюдателям
+    Publish,   // снимок мира для рендера
+    Count
+};
+
+constexpr std::size_t TICK_PHASE_COUNT = static_cast<std::size_t>(TickPhase::Count);
+
+const char* tick_phase_name(TickPhase phase);
+
+struct TickStats {
+    std::array<double, TICK_PHASE_COUNT> phase_us{};
+    std::size_t candidates{0};  // пар после обнаружения
+    std::size_t notified{0};    // исходов, ушедших наблюдателям
+    std::size_t removed{0};     // погибших, убранных из списка
+    std::size_t spawned{0};     // новых NPC, принятых в упакованное состояние
+    std::size_t arena_bytes{0}; // занято в арене тика
+    std::uint64_t allocations{0};  // выделений в куче за тик (PIXELRPG_TRACK_ALLOCATIONS)
+    bool shrunk{false};            // арена или пары кусков ужаты после всплеска (разовые выделения)
+    std::uint64_t world_hash{0};   // хэш состояния после тика (setHashing), иначе 0
+};
+
+// Планировщик тика: каждая фаза — набор задач на JobSystem, поток,
+// вызвавший tick(), участвует в работе. Разбиение на куски фиксировано,
+// поэтому порядок пар и случайные сдвиги не зависят от числа потоков.
+// interactions — менеджер того же мира (WorldContext::interactions());
+// без него — InteractionManager::instance().
+class TickScheduler {
+public:
+    TickScheduler(NPCStore& world, JobSystem& jobs, int map_w, int map_h, int cell_size);
+    TickScheduler(NPCStore& world, JobSystem& jobs, int map_w, int map_h, int cell_size,
+                  InteractionManager& interactions);
+    ~TickScheduler();
+
+    TickScheduler(const TickScheduler&) = delete;
+    TickScheduler& operator=(const TickScheduler&) = delete;
+
+    void setPublisher(SnapshotPublisher* publisher) { snapshots = publisher; }
+    void setSeed(std::uint64_t seed) { rng_seed = seed; }
+    std::uint64_t seed() const { return rng_seed; }
+    // Продолжить нумерацию тиков и случайные потоки планировщика trunk: ветка
+    // мира (WorldContext::fork) с теми же генераторами повторяет ствол тик в тик
+    void continueFrom(const TickScheduler& trunk);
+    // Хэш мира после каждого тика: позиции, здоровье, тип, жизнь и ссылка
+    // каждого NPC в порядке списка. Куски хэшируются независимо и
+    // сворачиваются по порядку, поэтому хэш не зависит от числа потоков.
+    // Это полный пересчёт по упакованному состоянию, а не инкрементальный
+    // хэш: движение меняет каждого живого NPC каждый тик, так что поправки
+    // по изменённым NPC стоили бы столько же, сколько проход по массивам.
+    void setHashing(bool on) { hashing = on; }
+    // Запись упакованного состояния после каждого тика (--record)
+    void setRecorder(TrajectoryRecorder* rec) { recorder = rec; }
+
+    void tick();
+
+    std::uint64_t ticks() const { return tick_count; }
+    // Номер последнего тика мира с учётом continueFrom()
+    std::uint64_t worldTick() const { return tick_base + tick_count; }
+    const TickStats& last() const { return last_stats; }
+
+    // Память временных структур тика; сбрасывается в конце каждого тика
+    const TickArena& tickArena() const { return arena; }
+
+    // Среднее время фаз за прогон
+    void printSummary() const;
+
+private:
+    static constexpr std::size_t MOVE_GRAIN = 1024;
+    static constexpr std::size_t MOVE_LANES = 8;    // независимых генераторов на кусок
+    static constexpr std::size_t DETECT_GRAIN = 8;  // клеток на задачу
+    static constexpr std::size_t RESOLVE_GRAIN = 256;  // событий на задачу (двухфазный бой)
+    static constexpr std::size_t HASH_GRAIN = 4096;
+    static constexpr std::size_t COPY_GRAIN = 16;   // кусков NPCStore на задачу копирования ветки
+    // Меньшие миры обходят те же куски в одном потоке: задачи дороже работы
+    static constexpr std::size_t PARALLEL_MIN_NPCS = 2048;
+
+    NPCStore& world;
+    std::vector<std::shared_ptr<NPC>>& npcs;  // world.list()
+    JobSystem& jobs;
+    InteractionManager& interactions;
+    SnapshotPublisher* snapshots = nullptr;
+    TrajectoryRecorder* recorder = nullptr;
+
+    int map_w, map_h;
+    int cell;
+    int cells_x, cells_y;
+
+    std::uint64_t rng_seed{0x5EED};
+    bool hashing{false};
+    std::uint64_t tick_count{0};
+    std::uint64_t tick_base{0};  // тиков ствола до ветвления (continueFrom)
+    TickStats last_stats;
+    std::array<double, TICK_PHASE_COUNT> total_us{};
+    std::size_t total_candidates{0};
+    std::size_t total_removed{0};
+    std::size_t total_spawned{0};
+    std::uint64_t total_allocations{0};
+    std::uint64_t max_allocations{0};
+
+    // Упакованное состояние мира (без мьютексов NPC), в том же порядке, что и
+    // world.list(). Координаты ведёт само ядро движения и копирует в мир
+    // (NPCStore::moveTo); из мира они читаются только в gatherState() для
+    // новых элементов.
+    std::vector<std::int32_t> pos_x, pos_y, reach;
+    std::vector<std::int32_t> health;
+    std::vector<NPCHandle> handles;
+    std::vector<std::uint8_t> kind;   // NPCType
+    std::vector<std::uint8_t> alive;
+    std::vector<std::uint32_t> cell_of;
+    // Клетка по координате с учётом границ: столбец и смещение строки (row * cells_x)
+    std::vector<std::uint32_t> col_of_x, row_of_y;
+    // Дистанция шага по типу; заполняется из NPC в gatherState()
+    std::array<std::int32_t, static_cast<std::size_t>(NPCType::Count)> move_distance{};
+    // Временные структуры тика — в арене, освобождаются все вместе в конце тика
+    TickArena arena;
+    // Индексы живых NPC, отсортированные по клеткам (counting sort)
+    std::pmr::vector<std::uint32_t> cell_start{&arena};
+    std::pmr::vector<std::uint32_t> cell_items{&arena};
+    std::pmr::vector<std::uint32_t> cell_fill{&arena};
+    // Пары, найденные каждым куском обнаружения. Куски пишут параллельно,
+    // поэтому пары не в арене (она однопоточная), а в своих векторах куска,
+    // ёмкость которых живёт между тиками. Раз в TickArena::SHRINK_WINDOW тиков
+    // вектор, занятый меньше чем на четверть пика окна, ужимается.
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> chunk_pairs;
+    std::vector<std::uint32_t> chunk_pair_peak;  // пик пар куска за окно
+    std::pmr::vector<std::uint64_t> chunk_hashes{&arena};
+
+    template <typename Fn>
+    void forChunks(std::size_t count, std::size_t grain, Fn&& fn);
+
+    // Прочитать упакованное состояние элементов списка начиная с from
+    void gatherState(std::size_t from);
+    // Обновить здоровье и флаги жизни участников пар после боя
+    void refreshVitals();
+    std::uint64_t hashWorld();
+    void recordFrame();
+
+    void compactPhase();
+    void movePhase();
+    void indexPhase();
+    void detectPhase();
+    void resolvePhase();
+    void notifyPhase();
+    void publishPhase();
+    // Отдать временные структуры арене и сбросить её
+    void endTick();
+    // Ужать векторы пар кусков после всплеска (раз в окно); true — что-то ужато
+    bool trimChunkPairs();
+};
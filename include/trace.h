@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Трассировка в формате Chrome trace events (chrome://tracing, ui.perfetto.dev).
+// Зоны пишутся в кольцевой буфер своего потока без блокировок; при
+// переполнении затираются самые старые. Выключенная трассировка стоит
+// одной атомарной загрузки на зону.
+
+namespace trace_detail {
+extern std::atomic<bool> enabled;
+std::int64_t now_ns();
+void record(const char* name, std::int64_t start_ns, std::int64_t end_ns);
+}
+
+inline bool trace_enabled() { return trace_detail::enabled.load(std::memory_order_relaxed); }
+
+// Включить запись; events_per_thread округляется вверх до степени двойки
+void trace_start(std::size_t events_per_thread = std::size_t{1} << 18);
+// Имя потока на временной шкале; можно вызывать до trace_start()
+void trace_thread_name(const std::string& name);
+// Остановить запись и выгрузить все буферы; false — файл не записан.
+// Вызывать, когда остальные потоки уже не пишут зоны.
+bool trace_write(const std::string& path);
+
+// Зона от конструктора до деструктора. name — строка со статическим временем жизни.
+class TraceZone {
+public:
+    explicit TraceZone(const char* zone_name)
+        : name(trace_enabled() ? zone_name : nullptr), start(name ? trace_detail::now_ns() : 0) {}
+    ~TraceZone() {
+        if (name) trace_detail::record(name, start, trace_detail::now_ns());
+    }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+    const char* name;
+    std::int64_t start;
+};
@@ -0,0 +1,141 @@
+#pragma once
+#include "npc.h"
+#include "npc_handle.h"
+#include "render_snapshot.h"
+#include "sim_clock.h"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Запись траекторий: покадровое состояние мира после каждого тика для
+// просмотра без повторной симуляции (--record / --playback).
+//
+// Файл: заголовок, кадры, индекс опорных кадров, хвост. Кадр — тип
+// (опорный или разностный), длина и содержимое. Опорный кадр самодостаточен:
+// все NPC с типом, именем и здоровьем. Разностный описывает каждый NPC
+// относительно предыдущего кадра: тот же элемент списка, перемещённый
+// (swap-remove) или новый; координаты и здоровье — разности в zigzag-varint,
+// флаг жизни — бит в байте элемента. Без хвоста (прогон прерван) индекс
+// восстанавливается проходом по кадрам.
+
+// Упакованное состояние мира на конец тика (массивы TickScheduler)
+struct TrajectoryFrame {
+    std::uint64_t tick{0};
+    std::uint64_t removed{0};  // погибших, уже убранных из мира
+    std::size_t count{0};
+    const NPCHandle* handles{nullptr};
+    const std::int32_t* x{nullptr};
+    const std::int32_t* y{nullptr};
+    const std::int32_t* health{nullptr};
+    const std::uint8_t* alive{nullptr};
+    const std::vector<std::shared_ptr<NPC>>* npcs{nullptr};  // тип, имя, макс. здоровье новых NPC
+};
+
+class TrajectoryRecorder {
+public:
+    TrajectoryRecorder(const std::string& path, std::uint32_t keyframe_interval, int map_w, int map_h);
+    ~TrajectoryRecorder();
+
+    TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+    TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+    bool good() const { return out.good(); }
+    void record(const TrajectoryFrame& frame);
+    // Дописать индекс и хвост; вызывается и из деструктора
+    void finish();
+
+    void printSummary() const;
+
+private:
+    struct Entry {
+        NPCHandle handle;
+        std::int32_t x, y, health;
+    };
+
+    std::ofstream out;
+    std::string path;
+    std::uint32_t keyframe_interval;
+    bool finished{false};
+
+    std::vector<Entry> prev;
+    std::vector<std::uint32_t> prev_index_of_slot;  // NPCHandle::index() -> индекс в prev
+    std::vector<std::uint8_t> payload;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> keyframes;  // тик, смещение
+
+    std::uint64_t frames{0};
+    std::uint64_t bytes{0};
+    std::uint64_t npc_entries{0};
+};
+
+class TrajectoryReader {
+public:
+    // false — файл не открыт или не запись траекторий; причина в error
+    bool open(const std::string& path, std::string& error);
+
+    std::uint64_t firstTick() const { return keyframes.empty() ? 0 : keyframes.front().first; }
+    std::uint64_t lastTick() const { return last_tick; }
+    std::uint64_t frameCount() const { return frame_count; }
+    std::uint32_t keyframeInterval() const { return keyframe_interval; }
+    int mapWidth() const { return map_w; }
+    int mapHeight() const { return map_h; }
+
+    // Кадр тика tick (или ближайшего более раннего): от опорного кадра
+    // декодируется не больше keyframeInterval() кадров
+    bool seek(std::uint64_t tick, FrameSnapshot& out);
+    // Следующий кадр; false — запись кончилась
+    bool next(FrameSnapshot& out);
+
+private:
+    std::ifstream in;
+    std::uint32_t keyframe_interval{0};
+    int map_w{0}, map_h{0};
+    std::uint64_t frames_begin{0};
+    std::uint64_t frames_end{0};
+    std::uint64_t frame_count{0};
+    std::uint64_t last_tick{0};
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> keyframes;  // тик, смещение
+
+    std::uint64_t cursor{0};  // смещение следующего кадра
+    std::vector<std::uint8_t> payload;
+    std::vector<NPCRenderState> prev;
+    std::vector<NPCHandle> prev_handles;
+    std::vector<std::uint32_t> prev_index_of_slot;
+
+    bool scanFrames();
+    bool decode(std::uint8_t type, FrameSnapshot& out);
+};
+
+// Просмотр записи: кадр за тиком по SimulationClock (скорость — --sim-speed
+// и клавиши 1-4), пауза, перемотка из любого потока через requestSeek()
+class TrajectoryPlayer {
+public:
+    TrajectoryPlayer(TrajectoryReader& reader, SnapshotPublisher& publisher, SimulationClock& clock);
+
+    // Сдвиг на delta тиков от текущего кадра; складывается, пока не применён
+    void requestSeek(std::int64_t delta) { pending_seek.fetch_add(delta, std::memory_order_relaxed); }
+
+    // Показать кадр start_tick и воспроизводить до конца записи или сброса
+    // running. stop_at_end = false — на последнем кадре встать на паузу
+    // (окно остаётся открытым для перемотки)
+    void run(std::uint64_t start_tick, std::atomic<bool>& running, std::atomic<bool>& paused, bool stop_at_end);
+
+    void printSummary() const;
+
+private:
+    TrajectoryReader& reader;
+    SnapshotPublisher& publisher;
+    SimulationClock& clock;
+    FrameSnapshot frame;
+    std::atomic<std::int64_t> pending_seek{0};
+
+    std::uint64_t shown{0};
+    std::uint64_t seeks{0};
+    bool reached_end{false};  // показан последний кадр записи
+    double seek_ms_total{0};
+    double seek_ms_max{0};
+
+    void seekTo(std::uint64_t tick);
+};
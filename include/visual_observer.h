@@ -0,0 +1,53 @@
+#pragma once
+#include "npc.h"
+#include "particle_pool.h"
+#include "render_snapshot.h"
+#include "effect_store.h"
+#include "spsc_queue.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Поток взаимодействий только кладёт компактные события в очередь;
+// эффекты, частицы и подписи создаются потоком рендера.
+class VisualObserver : public IInteractionObserver {
+private:
+    VisualObserver() = default;
+    
+    // Симуляция -> рендер, без блокировок
+    SpscQueue<EffectEvent, 4096> events;
+    std::atomic<std::uint64_t> dropped_events{0};
+    
+    // Состояние рендера (только поток рендера)
+    std::string lastInteractionMessage;
+    EffectStore effect_store;
+    ParticlePool particle_pool;
+    
+    void addEffect(EffectType type, float x, float y, float duration_ms, std::uint32_t color, std::int64_t now_ms);
+    void addParticles(float x, float y, int count, std::uint32_t color);
+    
+public:
+    static std::shared_ptr<IInteractionObserver> get();
+    
+    ~VisualObserver() = default;
+    
+    // Вызывается потоком взаимодействий (единственный производитель)
+    void on_interaction(const NPCStore& world, NPCHandle actor, NPCHandle target,
+                       InteractionOutcome outcome) override;
+    
+    // Разобрать накопившиеся события и удалить истёкшие эффекты.
+    // Позиции берутся из снимка с коэффициентом интерполяции t.
+    void consumeEvents(const FrameSnapshot& snap, float t, std::int64_t now_ms);
+    
+    const std::string& getLastInteractionMessage() const { return lastInteractionMessage; }
+    const EffectStore& effects() const { return effect_store; }
+    const ParticlePool& particles() const { return particle_pool; }
+    std::uint64_t droppedEvents() const { return dropped_events.load(std::memory_order_relaxed); }
+    
+    // Лимит новых частиц за кадр (защита от массовых убийств)
+    void setParticleBudget(std::size_t budget);
+    
+    // Обновить частицы
+    void updateParticles(float dt);
+};
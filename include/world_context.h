@@ -0,0 +1,47 @@
+#pragma once
+#include "game_utils.h"
+#include "npc_store.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Мир целиком: список и слоты NPC, свой менеджер взаимодействий, свои
+// генераторы и наблюдатели. Процессных синглтонов мир не трогает, поэтому
+// независимых миров в одном процессе может быть сколько угодно, каждый в
+// своём потоке. Мир main по-прежнему живёт на InteractionManager::instance()
+// и default_random().
+class WorldContext {
+public:
+    explicit WorldContext(std::uint64_t seed);
+
+    WorldContext(const WorldContext&) = delete;
+    WorldContext& operator=(const WorldContext&) = delete;
+
+    NPCStore& store() { return world; }
+    const NPCStore& store() const { return world; }
+    std::vector<std::shared_ptr<NPC>>& npcs() { return list; }
+    InteractionManager& interactions() { return manager; }
+    RandomSource& random() { return rand; }
+
+    // Наблюдатель мира: подписывается на всех NPC, в том числе будущих
+    void subscribe(std::shared_ptr<IInteractionObserver> observer);
+
+    // Случайный NPC из фабрики мира, с наблюдателями мира
+    NPCHandle spawn();
+
+    // Ветка этого мира: NPC общие, их состояние — по кускам до первой записи
+    // (NPCStore), генераторы, фабрика и режим боя скопированы — без пересева
+    // ветка повторяет мир. Наблюдатели не переносятся. Ветки создаются по
+    // очереди; затем ветки и сам мир могут работать в разных потоках.
+    std::unique_ptr<WorldContext> fork();
+
+private:
+    WorldContext(WorldContext& parent, int);  // fork()
+
+    std::vector<std::shared_ptr<NPC>> list;
+    NPCStore world{list};
+    RandomSource rand;
+    NPCFactory factory{rand};
+    InteractionManager manager;
+    std::vector<std::shared_ptr<IInteractionObserver>> observers;
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include "batch_runner.h"
+#include "game_utils.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class JobSystem;
+class TickScheduler;
+class WorldContext;
+
+// Ветка «что если»: мир-ствол в момент ветвления, дальше свои правила.
+// seed == 0 — контрольная ветка: генераторы ствола и его планировщик
+// продолжаются как есть, поэтому ветка повторяет непрерванный прогон.
+struct BranchSpec {
+    std::uint64_t seed{0};
+    CombatMode combat{CombatMode::Sequential};
+    double spawn_rate{0};  // подкреплений в секунду времени симуляции
+};
+
+struct BranchResult {
+    BranchSpec spec;
+    std::uint64_t world_hash{0};   // после последнего тика ветки
+    std::uint64_t world_tick{0};   // тиков с начала ствола
+    std::array<std::uint32_t, NPC_TYPE_COUNT> survivors{};
+    std::size_t live{0};
+    std::uint64_t copied_chunks{0};  // кусков состояния, скопированных веткой (NPCStore::copyChunk)
+    std::size_t chunks{0};
+    double ms{0};
+};
+
+// Ответвить от trunk по ветке на каждый spec и прогнать все ветки по ticks
+// тиков на jobs: параллельно по ветке на поток, если веток не меньше, чем
+// потоков, иначе по очереди с фазами на всех потоках. Ветки создаются по очереди до запуска; ствол во
+// время прогона не меняется. trunk_scheduler — планировщик ствола (его тик и
+// зерно продолжает контрольная ветка), spawn_debt — накопленная доля
+// подкрепления ствола.
+std::vector<BranchResult> run_branches(WorldContext& trunk, const TickScheduler& trunk_scheduler,
+                                       double spawn_debt, const std::vector<BranchSpec>& specs,
+                                       std::uint64_t ticks, JobSystem& jobs);
+
+// Ствол: seed, npcs, fork_tick тиков; затем branches веток по ticks тиков.
+// Ветка 0 — контрольная, ветки 1.. пересеяны и идут в режиме branch_combat.
+struct ForkSetup {
+    std::uint64_t seed{1};
+    int npcs{50};
+    std::uint64_t fork_tick{100};
+    std::uint64_t ticks{200};
+    std::size_t branches{8};
+    double spawn_rate{0};
+    CombatMode combat{CombatMode::Sequential};
+    CombatMode branch_combat{CombatMode::Sequential};
+    unsigned threads{0};  // 0 — по числу ядер
+};
+
+// Прогнать ствол и ветки, напечатать таблицу и записать CSV (если путь не
+// пуст). false — не удалось записать файл
+bool run_fork_study(const ForkSetup& setup, const std::string& csv_path);
@@ -1,14 +1,36 @@
 #include "include/npc.h"
 #include "include/game_utils.h"
+#include "include/render_snapshot.h"
+#include "include/render_bench.h"
+#include "include/frame_export.h"
+#include "include/terminal_view.h"
+#include "include/tick_scheduler.h"
+#include "include/job_system.h"
+#include "include/visual_observer.h"
+#include "include/memory_tracker.h"
+#include "include/metrics.h"
+#include "include/trace.h"
+#include "include/profiled_mutex.h"
+#include "include/lockstep.h"
+#include "include/trajectory.h"
+#include "include/batch_runner.h"
+#include "include/world_fork.h"
+#include "include/state_hash.h"
+#ifndef PIXELRPG_HEADLESS
 #include "include/visual_wrapper.h"
+#endif
 
 #include <memory>
-#include <array>
 #include <thread>
 #include <atomic>
 #include <chrono>
-#include <unordered_map>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <type_traits>
 
 using namespace std::chrono_literals;
 
@@ -19,58 +41,305 @@ static bool hasFlag(int argc, char* argv[], const std::string& flag) {
     return false;
 }
 
+static const char* flagValue(int argc, char* argv[], const std::string& flag) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == flag) return argv[i + 1];
+    }
+    return nullptr;
+}
+
+// Whole-string number in the range of T (no sign for unsigned, finite for floating point)
+template <typename T>
+static bool parseNumber(const std::string& text, T& out) {
+    std::size_t used = 0;
+    try {
+        if constexpr (std::is_floating_point_v<T>) {
+            const double value = std::stod(text, &used);
+            if (!std::isfinite(value)) return false;
+            out = static_cast<T>(value);
+        } else if constexpr (std::is_signed_v<T>) {
+            const long long value = std::stoll(text, &used);
+            if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max()) return false;
+            out = static_cast<T>(value);
+        } else {
+            if (text.find('-') != std::string::npos) return false;
+            const unsigned long long value = std::stoull(text, &used);
+            if (value > std::numeric_limits<T>::max()) return false;
+            out = static_cast<T>(value);
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return used == text.size();
+}
+
+// Numeric flag value, or fallback when the flag is absent. A malformed value is
+// reported with the flag name and ends the program with exit code 1.
+template <typename T>
+static T numberFlag(int argc, char* argv[], const std::string& flag, T fallback) {
+    const char* text = flagValue(argc, argv, flag);
+    if (!text) return fallback;
+    T value{};
+    if (!parseNumber(text, value)) {
+        std::cerr << "Invalid " << flag << " '" << text << "', expected a number\n";
+        std::exit(1);
+    }
+    return value;
+}
+
 int main(int argc, char** argv) {
     const bool headless = hasFlag(argc, argv, "--headless");
 
+    // Chrome/Perfetto timeline of every engine thread, written at shutdown
+    const char* tracePath = flagValue(argc, argv, "--trace");
+    trace_thread_name("main");
+    if (tracePath) trace_start();
+
+    // Frame construction benchmark: no window, no GPU, no simulation threads
+    if (flagValue(argc, argv, "--bench-render")) {
+        return run_render_benchmark(std::max(0, numberFlag(argc, argv, "--bench-render", 0)),
+                                    std::max(0, numberFlag(argc, argv, "--bench-npcs", 50)),
+                                    numberFlag(argc, argv, "--bench-zoom", 1.0f));
+    }
+
+    // ---- Deterministic lockstep ----
+    // --seed reseeds every generator, --ticks fixes the run length; with both, a run
+    // reproduces tick for tick regardless of thread count, pacing or window
+    std::uint64_t seed = 0;
+    const char* seedText = flagValue(argc, argv, "--seed");
+    if (seedText) seed = numberFlag<std::uint64_t>(argc, argv, "--seed", 0);
+    // 0 = run for the 30 s wall-clock timer
+    const std::uint64_t tickLimit = numberFlag<std::uint64_t>(argc, argv, "--ticks", 0);
+
+    CombatMode combatMode = CombatMode::Sequential;
+    if (const char* combat = flagValue(argc, argv, "--combat")) {
+        const std::string mode = combat;
+        if (mode == "two-phase") {
+            combatMode = CombatMode::TwoPhase;
+        } else if (mode != "sequential") {
+            std::cerr << "Unknown --combat mode '" << mode << "' (expected sequential or two-phase)\n";
+            return 1;
+        }
+    }
+
+    // Runs two configurations from the same seed and reports the first tick whose
+    // world hash differs; exit code 0 when they match
+    if (const char* check = flagValue(argc, argv, "--lockstep-check")) {
+        const std::string spec = check;
+        const std::size_t comma = spec.find(',');
+        LockstepConfig a, b;
+        if (comma == std::string::npos || !parse_lockstep_config(spec.substr(0, comma), combatMode, a) ||
+            !parse_lockstep_config(spec.substr(comma + 1), combatMode, b)) {
+            std::cerr << "Invalid --lockstep-check '" << spec
+                      << "', expected A,B with each side THREADS or THREADS:sequential|two-phase\n";
+            return 1;
+        }
+        LockstepSetup setup;
+        if (seedText) setup.seed = seed;
+        if (tickLimit) setup.ticks = tickLimit;
+        setup.npcs = std::max(0, numberFlag(argc, argv, "--npcs", setup.npcs));
+        setup.spawn_rate = std::max(0.0, numberFlag(argc, argv, "--spawn-rate", setup.spawn_rate));
+        return check_lockstep(setup, a, b) ? 0 : 1;
+    }
+
+    // Asserts the zero-allocation tick: after a warm-up (--warmup-ticks, default 50)
+    // every one of the N measured ticks must report no heap allocations. Needs a
+    // PIXELRPG_TRACK_ALLOCATIONS build; exit code 0 only when the check passes
+    if (flagValue(argc, argv, "--check-steady-allocs")) {
+        LockstepSetup setup;
+        setup.ticks = numberFlag<std::uint64_t>(argc, argv, "--check-steady-allocs", 0);
+        if (seedText) setup.seed = seed;
+        setup.npcs = std::max(0, numberFlag(argc, argv, "--npcs", setup.npcs));
+        setup.spawn_rate = std::max(0.0, numberFlag(argc, argv, "--spawn-rate", setup.spawn_rate));
+        LockstepConfig config;
+        config.threads = std::max(1u, numberFlag(argc, argv, "--threads", config.threads));
+        config.combat = combatMode;
+        const auto warmup = numberFlag<std::uint64_t>(argc, argv, "--warmup-ticks", 50);
+        return check_steady_allocations(setup, config, warmup) ? 0 : 1;
+    }
+
+    // Monte Carlo batch: N independent worlds (seeds --seed, --seed + 1, ...) run in
+    // parallel, each with its own interaction manager, observers and generators;
+    // per-type survivor statistics go to --batch-csv
+    if (flagValue(argc, argv, "--batch")) {
+        BatchSetup setup;
+        setup.runs = numberFlag<std::size_t>(argc, argv, "--batch", 0);
+        if (seedText) setup.first_seed = seed;
+        if (tickLimit) setup.ticks = tickLimit;
+        setup.npcs = std::max(0, numberFlag(argc, argv, "--npcs", setup.npcs));
+        setup.spawn_rate = std::max(0.0, numberFlag(argc, argv, "--spawn-rate", setup.spawn_rate));
+        setup.threads = numberFlag(argc, argv, "--threads", setup.threads);
+        setup.combat = combatMode;
+        const char* csv = flagValue(argc, argv, "--batch-csv");
+        const char* runsCsv = flagValue(argc, argv, "--batch-runs-csv");
+        const bool ok = run_batch_study(setup, csv ? csv : "batch.csv", runsCsv ? runsCsv : "");
+        if (tracePath) trace_write(tracePath);
+        return ok ? 0 : 1;
+    }
+    // What-if branches: run one world to --fork-at, fork it --branches times (NPCs are
+    // shared copy-on-write) and run every branch for --ticks in parallel. Branch 0
+    // continues the trunk unchanged; the others are reseeded and use --branch-combat
+    if (flagValue(argc, argv, "--fork-at")) {
+        ForkSetup setup;
+        setup.fork_tick = numberFlag<std::uint64_t>(argc, argv, "--fork-at", 0);
+        if (seedText) setup.seed = seed;
+        if (tickLimit) setup.ticks = tickLimit;
+        setup.branches = std::max<std::size_t>(1, numberFlag(argc, argv, "--branches", setup.branches));
+        setup.npcs = std::max(0, numberFlag(argc, argv, "--npcs", setup.npcs));
+        setup.spawn_rate = std::max(0.0, numberFlag(argc, argv, "--spawn-rate", setup.spawn_rate));
+        setup.threads = numberFlag(argc, argv, "--threads", setup.threads);
+        setup.combat = combatMode;
+        setup.branch_combat = combatMode;
+        if (const char* combat = flagValue(argc, argv, "--branch-combat")) {
+            const std::string mode = combat;
+            if (mode == "two-phase") {
+                setup.branch_combat = CombatMode::TwoPhase;
+            } else if (mode == "sequential") {
+                setup.branch_combat = CombatMode::Sequential;
+            } else {
+                std::cerr << "Unknown --branch-combat mode '" << mode << "' (expected sequential or two-phase)\n";
+                return 1;
+            }
+        }
+        const char* csv = flagValue(argc, argv, "--branches-csv");
+        const bool ok = run_fork_study(setup, csv ? csv : "");
+        if (tracePath) trace_write(tracePath);
+        return ok ? 0 : 1;
+    }
+    if (seedText) seed_random(seed);
+
+    // ---- Trajectory playback ----
+    // --playback replays a --record file through the same viewers (window, --tty-view,
+    // --export-frames) without simulating; --playback-start picks the first tick shown
+    const char* playbackPath = flagValue(argc, argv, "--playback");
+    TrajectoryReader playbackReader;
+    if (playbackPath) {
+        std::string error;
+        if (!playbackReader.open(playbackPath, error)) {
+            std::cerr << "Cannot play back: " << error << "\n";
+            return 1;
+        }
+        if (flagValue(argc, argv, "--record")) {
+            std::cerr << "--record cannot be combined with --playback\n";
+            return 1;
+        }
+    }
+
     // auto consoleObs = ConsoleObserver::get();
     auto fileObs = FileObserver::get("log.txt");
 
     // ---- NPCs ----
+    // The store keeps the live list compact: NPCs that died in a tick are swap-removed
+    // at the start of the next one, and their slots are reused by later spawns.
+    // Interaction events and observers refer to NPCs by 32-bit generational handles.
     std::vector<std::shared_ptr<NPC>> npcs;
-    constexpr int NPC_COUNT = 50;
-    constexpr int MAX_DRAGONS = 1;
-
-    int dragonCount = 0;
-    for (int i = 0; i < NPC_COUNT; ++i) {
-        NPCType t = random_type();
-        while (t == NPCType::Dragon && dragonCount >= MAX_DRAGONS)
-            t = random_type();
-        if (t == NPCType::Dragon) dragonCount++;
-
-        std::string name;
-        switch (t) {
-            case NPCType::Bear:     name = "Bear_" + std::to_string(i + 1);     break;
-            case NPCType::Dragon:   name = "Dragon_" + std::to_string(i + 1);   break;
-            case NPCType::Druid:    name = "Druid_" + std::to_string(i + 1);    break;
-            case NPCType::Orc:      name = "Orc_" + std::to_string(i + 1);      break;
-            case NPCType::Squirrel: name = "Squirrel_" + std::to_string(i + 1); break;
-        }
-
-        auto npc = createNPC(
-            t,
-            name,
-            random_coord(0, MAP_X),
-            random_coord(0, MAP_Y)
-        );
+    NPCStore store(npcs);
+    InteractionManager::instance().setStore(&store);
+    int npcCount = std::max(0, numberFlag(argc, argv, "--npcs", 50));
+    if (playbackPath) npcCount = 0;  // the world stays empty, frames come from the file
 
+    NPCFactory factory;
+    auto makeNPC = [&]() {
+        auto npc = factory.make();
         // npc->subscribe(consoleObs);
         npc->subscribe(fileObs);
-        npcs.push_back(npc);
+        return npc;
+    };
+
+    {
+        MemoryScope scope(MemSubsystem::World);
+        for (int i = 0; i < npcCount; ++i)
+            store.spawn(makeNPC());
     }
 
-#ifndef PIXELRPG_HEADLESS
+    // ---- Offline frame export (software rasterizer, no window needed) ----
+    std::unique_ptr<FrameExporter> exporter;
+    if (const char* dir = flagValue(argc, argv, "--export-frames")) {
+        FrameExportConfig cfg;
+        cfg.directory = dir;
+        cfg.fps = std::max(0.1, numberFlag(argc, argv, "--export-fps", cfg.fps));
+        if (const char* size = flagValue(argc, argv, "--export-size")) {
+            if (!parse_frame_size(size, cfg.width, cfg.height)) {
+                std::cerr << "Invalid --export-size '" << size << "', expected WIDTHxHEIGHT\n";
+                return 1;
+            }
+        }
+        if (const char* format = flagValue(argc, argv, "--export-format"))
+            cfg.format = std::string(format) == "ppm" ? ImageFormat::PPM : ImageFormat::PNG;
+        cfg.threads = numberFlag(argc, argv, "--export-threads", cfg.threads);
+        exporter = std::make_unique<FrameExporter>(cfg);
+    }
+
+    // ---- Live ASCII view for headless servers (diffed, one write per frame) ----
+    std::unique_ptr<TerminalView> ttyView;
+    if (const char* size = flagValue(argc, argv, "--tty-view")) {
+        if (!headless || exporter) {
+            std::cerr << "--tty-view needs --headless and cannot be combined with --export-frames\n";
+            return 1;
+        }
+        TerminalViewConfig cfg;
+        if (!parse_frame_size(size, cfg.cols, cfg.rows)) {
+            std::cerr << "Invalid --tty-view '" << size << "', expected COLSxROWS\n";
+            return 1;
+        }
+        cfg.hz = std::clamp(numberFlag(argc, argv, "--tty-hz", cfg.hz), 1.0, 120.0);
+        cfg.cell = numberFlag(argc, argv, "--tty-cell", cfg.cell);
+        if (const char* origin = flagValue(argc, argv, "--tty-origin")) {
+            if (std::sscanf(origin, "%f,%f", &cfg.origin_x, &cfg.origin_y) != 2) {
+                std::cerr << "Invalid --tty-origin '" << origin << "', expected X,Y\n";
+                return 1;
+            }
+        }
+        ttyView = std::make_unique<TerminalView>(cfg, static_cast<float>(MAP_X), static_cast<float>(MAP_Y));
+    }
+
+    // The visual observer is SFML-free: the window and the exporter both consume it
+    const bool rendering = !headless || exporter;
     auto visualObserver = VisualObserver::get();
-    if (!headless) {
+    if (rendering) {
         for (auto& npc : npcs)
             npc->subscribe(visualObserver);
+
+        if (flagValue(argc, argv, "--particle-budget")) {
+            std::static_pointer_cast<VisualObserver>(visualObserver)
+                ->setParticleBudget(numberFlag<std::size_t>(argc, argv, "--particle-budget", 0));
+        }
     }
-#endif
 
     print_all(npcs);
 
     std::atomic<bool> running{true};
     std::atomic<bool> paused{false};
 
+    // Simulation time runs at an adjustable multiple of wall time (1-4 keys in the viewer)
+    SimulationClock simClock;
+    if (const char* speed = flagValue(argc, argv, "--sim-speed")) {
+        simClock.setSpeed(std::string(speed) == "max" ? SimulationClock::UNTHROTTLED
+                                                      : numberFlag(argc, argv, "--sim-speed", 1.0f));
+    }
+
+    // Two-phase combat evaluates every pair against start-of-tick state, so the
+    // outcome of a tick no longer depends on the order pairs were detected in
+    InteractionManager::instance().setCombatMode(combatMode);
+
+    // Snapshots are only consumed by the GUI, the exporter or the terminal view;
+    // plain headless runs skip publishing
+    SnapshotPublisher snapshots;
+    SnapshotPublisher* publisher = rendering || ttyView ? &snapshots : nullptr;
+    if (publisher) {
+        publisher->setClock(&simClock);
+        publisher->publish(npcs, true);
+    }
+
+    // Playback frames advance one per TICK_MS of simulation time, so --sim-speed,
+    // the 1-4 keys and Space work as in a live run; [ ] and PageUp/PageDown seek
+    std::unique_ptr<TrajectoryPlayer> player;
+    std::uint64_t playbackStart = 0;
+    if (playbackPath) {
+        player = std::make_unique<TrajectoryPlayer>(playbackReader, snapshots, simClock);
+        playbackStart = numberFlag(argc, argv, "--playback-start", playbackStart);
+    }
+
 #ifndef PIXELRPG_HEADLESS
     // IMPORTANT (macOS): VisualWrapper / SFML window MUST be created on the main thread.
     std::unique_ptr<VisualWrapper> visualWrapper;
@@ -80,9 +349,13 @@ int main(int argc, char** argv) {
             std::cerr << "Failed to initialize visual wrapper\n";
             return 1;
         }
-        visualWrapper->setNPCs(npcs);
+        visualWrapper->setSnapshotSource(publisher);
         visualWrapper->setPausedPtr(&paused);
         visualWrapper->setRunningPtr(&running);
+        visualWrapper->setSimulationClock(&simClock);
+        if (player) visualWrapper->setSeekHandler([&player](std::int64_t delta) { player->requestSeek(delta); });
+        if (flagValue(argc, argv, "--target-fps"))
+            visualWrapper->setTargetFps(numberFlag(argc, argv, "--target-fps", 0.0));
         visualWrapper->setEffectsCVPtr(
             InteractionManager::instance().getEffectsCV(),
             InteractionManager::instance().getCVMtx()
@@ -90,81 +363,104 @@ int main(int argc, char** argv) {
     }
 #endif
 
-    // ---- Interaction thread ----
-    std::thread interaction_thread(std::ref(InteractionManager::instance()));
+    // ---- Tick pipeline: compact -> move -> index -> detect -> resolve -> notify -> publish ----
+    // Phases run as tasks on a work-stealing pool sized to the machine (--threads);
+    // the simulation thread joins in and each phase ends with a barrier.
+    const unsigned threads = numberFlag(argc, argv, "--threads", 0u);
+    JobSystem jobs(threads);
+    TickScheduler scheduler(store, jobs, MAP_X, MAP_Y, CELL_SIZE);
+    scheduler.setPublisher(publisher);
+    scheduler.setSeed(rng()());
+    // reinforcements per second of simulation time
+    const double spawnRate = std::max(0.0, numberFlag(argc, argv, "--spawn-rate", 0.0));
+    double spawnDebt = 0;
 
-    // ---- Move + detect thread ----
-    std::thread move_thread([&]() {
-        while (running) {
-            if (paused) {
-                std::this_thread::sleep_for(100ms);
-                continue;
-            }
-
-            // Move NPCs
-            for (auto& npc : npcs) {
-                if (!npc->is_alive()) continue;
-                int d = npc->get_move_distance();
-                npc->move(
-                    std::rand() % (2 * d + 1) - d,
-                    std::rand() % (2 * d + 1) - d,
-                    MAP_X, MAP_Y
-                );
-            }
+    // Per-tick world hashes ("tick hash" lines) for comparing runs
+    std::ofstream hashLog;
+    if (const char* path = flagValue(argc, argv, "--hash-log")) {
+        hashLog.open(path, std::ios::trunc);
+        if (!hashLog.good()) {
+            std::cerr << "Cannot write --hash-log " << path << "\n";
+            return 1;
+        }
+        scheduler.setHashing(true);
+    }
 
-            // Grid and interactions
-            std::unordered_map<std::pair<int, int>, std::vector<std::shared_ptr<NPC>>, PairHash> grid;
-            for (auto& npc : npcs) {
-                if (!npc->is_alive()) continue;
-                grid[npc->grid_cell].push_back(npc);
-            }
+    // Compact per-tick recording of the world for --playback: delta/varint frames,
+    // a keyframe every --record-keyframe ticks and a seek index at the end
+    std::unique_ptr<TrajectoryRecorder> recorder;
+    if (const char* path = flagValue(argc, argv, "--record")) {
+        const auto keyframe = numberFlag<std::uint32_t>(argc, argv, "--record-keyframe", 64);
+        recorder = std::make_unique<TrajectoryRecorder>(path, keyframe, MAP_X, MAP_Y);
+        if (!recorder->good()) {
+            std::cerr << "Cannot write --record " << path << "\n";
+            return 1;
+        }
+        scheduler.setRecorder(recorder.get());
+    }
 
-            for (const auto& [cell, cell_npcs] : grid) {
-                // Inside the same cell
-                for (size_t i = 0; i < cell_npcs.size(); ++i)
-                    for (size_t j = i + 1; j < cell_npcs.size(); ++j) {
-                        int maxDist = std::max(cell_npcs[i]->get_interaction_distance(),
-                                               cell_npcs[j]->get_interaction_distance());
-                        if (cell_npcs[i]->is_close(cell_npcs[j], maxDist))
-                            InteractionManager::instance().push({cell_npcs[i], cell_npcs[j]});
-                    }
-
-                // Neighbor cells (4 directions)
-                std::array<std::pair<int, int>, 4> neighbors = {{{1, 0}, {1, 1}, {0, 1}, {-1, 1}}};
-                for (auto offset : neighbors) {
-                    auto neigh_cell = std::pair<int, int>{cell.first + offset.first, cell.second + offset.second};
-                    auto it = grid.find(neigh_cell);
-                    if (it != grid.end()) {
-                        for (auto& npc1 : cell_npcs)
-                            for (auto& npc2 : it->second) {
-                                int maxDist = std::max(npc1->get_interaction_distance(),
-                                                       npc2->get_interaction_distance());
-                                if (npc1->is_close(npc2, maxDist))
-                                    InteractionManager::instance().push({npc1, npc2});
-                            }
-                    }
-                }
-            }
+    // Prometheus text file rewritten every --metrics-interval seconds of wall time
+    // (and once more at shutdown), e.g. for node_exporter's textfile collector
+    std::unique_ptr<MetricsFileExporter> metricsExporter;
+    if (const char* path = flagValue(argc, argv, "--metrics-file")) {
+        const double interval = numberFlag(argc, argv, "--metrics-interval", 5.0);
+        metricsExporter = std::make_unique<MetricsFileExporter>(path, interval);
+    }
 
-            std::this_thread::sleep_for(500ms);
+    std::thread sim_thread([&]() {
+        trace_thread_name("simulation");
+        if (player) {
+            // Without a window the run ends with the recording; the window pauses on the last frame
+            player->run(playbackStart, running, paused, headless);
+            return;
         }
-    });
-
-    std::thread timer_thread([&]() {
-        auto start = std::chrono::steady_clock::now();
+        const auto start = std::chrono::steady_clock::now();
         const auto duration = 30s;
 
         while (running) {
-            auto elapsed = std::chrono::steady_clock::now() - start;
-            if (elapsed >= duration) {
+            if (tickLimit && scheduler.ticks() >= tickLimit) {
+                // The tick pipeline summary at shutdown reports the tick count
+                running = false;
+                break;
+            }
+            if (!tickLimit && std::chrono::steady_clock::now() - start >= duration) {
                 std::cout << "[DEBUG] Timer expired (30s). Shutting down...\n";
                 running = false;
                 break;
             }
-            std::this_thread::sleep_for(100ms);
+
+            simClock.setPaused(paused);
+            if (paused) {
+                std::this_thread::sleep_for(100ms);
+                continue;
+            }
+
+            // One tick per TICK_MS of simulation time
+            if (!simClock.waitForNextTick(running)) break;
+
+            // Reinforcements join between ticks and take over freed slots
+            spawnDebt += spawnRate * SimulationClock::TICK_MS / 1000.0;
+            for (; spawnDebt >= 1.0; spawnDebt -= 1.0) {
+                MemoryScope scope(MemSubsystem::World);
+                auto npc = makeNPC();
+                if (rendering) npc->subscribe(visualObserver);
+                store.spawn(npc);
+            }
+
+            scheduler.tick();
+            if (hashLog.is_open()) {
+                hashLog << scheduler.ticks() << ' ';
+                state_hash::write_hex(hashLog, scheduler.last().world_hash) << '\n';
+            }
         }
     });
 
+    std::thread export_thread;
+    if (exporter) {
+        exporter->setClock(&simClock);
+        export_thread = std::thread([&]() { exporter->run(snapshots, running); });
+    }
+
 #ifndef PIXELRPG_HEADLESS
     // ---- Visual loop on MAIN thread (macOS requirement) ----
     if (!headless && visualWrapper) {
@@ -173,15 +469,30 @@ int main(int argc, char** argv) {
     }
 #endif
 
+    // Without a window the run lasts until the simulation timer expires
+    if (ttyView) ttyView->run(snapshots, running);
+    sim_thread.join();
+
     // ---- Shutdown ----
     running = false;
 
-    timer_thread.join();
-    move_thread.join();
+    if (export_thread.joinable()) export_thread.join();
+    metricsExporter.reset();  // final dump
 
-    InteractionManager::instance().stop();
-    interaction_thread.join();
-
-    print_survivors(npcs);
+    if (player) {
+        player->printSummary();
+    } else {
+        print_survivors(npcs);
+        scheduler.printSummary();
+    }
+    if (recorder) {
+        recorder->finish();
+        recorder->printSummary();
+    }
+    print_memory_report(npcs.size());
+    print_lock_report();
+    if (exporter) exporter->printSummary();
+    if (ttyView) ttyView->printSummary();
+    if (tracePath) trace_write(tracePath);
     return 0;
 }
@@ -0,0 +1,201 @@
+#include "../include/batch_runner.h"
+#include "../include/job_system.h"
+#include "../include/sim_clock.h"
+#include "../include/tick_scheduler.h"
+#include "../include/trace.h"
+#include "../include/world_context.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+// Убийства по типу убившего; у каждого мира свой счётчик
+class KillTally : public IInteractionObserver {
+public:
+    explicit KillTally(std::array<std::uint32_t, NPC_TYPE_COUNT>& kills) : kills(kills) {}
+
+    void on_interaction(const NPCStore& world, NPCHandle actor, NPCHandle, InteractionOutcome outcome) override {
+        if (outcome != InteractionOutcome::TargetKilled) return;
+        if (const NPC* npc = world.get(actor)) kills[static_cast<std::size_t>(npc->type)]++;
+    }
+
+private:
+    std::array<std::uint32_t, NPC_TYPE_COUNT>& kills;
+};
+
+WorldOutcome run_world(const BatchSetup& setup, std::uint64_t seed, JobSystem& jobs) {
+    TraceZone zone("batch world");
+    WorldOutcome out;
+    out.seed = seed;
+
+    // Порядок как в main и run_lockstep: мир, зерно планировщика, подкрепления перед тиком
+    WorldContext world(seed);
+    world.interactions().setCombatMode(setup.combat);
+    world.subscribe(std::make_shared<KillTally>(out.kills));
+    auto spawn = [&] { out.spawned[static_cast<std::size_t>(world.store().get(world.spawn())->type)]++; };
+    for (int i = 0; i < setup.npcs; ++i) spawn();
+
+    TickScheduler scheduler(world.store(), jobs, MAP_X, MAP_Y, CELL_SIZE, world.interactions());
+    scheduler.setSeed(world.random().engine()());
+
+    double spawn_debt = 0;
+    for (std::uint64_t t = 0; t < setup.ticks; ++t) {
+        spawn_debt += setup.spawn_rate * SimulationClock::TICK_MS / 1000.0;
+        for (; spawn_debt >= 1.0; spawn_debt -= 1.0) spawn();
+        scheduler.tick();
+    }
+
+    for (const auto& npc : world.npcs())
+        if (npc->is_alive()) out.survivors[static_cast<std::size_t>(npc->type)]++;
+    return out;
+}
+
+struct TypeSummary {
+    double spawned_mean{0};
+    double survivors_mean{0};
+    double survivors_stddev{0};
+    std::uint32_t survivors_min{0};
+    std::uint32_t survivors_max{0};
+    double survival_rate{0};   // выживших от появившихся, по всему пакету
+    double extinct_share{0};   // миров, где тип появлялся и вымер
+    double sole_share{0};      // миров, где выжил только этот тип
+    double kills_mean{0};
+};
+
+std::array<TypeSummary, NPC_TYPE_COUNT> summarize(const std::vector<WorldOutcome>& results) {
+    std::array<TypeSummary, NPC_TYPE_COUNT> summary{};
+    if (results.empty()) return summary;
+    const double n = static_cast<double>(results.size());
+
+    for (std::size_t t = 1; t < NPC_TYPE_COUNT; ++t) {
+        TypeSummary& s = summary[t];
+        double spawned = 0, survivors = 0, squares = 0, kills = 0;
+        std::size_t extinct = 0, sole = 0;
+        s.survivors_min = results.front().survivors[t];
+        for (const WorldOutcome& r : results) {
+            spawned += r.spawned[t];
+            survivors += r.survivors[t];
+            squares += static_cast<double>(r.survivors[t]) * r.survivors[t];
+            kills += r.kills[t];
+            s.survivors_min = std::min(s.survivors_min, r.survivors[t]);
+            s.survivors_max = std::max(s.survivors_max, r.survivors[t]);
+            if (r.spawned[t] > 0 && r.survivors[t] == 0) extinct++;
+
+            bool others = false;
+            for (std::size_t o = 1; o < NPC_TYPE_COUNT; ++o) others = others || (o != t && r.survivors[o] > 0);
+            if (r.survivors[t] > 0 && !others) sole++;
+        }
+        s.spawned_mean = spawned / n;
+        s.survivors_mean = survivors / n;
+        s.survivors_stddev = std::sqrt(std::max(0.0, squares / n - s.survivors_mean * s.survivors_mean));
+        s.survival_rate = spawned > 0 ? survivors / spawned : 0;
+        s.extinct_share = static_cast<double>(extinct) / n;
+        s.sole_share = static_cast<double>(sole) / n;
+        s.kills_mean = kills / n;
+    }
+    return summary;
+}
+
+} // namespace
+
+std::vector<WorldOutcome> run_batch(const BatchSetup& setup) {
+    std::vector<WorldOutcome> results(setup.runs);
+    JobSystem jobs(setup.threads);
+    // Пул делит либо миры, либо фазы одного мира, но не то и другое сразу:
+    // wait() вложенного parallelFor подхватил бы целый чужой мир, и тик
+    // ждал бы его конца, а стек рос бы с каждым таким перехватом
+    if (setup.runs >= jobs.threadCount()) {
+        // Миров хватает на все потоки: мир — задача пула, его фазы идут в том же потоке
+        jobs.parallelFor(setup.runs, 1, [&](std::size_t begin, std::size_t end) {
+            JobSystem serial(1);
+            for (std::size_t i = begin; i < end; ++i) results[i] = run_world(setup, setup.first_seed + i, serial);
+        });
+    } else {
+        // Миров меньше, чем потоков: по очереди, фазы каждого делятся на весь пул
+        for (std::size_t i = 0; i < setup.runs; ++i) results[i] = run_world(setup, setup.first_seed + i, jobs);
+    }
+    return results;
+}
+
+bool write_batch_csv(const std::string& path, const std::vector<WorldOutcome>& results) {
+    std::ofstream f(path, std::ios::trunc);
+    if (!f.good()) return false;
+
+    const auto summary = summarize(results);
+    f << "type,runs,spawned_mean,survivors_mean,survivors_stddev,survivors_min,survivors_max,"
+         "survival_rate,extinct_share,sole_survivor_share,kills_mean\n"
+      << std::fixed << std::setprecision(4);
+    for (std::size_t t = 1; t < NPC_TYPE_COUNT; ++t) {
+        const TypeSummary& s = summary[t];
+        f << type_to_string(static_cast<NPCType>(t)) << ',' << results.size() << ',' << s.spawned_mean << ','
+          << s.survivors_mean << ',' << s.survivors_stddev << ',' << s.survivors_min << ',' << s.survivors_max << ','
+          << s.survival_rate << ',' << s.extinct_share << ',' << s.sole_share << ',' << s.kills_mean << '\n';
+    }
+    return f.good();
+}
+
+bool write_batch_runs_csv(const std::string& path, const std::vector<WorldOutcome>& results) {
+    std::ofstream f(path, std::ios::trunc);
+    if (!f.good()) return false;
+
+    f << "seed";
+    for (const char* column : {"spawned", "survivors", "kills"})
+        for (std::size_t t = 1; t < NPC_TYPE_COUNT; ++t)
+            f << ',' << column << '_' << type_to_string(static_cast<NPCType>(t));
+    f << '\n';
+    for (const WorldOutcome& r : results) {
+        f << r.seed;
+        for (const auto* counts : {&r.spawned, &r.survivors, &r.kills})
+            for (std::size_t t = 1; t < NPC_TYPE_COUNT; ++t) f << ',' << (*counts)[t];
+        f << '\n';
+    }
+    return f.good();
+}
+
+bool run_batch_study(const BatchSetup& setup, const std::string& csv_path, const std::string& runs_csv_path) {
+    using clock = std::chrono::steady_clock;
+    std::cout << "=== Batch: " << setup.runs << " worlds (seeds " << setup.first_seed << "-"
+              << setup.first_seed + setup.runs - 1 << "), " << setup.ticks << " ticks, " << setup.npcs
+              << " NPCs, spawn rate " << setup.spawn_rate << ", " << combat_mode_name(setup.combat)
+              << " combat ===\n";
+
+    const auto start = clock::now();
+    const std::vector<WorldOutcome> results = run_batch(setup);
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    const auto summary = summarize(results);
+    std::cout << std::fixed << std::setprecision(1) << seconds * 1000.0 << " ms, "
+              << results.size() / std::max(seconds, 1e-9) << " worlds/s, "
+              << static_cast<double>(results.size()) * setup.ticks / std::max(seconds, 1e-9) << " ticks/s\n"
+              << std::left << std::setw(10) << "type" << std::right << std::setw(10) << "spawned"
+              << std::setw(12) << "survivors" << std::setw(10) << "stddev" << std::setw(10) << "extinct"
+              << std::setw(8) << "sole" << std::setw(8) << "kills" << '\n';
+    for (std::size_t t = 1; t < NPC_TYPE_COUNT; ++t) {
+        const TypeSummary& s = summary[t];
+        std::cout << std::left << std::setw(10) << type_to_string(static_cast<NPCType>(t)) << std::right
+                  << std::setprecision(1) << std::setw(10) << s.spawned_mean << std::setw(12) << s.survivors_mean
+                  << std::setw(10) << s.survivors_stddev << std::setw(9) << s.extinct_share * 100 << '%'
+                  << std::setw(7) << s.sole_share * 100 << '%' << std::setw(8) << s.kills_mean << '\n';
+    }
+
+    bool ok = true;
+    if (!write_batch_csv(csv_path, results)) {
+        std::cerr << "Cannot write " << csv_path << "\n";
+        ok = false;
+    } else {
+        std::cout << "per-type summary: " << csv_path << "\n";
+    }
+    if (!runs_csv_path.empty()) {
+        if (!write_batch_runs_csv(runs_csv_path, results)) {
+            std::cerr << "Cannot write " << runs_csv_path << "\n";
+            ok = false;
+        } else {
+            std::cout << "per-world rows: " << runs_csv_path << "\n";
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,33 @@
+#include "../include/bitmap_font.h"
+
+bool TextRun::set(std::string_view str, unsigned size) {
+    if (size == font_size && str == text) return false;
+
+    text.assign(str.begin(), str.end());
+    font_size = size;
+    quads.clear();
+
+    const int scale = text_scale(size);
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == ' ') continue;
+        quads.push_back({static_cast<float>(i * FONT_CELL_W * scale), 0,
+                         static_cast<float>(FONT_GLYPH_W * scale), static_cast<float>(FONT_GLYPH_H * scale),
+                         font_glyph(text[i])});
+    }
+    return true;
+}
+
+void emit_text(RenderCommandList& out, std::string_view str, float x, float y, unsigned size, std::uint32_t color) {
+    const float scale = static_cast<float>(text_scale(size));
+    const float advance = FONT_CELL_W * scale;
+    for (char c : str) {
+        if (c != ' ')
+            out.sprite(TextureId::Atlas, font_glyph(c), x, y, FONT_GLYPH_W * scale, FONT_GLYPH_H * scale, color);
+        x += advance;
+    }
+}
+
+void emit_text(RenderCommandList& out, const TextRun& run, float x, float y, std::uint32_t color) {
+    for (const GlyphQuad& g : run.glyphs())
+        out.sprite(TextureId::Atlas, g.src, x + g.dx, y + g.dy, g.w, g.h, color);
+}
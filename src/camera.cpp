@@ -0,0 +1,53 @@
+#include "../include/camera.h"
+#include <algorithm>
+
+Camera::Camera(float w, float h) : world_w(w), world_h(h) {
+    reset();
+}
+
+Viewport Camera::view(float width, float height) const {
+    Viewport vp;
+    vp.scale_x = width / world_w * zoom_level;
+    vp.scale_y = height / world_h * zoom_level;
+    vp.offset_x = width / 2 - center_x * vp.scale_x;
+    vp.offset_y = height / 2 - center_y * vp.scale_y;
+    return vp;
+}
+
+void Camera::pan(float dx, float dy, const Viewport& vp) {
+    center_x -= dx / vp.scale_x;
+    center_y -= dy / vp.scale_y;
+    clampCenter();
+}
+
+void Camera::zoomAt(float factor, float sx, float sy, const Viewport& vp) {
+    // Точка мира под курсором должна остаться под курсором
+    const float wx = vp.toWorldX(sx);
+    const float wy = vp.toWorldY(sy);
+
+    const float old_zoom = zoom_level;
+    zoom_level = std::clamp(zoom_level * factor, MIN_ZOOM, MAX_ZOOM);
+    const float k = old_zoom / zoom_level;
+
+    center_x = wx + (center_x - wx) * k;
+    center_y = wy + (center_y - wy) * k;
+    clampCenter();
+}
+
+void Camera::reset() {
+    center_x = world_w / 2;
+    center_y = world_h / 2;
+    zoom_level = 1.0f;
+}
+
+void Camera::setWorldSize(float w, float h) {
+    world_w = w;
+    world_h = h;
+    reset();
+}
+
+// Центр не уходит за пределы мира — карту нельзя «потерять»
+void Camera::clampCenter() {
+    center_x = std::clamp(center_x, 0.0f, world_w);
+    center_y = std::clamp(center_y, 0.0f, world_h);
+}
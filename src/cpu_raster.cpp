@@ -0,0 +1,213 @@
+#include "../include/cpu_raster.h"
+#include <algorithm>
+#include <cmath>
+
+// Смешивание src-over для одного пикселя 0xRRGGBBAA (буфер кадра непрозрачен)
+static inline std::uint32_t blend(std::uint32_t dst, std::uint32_t src, unsigned a) {
+    if (a == 0) return dst;
+    if (a == 255) return src | 0xFFu;
+
+    const unsigned inv = 255 - a;
+    unsigned r = (((src >> 24) & 0xFF) * a + ((dst >> 24) & 0xFF) * inv + 127) / 255;
+    unsigned g = (((src >> 16) & 0xFF) * a + ((dst >> 16) & 0xFF) * inv + 127) / 255;
+    unsigned b = (((src >> 8) & 0xFF) * a + ((dst >> 8) & 0xFF) * inv + 127) / 255;
+    return (r << 24) | (g << 16) | (b << 8) | 0xFFu;
+}
+
+// Покомпонентное умножение цветов (модуляция текстуры цветом команды)
+static inline std::uint32_t modulate(std::uint32_t a, std::uint32_t b) {
+    if (b == 0xFFFFFFFFu) return a;
+    unsigned r = ((a >> 24) & 0xFF) * ((b >> 24) & 0xFF) / 255;
+    unsigned g = ((a >> 16) & 0xFF) * ((b >> 16) & 0xFF) / 255;
+    unsigned bl = ((a >> 8) & 0xFF) * ((b >> 8) & 0xFF) / 255;
+    unsigned al = (a & 0xFF) * (b & 0xFF) / 255;
+    return (r << 24) | (g << 16) | (bl << 8) | al;
+}
+
+// Пиксель покрыт, если в прямоугольник попадает его центр
+static inline int pixel_begin(float v) { return static_cast<int>(std::floor(v + 0.5f)); }
+
+CpuRasterBackend::CpuRasterBackend(int width, int height, unsigned threads)
+    : w(width), h(height),
+      tiles_x((width + TILE - 1) / TILE),
+      tiles_y((height + TILE - 1) / TILE),
+      framebuffer(static_cast<std::size_t>(width) * height, 0x000000FFu),
+      bins(static_cast<std::size_t>(tiles_x) * tiles_y)
+{
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Вызывающий поток тоже растеризует тайлы, поэтому рабочих на один меньше
+    for (unsigned i = 1; i < threads; ++i)
+        workers.emplace_back(&CpuRasterBackend::workerLoop, this);
+}
+
+CpuRasterBackend::~CpuRasterBackend() {
+    {
+        std::lock_guard<std::mutex> lck(pool_mtx);
+        stopping = true;
+    }
+    cv_start.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void CpuRasterBackend::setTexture(TextureId id, const PixelImage* image) {
+    textures[static_cast<std::size_t>(id)] = image;
+}
+
+void CpuRasterBackend::execute(const RenderCommandList& list) {
+    current = &list;
+    binCommands(list);
+    next_tile.store(0, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lck(pool_mtx);
+        ++generation;
+        active = static_cast<unsigned>(workers.size());
+    }
+    cv_start.notify_all();
+
+    runTiles();
+
+    std::unique_lock<std::mutex> lck(pool_mtx);
+    cv_done.wait(lck, [this] { return active == 0; });
+    current = nullptr;
+}
+
+void CpuRasterBackend::workerLoop() {
+    std::uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lck(pool_mtx);
+            cv_start.wait(lck, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        runTiles();
+
+        std::lock_guard<std::mutex> lck(pool_mtx);
+        if (--active == 0) cv_done.notify_one();
+    }
+}
+
+void CpuRasterBackend::runTiles() {
+    const int total = tiles_x * tiles_y;
+    for (int tile = next_tile.fetch_add(1); tile < total; tile = next_tile.fetch_add(1))
+        rasterTile(tile);
+}
+
+void CpuRasterBackend::binCommands(const RenderCommandList& list) {
+    for (auto& bin : bins) bin.clear();
+
+    const auto& cmds = list.commands();
+    for (std::uint32_t i = 0; i < cmds.size(); ++i) {
+        const RenderCommand& cmd = cmds[i];
+
+        float left, top, right, bottom;
+        if (cmd.type == RenderCommandType::Circle) {
+            left = cmd.x - cmd.w; top = cmd.y - cmd.w; right = cmd.x + cmd.w; bottom = cmd.y + cmd.w;
+        } else {
+            left = cmd.x; top = cmd.y; right = cmd.x + cmd.w; bottom = cmd.y + cmd.h;
+        }
+        if ((cmd.color & 0xFF) == 0 || right <= 0 || bottom <= 0 || left >= w || top >= h) continue;
+
+        int tx0 = std::clamp(static_cast<int>(left) / TILE, 0, tiles_x - 1);
+        int ty0 = std::clamp(static_cast<int>(top) / TILE, 0, tiles_y - 1);
+        int tx1 = std::clamp(static_cast<int>(right) / TILE, 0, tiles_x - 1);
+        int ty1 = std::clamp(static_cast<int>(bottom) / TILE, 0, tiles_y - 1);
+
+        for (int ty = ty0; ty <= ty1; ++ty)
+            for (int tx = tx0; tx <= tx1; ++tx)
+                bins[static_cast<std::size_t>(ty) * tiles_x + tx].push_back(i);
+    }
+}
+
+void CpuRasterBackend::rasterTile(int tile) {
+    const int x0 = (tile % tiles_x) * TILE;
+    const int y0 = (tile / tiles_x) * TILE;
+    const int x1 = std::min(x0 + TILE, w);
+    const int y1 = std::min(y0 + TILE, h);
+
+    const std::uint32_t clear = current->clear_color | 0xFFu;
+    for (int y = y0; y < y1; ++y)
+        std::fill(&framebuffer[static_cast<std::size_t>(y) * w + x0], &framebuffer[static_cast<std::size_t>(y) * w + x1], clear);
+
+    const auto& cmds = current->commands();
+    for (std::uint32_t index : bins[tile]) {
+        const RenderCommand& cmd = cmds[index];
+        if (cmd.type == RenderCommandType::Circle) {
+            fillCircle(cmd, x0, y0, x1, y1);
+        } else if (cmd.texture != TextureId::None) {
+            const PixelImage* tex = textures[static_cast<std::size_t>(cmd.texture)];
+            if (tex && !tex->pixels.empty())
+                fillTexturedQuad(cmd, *tex, x0, y0, x1, y1);
+            else
+                fillQuad(cmd, x0, y0, x1, y1);
+        } else {
+            fillQuad(cmd, x0, y0, x1, y1);
+        }
+    }
+}
+
+void CpuRasterBackend::fillQuad(const RenderCommand& cmd, int x0, int y0, int x1, int y1) {
+    const int px0 = std::max(x0, pixel_begin(cmd.x));
+    const int py0 = std::max(y0, pixel_begin(cmd.y));
+    const int px1 = std::min(x1, pixel_begin(cmd.x + cmd.w));
+    const int py1 = std::min(y1, pixel_begin(cmd.y + cmd.h));
+    const unsigned a = cmd.color & 0xFF;
+
+    for (int y = py0; y < py1; ++y) {
+        std::uint32_t* row = &framebuffer[static_cast<std::size_t>(y) * w];
+        for (int x = px0; x < px1; ++x)
+            row[x] = blend(row[x], cmd.color, a);
+    }
+}
+
+void CpuRasterBackend::fillTexturedQuad(const RenderCommand& cmd, const PixelImage& tex, int x0, int y0, int x1, int y1) {
+    const int px0 = std::max(x0, pixel_begin(cmd.x));
+    const int py0 = std::max(y0, pixel_begin(cmd.y));
+    const int px1 = std::min(x1, pixel_begin(cmd.x + cmd.w));
+    const int py1 = std::min(y1, pixel_begin(cmd.y + cmd.h));
+    if (cmd.w <= 0 || cmd.h <= 0) return;
+
+    // Область текстуры: весь образ или прямоугольник атласа
+    const int src_x = cmd.src.w > 0 ? cmd.src.x : 0;
+    const int src_y = cmd.src.w > 0 ? cmd.src.y : 0;
+    const int src_w = cmd.src.w > 0 ? cmd.src.w : tex.width;
+    const int src_h = cmd.src.w > 0 ? cmd.src.h : tex.height;
+
+    // Ближайший тексель — пиксель-арт не размываем
+    const float su = src_w / cmd.w;
+    const float sv = src_h / cmd.h;
+
+    for (int y = py0; y < py1; ++y) {
+        int v = src_y + std::clamp(static_cast<int>((y + 0.5f - cmd.y) * sv), 0, src_h - 1);
+        std::uint32_t* row = &framebuffer[static_cast<std::size_t>(y) * w];
+        for (int x = px0; x < px1; ++x) {
+            int u = src_x + std::clamp(static_cast<int>((x + 0.5f - cmd.x) * su), 0, src_w - 1);
+            std::uint32_t texel = modulate(tex.get(u, v), cmd.color);
+            row[x] = blend(row[x], texel, texel & 0xFF);
+        }
+    }
+}
+
+void CpuRasterBackend::fillCircle(const RenderCommand& cmd, int x0, int y0, int x1, int y1) {
+    const float r = cmd.w;
+    const int py0 = std::max(y0, pixel_begin(cmd.y - r));
+    const int py1 = std::min(y1, pixel_begin(cmd.y + r));
+    const unsigned a = cmd.color & 0xFF;
+
+    // Построчно: ширина хорды вычисляется один раз на строку
+    for (int y = py0; y < py1; ++y) {
+        float dy = y + 0.5f - cmd.y;
+        float half = r * r - dy * dy;
+        if (half <= 0) continue;
+        half = std::sqrt(half);
+
+        int px0 = std::max(x0, pixel_begin(cmd.x - half));
+        int px1 = std::min(x1, pixel_begin(cmd.x + half));
+        std::uint32_t* row = &framebuffer[static_cast<std::size_t>(y) * w];
+        for (int x = px0; x < px1; ++x)
+            row[x] = blend(row[x], cmd.color, a);
+    }
+}
@@ -0,0 +1,84 @@
+#include "../include/density_heatmap.h"
+#include "../include/render_commands.h"
+#include <algorithm>
+#include <array>
+
+// Цвета типов на тепловой карте (в тон спрайтам)
+static std::uint32_t heat_color(NPCType type) {
+    switch (type) {
+        case NPCType::Orc:      return rgba(220, 60, 50);
+        case NPCType::Squirrel: return rgba(80, 220, 80);
+        case NPCType::Bear:     return rgba(160, 110, 60);
+        case NPCType::Druid:    return rgba(60, 220, 230);
+        case NPCType::Dragon:   return rgba(255, 160, 20);
+        default:                return rgba(255, 255, 255);
+    }
+}
+
+void DensityHeatmap::update(const SnapshotGrid& grid, const std::vector<NPCRenderState>& npcs) {
+    changed = 0;
+    const int cols = grid.columns();
+    const int rows = grid.rowCount();
+
+    if (img.width != cols || img.height != rows) {
+        img = PixelImage(cols, rows, 0);
+        dirty_x0 = 0;
+        dirty_y0 = 0;
+        dirty_x1 = cols - 1;
+        dirty_y1 = rows - 1;
+    }
+
+    const auto& entries = grid.entries();
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            std::array<int, static_cast<std::size_t>(NPCType::Count)> counts{};
+            int total = 0;
+            for (std::uint32_t i = grid.cellBegin(c, r); i < grid.cellEnd(c, r); ++i) {
+                const NPCRenderState& npc = npcs[entries[i]];
+                if (!npc.alive) continue;
+                counts[static_cast<std::size_t>(npc.type)]++;
+                total++;
+            }
+
+            std::uint32_t color = 0;
+            if (total > 0) {
+                std::size_t best = static_cast<std::size_t>(std::max_element(counts.begin(), counts.end()) - counts.begin());
+                // Одиночный NPC — полупрозрачный, от восьми и выше — непрозрачный
+                int alpha = std::min(255, 96 + total * 20);
+                color = with_alpha(heat_color(static_cast<NPCType>(best)), static_cast<std::uint8_t>(alpha));
+            }
+
+            std::uint32_t& texel = img.pixels[static_cast<std::size_t>(r) * cols + c];
+            if (texel != color) {
+                texel = color;
+                markDirty(c, r);
+                changed++;
+            }
+        }
+    }
+}
+
+void DensityHeatmap::markDirty(int x, int y) {
+    if (dirty_x1 < dirty_x0) {
+        dirty_x0 = dirty_x1 = x;
+        dirty_y0 = dirty_y1 = y;
+        return;
+    }
+    dirty_x0 = std::min(dirty_x0, x);
+    dirty_y0 = std::min(dirty_y0, y);
+    dirty_x1 = std::max(dirty_x1, x);
+    dirty_y1 = std::max(dirty_y1, y);
+}
+
+DensityHeatmap::DirtyRect DensityHeatmap::takeDirty() {
+    DirtyRect rect;
+    if (dirty_x1 >= dirty_x0 && dirty_y1 >= dirty_y0) {
+        rect.x = dirty_x0;
+        rect.y = dirty_y0;
+        rect.w = dirty_x1 - dirty_x0 + 1;
+        rect.h = dirty_y1 - dirty_y0 + 1;
+    }
+    dirty_x0 = dirty_y0 = 0;
+    dirty_x1 = dirty_y1 = -1;
+    return rect;
+}
@@ -0,0 +1,76 @@
+#include "../include/effect_store.h"
+#include <algorithm>
+
+void EffectStore::add(EffectType type, float x, float y, float duration_ms, std::uint32_t rgba, std::int64_t now_ms) {
+    if (next_bucket < 0) next_bucket = now_ms / BUCKET_MS;
+
+    std::uint32_t index;
+    if (!free_slots.empty()) {
+        index = free_slots.back();
+        free_slots.pop_back();
+    } else {
+        index = static_cast<std::uint32_t>(effects.size());
+        effects.emplace_back();
+    }
+
+    VisualEffect& e = effects[index];
+    e.type = type;
+    e.x = x;
+    e.y = y;
+    e.rgba = rgba;
+    e.start_ms = now_ms;
+    e.end_ms = now_ms + std::max<std::int64_t>(1, static_cast<std::int64_t>(duration_ms));
+    e.active = true;
+    active_count++;
+
+    schedule(index);
+}
+
+void EffectStore::schedule(std::uint32_t index) {
+    std::int64_t bucket = effects[index].end_ms / BUCKET_MS;
+
+    // Уже прошедшее время — в ближайшую корзину; слишком далёкое —
+    // в последнюю корзину горизонта, откуда эффект будет перенесён снова
+    bucket = std::clamp<std::int64_t>(bucket, next_bucket, next_bucket + static_cast<std::int64_t>(BUCKETS) - 1);
+    buckets[static_cast<std::size_t>(bucket) % BUCKETS].push_back(index);
+}
+
+void EffectStore::expire(std::int64_t now_ms) {
+    if (next_bucket < 0) return;
+
+    const std::int64_t now_bucket = now_ms / BUCKET_MS;
+    for (std::size_t steps = 0; next_bucket < now_bucket && steps < BUCKETS; ++steps) {
+        auto& bucket = buckets[static_cast<std::size_t>(next_bucket) % BUCKETS];
+        ++next_bucket;
+
+        // Корзина разбирается целиком: истёкшие эффекты освобождаются,
+        // остальные (дальше горизонта) перекладываются вперёд
+        scratch.clear();
+        for (std::uint32_t index : bucket) {
+            VisualEffect& e = effects[index];
+            if (e.end_ms <= now_ms) {
+                e.active = false;
+                free_slots.push_back(index);
+                active_count--;
+            } else {
+                scratch.push_back(index);
+            }
+        }
+        bucket.clear();
+
+        for (std::uint32_t index : scratch)
+            schedule(index);
+    }
+
+    // Долгий простой (пауза, свёрнутое окно): все корзины уже разобраны один раз
+    if (next_bucket < now_bucket) next_bucket = now_bucket;
+}
+
+void EffectStore::clear() {
+    effects.clear();
+    free_slots.clear();
+    scratch.clear();
+    for (auto& b : buckets) b.clear();
+    next_bucket = -1;
+    active_count = 0;
+}
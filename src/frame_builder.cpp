@@ -0,0 +1,393 @@
+#include "../include/frame_builder.h"
+#include "../include/bitmap_font.h"
+#include "../include/game_utils.h"
+#include "../include/sprite_atlas.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+static std::uint8_t alpha_of(float value) {
+    if (value <= 0.0f) return 0;
+    if (value >= 255.0f) return 255;
+    return static_cast<std::uint8_t>(value);
+}
+
+FrameBuilder::FrameBuilder()
+    : world_w(static_cast<float>(MAP_X)), world_h(static_cast<float>(MAP_Y)), cam(world_w, world_h)
+{
+}
+
+void FrameBuilder::setWorldSize(float w, float h) {
+    world_w = w;
+    world_h = h;
+    cam.setWorldSize(w, h);
+    indexed_version = 0;
+}
+
+void FrameBuilder::build(const FrameSnapshot& snap,
+                         VisualObserver& obs,
+                         std::chrono::steady_clock::time_point now,
+                         float width, float height,
+                         const std::string& message,
+                         RenderCommandList& out)
+{
+    out.clear();
+    out.width = width;
+    out.height = height;
+    out.clear_color = rgba(40, 45, 60);  // фон — просто цвет очистки, без текстуры
+    last_stats = FrameBuildStats{};
+
+    const Viewport vp = cam.view(width, height);
+    const std::int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+
+    // Один коэффициент интерполяции на весь кадр. 300 мс из 500-мс тика —
+    // по времени симуляции, так что ускорение не ломает плавность
+    const float t = sim_clock ? snapshot_interpolation(snap, sim_clock->now(), 300.0f)
+                              : snapshot_interpolation(snap, now, 300.0f);
+
+    obs.consumeEvents(snap, t, now_ms);
+
+    // Пространственный индекс строится раз на снимок, а не на кадр
+    if (snap.version != indexed_version) {
+        grid.build(snap.npcs, world_w, world_h, INDEX_CELL);
+        indexed_version = snap.version;
+        density_stale = true;
+    }
+
+    if (std::min(vp.scale_x, vp.scale_y) < HEATMAP_SCALE) {
+        // Сильное отдаление: одна текстура на весь мир
+        if (density_stale) {
+            density.update(grid, snap.npcs);
+            density_stale = false;
+        }
+        const float cell_w = grid.cellSize() * vp.scale_x;
+        const float cell_h = grid.cellSize() * vp.scale_y;
+        out.texturedQuad(TextureId::Heatmap, vp.toScreenX(0), vp.toScreenY(0),
+                         grid.columns() * cell_w, grid.rowCount() * cell_h);
+        out.outline(vp.toScreenX(0), vp.toScreenY(0), world_w * vp.scale_x, world_h * vp.scale_y, 1, rgba(120, 120, 160));
+        last_stats.heatmap = true;
+    } else {
+        emitVisibleNPCs(out, snap, vp, t, width, height);
+    }
+
+    emitEffects(out, obs.effects(), now_ms, vp);
+    emitParticles(out, obs.particles(), vp);
+    emitHud(out, message, snap.alive_count, snap.dead_count, sim_clock ? sim_clock->speed() : 1.0f);
+
+    last_stats.commands = out.size();
+}
+
+void FrameBuilder::emitVisibleNPCs(RenderCommandList& out, const FrameSnapshot& snap, const Viewport& vp,
+                                   float t, float width, float height)
+{
+    // Спрайт 32x32 с подписью и полоской здоровья выходит за точку NPC
+    // примерно на 32 пикселя — всё, что дальше от экрана, отбрасываем
+    const float margin = 40.0f;
+    auto visible = [&](float sx, float sy) {
+        return sx >= -margin && sy >= -margin && sx <= width + margin && sy <= height + margin;
+    };
+
+    // Индекс хранит конечные позиции тика; интерполированная позиция
+    // отстаёт от них не больше чем на maxDisplacement
+    const float pad_x = margin / vp.scale_x + grid.maxDisplacement();
+    const float pad_y = margin / vp.scale_y + grid.maxDisplacement();
+    visible_ids.clear();
+    grid.query(vp.toWorldX(0) - pad_x, vp.toWorldY(0) - pad_y,
+               vp.toWorldX(width) + pad_x, vp.toWorldY(height) + pad_y,
+               [&](std::uint32_t i) { visible_ids.push_back(i); });
+
+    // Сначала рисуем трупы (на заднем плане), потом живых NPC
+    for (int pass = 0; pass < 2; ++pass) {
+        const bool alive_pass = pass == 1;
+        for (std::uint32_t i : visible_ids) {
+            const NPCRenderState& npc = snap.npcs[i];
+            if (npc.alive != alive_pass) continue;
+
+            float screen_x = vp.toScreenX(npc.prev_x + (npc.x - npc.prev_x) * t);
+            float screen_y = vp.toScreenY(npc.prev_y + (npc.y - npc.prev_y) * t);
+            if (!visible(screen_x, screen_y)) continue;
+
+            if (alive_pass) emitNPC(out, npc, screen_x, screen_y);
+            else emitCorpse(out, npc, screen_x, screen_y);
+        }
+    }
+
+    const std::size_t total = static_cast<std::size_t>(snap.alive_count + snap.dead_count);
+    last_stats.culled = total - std::min(total, last_stats.sprites + last_stats.corpses);
+}
+
+void FrameBuilder::emitCorpse(RenderCommandList& out, const NPCRenderState& npc, float screen_x, float screen_y) {
+    // Крест для трупа
+    const std::uint32_t corpseColor = rgba(100, 0, 0, 200);
+    out.quad(screen_x - 8, screen_y - 1.5f, 16, 3, corpseColor);
+    out.quad(screen_x - 1.5f, screen_y - 8, 3, 16, corpseColor);
+
+    emit_text(out, std::string_view(npc.name).substr(0, 8), screen_x, screen_y - 25, 10, rgba(150, 150, 150, 150));
+    last_stats.corpses++;
+}
+
+void FrameBuilder::emitNPC(RenderCommandList& out, const NPCRenderState& npc, float screen_x, float screen_y) {
+    // Центр спрайта 32x32
+    out.sprite(TextureId::Atlas, atlas_sprite(npc.type), screen_x - 16, screen_y - 16, 32, 32);
+
+    emitHealthBar(out, screen_x, screen_y, npc.health, npc.max_health);
+
+    emit_text(out, std::string_view(npc.name).substr(0, 10), screen_x - 20, screen_y + 18, 10, rgba(255, 255, 255));
+    last_stats.sprites++;
+}
+
+void FrameBuilder::emitHealthBar(RenderCommandList& out, float screen_x, float screen_y, int hp, int maxHp) {
+    float ratio = static_cast<float>(hp) / maxHp;
+
+    float barWidth = 32.0f;
+    float barHeight = 5.0f;
+    float x = screen_x - barWidth / 2;
+    float y = screen_y - 20; // Поднимаем выше, чтобы не перекрывать спрайт
+
+    out.outline(x, y, barWidth, barHeight, 0.5f, rgba(60, 60, 60));
+    out.quad(x, y, barWidth, barHeight, rgba(0, 0, 0, 180));
+
+    std::uint32_t fillColor;
+    if (ratio > 0.6f)       fillColor = rgba(70, 255, 70);
+    else if (ratio > 0.3f)  fillColor = rgba(255, 200, 50);
+    else                    fillColor = rgba(255, 70, 50);
+
+    out.quad(x, y, barWidth * ratio, barHeight, fillColor);
+}
+
+void FrameBuilder::emitEffects(RenderCommandList& out, const EffectStore& effects, std::int64_t now_ms, const Viewport& vp) {
+    effects.forEach(now_ms, [&](const VisualEffect& effect) {
+        float screen_x = vp.toScreenX(effect.x);
+        float screen_y = vp.toScreenY(effect.y);
+        float progress = effect.progress(now_ms);
+
+        switch (effect.type) {
+            case EffectType::Kill:
+                emitKillEffect(out, screen_x, screen_y, progress);
+                break;
+            case EffectType::Hurt:
+                emitHurtEffect(out, screen_x, screen_y, progress);
+                break;
+            case EffectType::Escape:
+                emitEscapeEffect(out, screen_x, screen_y, progress);
+                break;
+            case EffectType::Heal:
+                emitHealEffect(out, screen_x, screen_y, progress);
+                break;
+        }
+        last_stats.effects++;
+    });
+}
+
+void FrameBuilder::emitParticles(RenderCommandList& out, const ParticlePool& pool, const Viewport& vp) {
+    const std::size_t n = pool.size();
+    const float* xs = pool.xs();
+    const float* ys = pool.ys();
+    const std::uint32_t* colors = pool.colors();
+
+    // Квадраты 4x4 идут подряд и собираются бэкендом в один вершинный буфер.
+    // На низком качестве рисуем каждую вторую частицу.
+    const std::size_t stride = effect_quality < 0.3f ? 2 : 1;
+    for (std::size_t i = 0; i < n; i += stride) {
+        float screen_x = vp.toScreenX(xs[i]);
+        float screen_y = vp.toScreenY(ys[i]);
+        out.quad(screen_x - 2, screen_y - 2, 4, 4, with_alpha(colors[i], alpha_of(255 * pool.alpha(i))));
+    }
+    last_stats.particles = n;
+}
+
+void FrameBuilder::emitHud(RenderCommandList& out, const std::string& message, int alive, int dead, float speed) {
+    // Раскладка глифов HUD кэшируется и пересчитывается только при смене текста
+    if (!message.empty()) {
+        message_run.set(message, 16);
+        float boxWidth = message_run.width() + 20;
+        out.quad(10, 10, boxWidth, 40, rgba(0, 0, 0, 180));
+        out.outline(10, 10, boxWidth, 40, 1, rgba(255, 255, 255));
+        emit_text(out, message_run, 20, 10 + (40 - message_run.height()) / 2, rgba(255, 255, 255));
+    }
+
+    // Строка статистики собирается заново только при изменении счётчиков или скорости
+    if (alive != hud_alive || dead != hud_dead || speed != hud_speed) {
+        hud_alive = alive;
+        hud_dead = dead;
+        hud_speed = speed;
+        std::string line = "Alive: " + std::to_string(alive) + " | Dead: " + std::to_string(dead);
+        if (speed != 1.0f) line += std::string(" | ") + speed_label(speed);
+        stats_run.set(line, 14);
+    }
+    float statsWidth = std::max(200.0f, stats_run.width() + 20);
+    out.quad(10, out.height - 40, statsWidth, 30, rgba(0, 0, 0, 150));
+    out.outline(10, out.height - 40, statsWidth, 30, 1, rgba(0, 255, 255));
+    emit_text(out, stats_run, 20, out.height - 40 + (30 - stats_run.height()) / 2, rgba(255, 255, 255));
+}
+
+static std::uint32_t phase_color(FramePhase phase) {
+    switch (phase) {
+        case FramePhase::Events:   return rgba(160, 160, 160);
+        case FramePhase::Snapshot: return rgba(190, 120, 255);
+        case FramePhase::Build:    return rgba(255, 160, 40);
+        case FramePhase::Draw:     return rgba(80, 220, 100);
+        case FramePhase::Display:  return rgba(80, 160, 255);
+        case FramePhase::Idle:     return rgba(70, 75, 95);
+        case FramePhase::Count:    break;
+    }
+    return rgba(255, 255, 255);
+}
+
+void FrameBuilder::emitTimingOverlay(RenderCommandList& out, const FrameTimer& timer, const FramePacer& pacer) {
+    // Столбик на кадр: фазы друг над другом, 3 пикселя на миллисекунду
+    constexpr float BAR_W = 2.0f;
+    constexpr float GRAPH_W = FrameTimer::HISTORY * BAR_W;
+    constexpr float GRAPH_H = 100.0f;
+    constexpr float PX_PER_MS = 3.0f;
+    constexpr float HIST_H = 30.0f;
+
+    const float x0 = out.width - GRAPH_W - 20;
+    const float y0 = 10;
+    out.quad(x0, y0, GRAPH_W + 10, 196, rgba(0, 0, 0, 190));
+    out.outline(x0, y0, GRAPH_W + 10, 196, 1, rgba(120, 120, 160));
+    const float gx = x0 + 5;
+
+    // Подписи пересчитываются раз в 15 кадров — форматирование не на каждом кадре
+    if (timing_frames++ % 15 == 0) {
+        char buf[96];
+        const float avg = timer.percentile(0.5f);
+        std::snprintf(buf, sizeof(buf), "%5.1f fps  p50 %4.1f  p99 %4.1f ms  Q%d",
+                      avg > 0 ? 1000.0f / avg : 0.0f, avg, timer.percentile(0.99f), pacer.level());
+        timing_summary.set(buf, 10);
+        for (std::size_t p = 0; p < FRAME_PHASE_COUNT; ++p) {
+            std::snprintf(buf, sizeof(buf), "%s %.2f", phase_name(static_cast<FramePhase>(p)),
+                          timer.average(static_cast<FramePhase>(p)));
+            timing_phases[p].set(buf, 10);
+        }
+    }
+    emit_text(out, timing_summary, gx, y0 + 5, rgba(255, 255, 255));
+
+    const float graph_bottom = y0 + 20 + GRAPH_H;
+    for (std::size_t age = 0; age < timer.frames(); ++age) {
+        const FrameTiming& f = timer.frame(age);
+        const float bx = gx + GRAPH_W - (age + 1) * BAR_W;
+        float top = graph_bottom;
+        for (std::size_t p = 0; p < FRAME_PHASE_COUNT && top > graph_bottom - GRAPH_H; ++p) {
+            float h = std::min(f.phase_ms[p] * PX_PER_MS, top - (graph_bottom - GRAPH_H));
+            if (h <= 0) continue;
+            top -= h;
+            out.quad(bx, top, BAR_W, h, phase_color(static_cast<FramePhase>(p)));
+        }
+    }
+    // Линия бюджета кадра
+    const float budget_y = graph_bottom - std::min(GRAPH_H, pacer.budgetMs() * PX_PER_MS);
+    out.quad(gx, budget_y, GRAPH_W, 1, rgba(255, 60, 60, 200));
+
+    // Гистограмма длительностей по окну
+    const auto& hist = timer.histogram();
+    const std::uint32_t peak = std::max<std::uint32_t>(1, *std::max_element(hist.begin(), hist.end()));
+    const float slot = GRAPH_W / FrameTimer::BUCKETS;
+    const float hist_bottom = graph_bottom + 6 + HIST_H;
+    for (std::size_t b = 0; b < FrameTimer::BUCKETS; ++b) {
+        const float h = HIST_H * hist[b] / peak;
+        // Кадры ровно в бюджет (пейсер) — не перерасход
+        const bool over = b > 0 && FrameTimer::BUCKET_EDGES[b - 1] > pacer.budgetMs() * 1.05f;
+        out.quad(gx + b * slot, hist_bottom - h, slot - 2, h, over ? rgba(255, 90, 70) : rgba(120, 200, 255));
+    }
+
+    // Легенда: фазы в два столбца со средними значениями
+    for (std::size_t p = 0; p < FRAME_PHASE_COUNT; ++p) {
+        const float lx = gx + (p % 2) * (GRAPH_W / 2);
+        const float ly = hist_bottom + 4 + (p / 2) * 10;
+        out.quad(lx, ly + 1, 6, 6, phase_color(static_cast<FramePhase>(p)));
+        emit_text(out, timing_phases[p], lx + 9, ly, rgba(220, 220, 220));
+    }
+}
+
+void FrameBuilder::emitKillEffect(RenderCommandList& out, float x, float y, float progress) {
+    float radius = 10.0f + progress * 60.0f;
+    out.circle(x, y, radius, rgba(255, 80, 20, alpha_of(255 * (1 - progress))));
+
+    if (effect_quality >= 0.6f) {
+        float waveRadius = radius + 10;
+        out.circle(x, y, waveRadius, rgba(255, 200, 0, alpha_of(160 * (1 - progress))));
+    }
+
+    // Череп поднимается над местом гибели
+    out.sprite(TextureId::Atlas, atlas_glyph(EffectType::Kill), x - 8, y - 8 - progress * 24, 16, 16,
+               rgba(255, 230, 210, alpha_of(255 * (1 - progress))));
+}
+
+void FrameBuilder::emitHurtEffect(RenderCommandList& out, float x, float y, float progress) {
+    float radius = 5.0f + progress * 15.0f;
+    out.circle(x, y, radius, rgba(255, 255, 0, alpha_of(220 * (1 - progress))));
+
+    if (effect_quality >= 0.6f) {
+        float radius2 = 3.0f + progress * 10.0f;
+        out.circle(x, y, radius2, rgba(255, 150, 0, alpha_of(180 * (1 - progress))));
+    }
+
+    float glyph = 12.0f + progress * 8.0f;
+    out.sprite(TextureId::Atlas, atlas_glyph(EffectType::Hurt), x - glyph / 2, y - glyph / 2, glyph, glyph,
+               rgba(255, 255, 200, alpha_of(255 * (1 - progress))));
+}
+
+void FrameBuilder::emitEscapeEffect(RenderCommandList& out, float x, float y, float progress) {
+    // Мерцание персонажа (afterimage effect)
+    if (progress < 0.5f) {
+        float pulseAlpha = std::sin(progress * 3.14159f * 10.0f);
+        if (pulseAlpha > 0) {
+            out.circle(x, y, 15, rgba(100, 255, 100, alpha_of(200 * pulseAlpha * (1.0f - progress * 2))));
+        }
+    }
+
+    // Динамический след уклонения (используем hash от координат для "случайного" направления)
+    int directionSeed = static_cast<int>(x * 1000 + y) % 8;
+    float angle = directionSeed * 3.14159f / 4.0f; // 8 направлений
+
+    float cos_a = std::cos(angle);
+    float sin_a = std::sin(angle);
+
+    // След из частиц в направлении уклонения; длина следа зависит от качества
+    const int trail = std::max(1, static_cast<int>(6 * effect_quality + 0.5f));
+    for (int i = 0; i < trail; ++i) {
+        float offset = i * 0.15f;
+        if (progress < offset) continue;
+
+        float adjProgress = (progress - offset) / (1.0f - offset);
+
+        // Расстояние след растёт со временем
+        float distance = (i + progress * 3) * 8.0f;
+        float trail_x = x - cos_a * distance;
+        float trail_y = y - sin_a * distance;
+
+        float size = 8.0f * (1.0f - adjProgress);
+        std::uint8_t alpha = alpha_of(180 * (1.0f - adjProgress));
+
+        // Градиент от зелёного к жёлтому
+        int red = 100 + static_cast<int>(155 * adjProgress);
+        out.circle(trail_x, trail_y, size, rgba(static_cast<std::uint8_t>(red), 255, 100, alpha));
+
+        // Дополнительные искры
+        if (i % 2 == 0 && effect_quality >= 1.0f) {
+            out.circle(trail_x + (i % 3 - 1) * 4, trail_y + (i % 3 - 1) * 4, 2,
+                       rgba(255, 255, 255, static_cast<std::uint8_t>(alpha / 2)));
+        }
+    }
+
+    // Конечный "дым" уклонения
+    if (progress > 0.3f && effect_quality >= 0.35f) {
+        float smokeProgress = (progress - 0.3f) / 0.7f;
+        float smokeRadius = 5.0f + smokeProgress * 20.0f;
+        out.circle(x, y, smokeRadius, rgba(150, 255, 150, alpha_of(100 * (1.0f - smokeProgress))));
+    }
+
+    out.sprite(TextureId::Atlas, atlas_glyph(EffectType::Escape), x - 8, y - 24, 16, 16,
+               rgba(150, 255, 150, alpha_of(220 * (1.0f - progress))));
+}
+
+void FrameBuilder::emitHealEffect(RenderCommandList& out, float x, float y, float progress) {
+    float pulse = std::sin(progress * 3.14159f * 4.0f) * 0.5f + 0.5f;
+    float radius = 20.0f + pulse * 10.0f;
+
+    out.circle(x, y, radius, rgba(100, 200, 255, alpha_of(150 * (1.0f - progress) * pulse)));
+
+    std::uint8_t crossAlpha = alpha_of(255 * (1.0f - progress));
+    out.sprite(TextureId::Atlas, atlas_glyph(EffectType::Heal), x - 10, y - 10, 20, 20, rgba(255, 255, 255, crossAlpha));
+}
@@ -0,0 +1,242 @@
+#include "../include/frame_export.h"
+#include "../include/trace.h"
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+// ---------------- PPM ----------------
+bool write_ppm(const std::string& path, int width, int height, const std::uint32_t* pixels) {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f.good()) return false;
+
+    f << "P6\n" << width << ' ' << height << "\n255\n";
+
+    std::vector<char> row(static_cast<std::size_t>(width) * 3);
+    for (int y = 0; y < height; ++y) {
+        const std::uint32_t* src = pixels + static_cast<std::size_t>(y) * width;
+        for (int x = 0; x < width; ++x) {
+            row[x * 3 + 0] = static_cast<char>(src[x] >> 24);
+            row[x * 3 + 1] = static_cast<char>(src[x] >> 16);
+            row[x * 3 + 2] = static_cast<char>(src[x] >> 8);
+        }
+        f.write(row.data(), static_cast<std::streamsize>(row.size()));
+    }
+    return f.good();
+}
+
+// ---------------- PNG ----------------
+// Без сжатия (deflate stored-блоки): кадры пишутся быстро и без zlib
+static const std::array<std::uint32_t, 256>& crc_table() {
+    static const std::array<std::uint32_t, 256> table = [] {
+        std::array<std::uint32_t, 256> t{};
+        for (std::uint32_t n = 0; n < 256; ++n) {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+static std::uint32_t crc32(std::uint32_t crc, const std::uint8_t* data, std::size_t len) {
+    const auto& table = crc_table();
+    crc = ~crc;
+    for (std::size_t i = 0; i < len; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void put_be32(std::vector<std::uint8_t>& out, std::uint32_t v) {
+    out.push_back(static_cast<std::uint8_t>(v >> 24));
+    out.push_back(static_cast<std::uint8_t>(v >> 16));
+    out.push_back(static_cast<std::uint8_t>(v >> 8));
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+static void write_chunk(std::ofstream& f, const char* type, const std::vector<std::uint8_t>& data) {
+    std::vector<std::uint8_t> buf;
+    buf.reserve(data.size() + 4);
+    buf.insert(buf.end(), type, type + 4);
+    buf.insert(buf.end(), data.begin(), data.end());
+
+    std::vector<std::uint8_t> len;
+    put_be32(len, static_cast<std::uint32_t>(data.size()));
+    std::vector<std::uint8_t> crc;
+    put_be32(crc, crc32(0, buf.data(), buf.size()));
+
+    f.write(reinterpret_cast<const char*>(len.data()), 4);
+    f.write(reinterpret_cast<const char*>(buf.data()), static_cast<std::streamsize>(buf.size()));
+    f.write(reinterpret_cast<const char*>(crc.data()), 4);
+}
+
+bool write_png(const std::string& path, int width, int height, const std::uint32_t* pixels) {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f.good()) return false;
+
+    static const std::uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    f.write(reinterpret_cast<const char*>(signature), 8);
+
+    std::vector<std::uint8_t> ihdr;
+    put_be32(ihdr, static_cast<std::uint32_t>(width));
+    put_be32(ihdr, static_cast<std::uint32_t>(height));
+    ihdr.push_back(8);  // бит на канал
+    ihdr.push_back(2);  // RGB
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    write_chunk(f, "IHDR", ihdr);
+
+    // Строки: байт фильтра (0) + RGB
+    const std::size_t stride = static_cast<std::size_t>(width) * 3 + 1;
+    std::vector<std::uint8_t> raw(stride * height);
+    for (int y = 0; y < height; ++y) {
+        std::uint8_t* dst = &raw[y * stride];
+        const std::uint32_t* src = pixels + static_cast<std::size_t>(y) * width;
+        dst[0] = 0;
+        for (int x = 0; x < width; ++x) {
+            dst[1 + x * 3 + 0] = static_cast<std::uint8_t>(src[x] >> 24);
+            dst[1 + x * 3 + 1] = static_cast<std::uint8_t>(src[x] >> 16);
+            dst[1 + x * 3 + 2] = static_cast<std::uint8_t>(src[x] >> 8);
+        }
+    }
+
+    // zlib-поток из stored-блоков по 65535 байт
+    std::vector<std::uint8_t> idat;
+    idat.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+
+    std::uint32_t a = 1, b = 0;
+    std::size_t pos = 0;
+    do {
+        std::size_t len = std::min<std::size_t>(65535, raw.size() - pos);
+        bool last = pos + len == raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(static_cast<std::uint8_t>(len));
+        idat.push_back(static_cast<std::uint8_t>(len >> 8));
+        idat.push_back(static_cast<std::uint8_t>(~len));
+        idat.push_back(static_cast<std::uint8_t>(~len >> 8));
+        idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + len);
+
+        // Adler-32: остаток берём раз в 5552 байта, а не на каждом байте
+        for (std::size_t i = pos; i < pos + len;) {
+            std::size_t end = std::min(pos + len, i + 5552);
+            for (; i < end; ++i) {
+                a += raw[i];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        pos += len;
+    } while (pos < raw.size());
+    put_be32(idat, (b << 16) | a);
+
+    write_chunk(f, "IDAT", idat);
+    write_chunk(f, "IEND", {});
+    return f.good();
+}
+
+// ---------------- FrameExporter ----------------
+FrameExporter::FrameExporter(FrameExportConfig config) : cfg(std::move(config)) {
+    images[static_cast<std::size_t>(TextureId::Atlas)] = make_atlas_image();
+}
+
+void FrameExporter::run(SnapshotPublisher& snapshots, const std::atomic<bool>& running) {
+    using clock = std::chrono::steady_clock;
+    using ms = std::chrono::duration<double, std::milli>;
+    trace_thread_name("export");
+
+    std::error_code ec;
+    std::filesystem::create_directories(cfg.directory, ec);
+    if (ec) {
+        std::cerr << "Cannot create export directory " << cfg.directory << ": " << ec.message() << "\n";
+        return;
+    }
+
+    auto obs = std::static_pointer_cast<VisualObserver>(VisualObserver::get());
+    FrameBuilder builder;
+    builder.setClock(sim_clock);
+    RenderCommandList commands;
+
+    CpuRasterBackend raster(cfg.width, cfg.height, cfg.threads);
+    raster_threads = raster.threadCount();
+    for (std::size_t i = 0; i < images.size(); ++i)
+        if (!images[i].pixels.empty())
+            raster.setTexture(static_cast<TextureId>(i), &images[i]);
+    // Карта плотности читается растеризатором напрямую, без копирования
+    raster.setTexture(TextureId::Heatmap, &builder.heatmap().image());
+
+    const auto interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / cfg.fps));
+    auto next = clock::now();
+
+    while (running) {
+        auto now = clock::now();
+        if (now < next) {
+            std::this_thread::sleep_until(std::min(next, now + std::chrono::milliseconds(50)));
+            continue;
+        }
+        next += interval;
+
+        TraceZone zone("FrameExporter frame");
+        auto t0 = clock::now();
+        obs->updateParticles(std::chrono::duration<float>(interval).count());
+        builder.build(snapshots.acquire(), *obs, now,
+                      static_cast<float>(cfg.width), static_cast<float>(cfg.height),
+                      obs->getLastInteractionMessage(), commands);
+        auto t1 = clock::now();
+        raster.execute(commands);
+        auto t2 = clock::now();
+        writeFrame(raster, frames);
+        auto t3 = clock::now();
+
+        build_ms += ms(t1 - t0).count();
+        raster_ms += ms(t2 - t1).count();
+        write_ms += ms(t3 - t2).count();
+        frames++;
+    }
+}
+
+bool FrameExporter::writeFrame(const CpuRasterBackend& raster, std::uint64_t index) {
+    std::ostringstream name;
+    name << "frame_" << std::setw(6) << std::setfill('0') << index
+         << (cfg.format == ImageFormat::PNG ? ".png" : ".ppm");
+    std::string path = (std::filesystem::path(cfg.directory) / name.str()).string();
+
+    bool ok = cfg.format == ImageFormat::PNG
+        ? write_png(path, raster.width(), raster.height(), raster.pixels())
+        : write_ppm(path, raster.width(), raster.height(), raster.pixels());
+    if (!ok) std::cerr << "Failed to write " << path << "\n";
+    return ok;
+}
+
+void FrameExporter::printSummary() const {
+    if (frames == 0) return;
+    const double n = static_cast<double>(frames);
+    std::cout << "\n=== Frame export ===\n"
+              << frames << " frames " << cfg.width << "x" << cfg.height
+              << " -> " << cfg.directory << " (" << raster_threads << " raster threads)\n"
+              << std::fixed << std::setprecision(2)
+              << "per frame: build " << build_ms / n << " ms"
+              << " | raster " << raster_ms / n << " ms"
+              << " | write " << write_ms / n << " ms"
+              << " | budget " << 1000.0 / cfg.fps << " ms\n";
+}
+
+bool parse_frame_size(const std::string& text, int& width, int& height) {
+    int w = 0, h = 0;
+    char sep = 0;
+    std::istringstream is(text);
+    if (!(is >> w >> sep >> h) || (sep != 'x' && sep != 'X') || w <= 0 || h <= 0) return false;
+    width = w;
+    height = h;
+    return true;
+}
@@ -0,0 +1,123 @@
+#include "../include/frame_timing.h"
+#include <algorithm>
+
+const char* phase_name(FramePhase phase) {
+    switch (phase) {
+        case FramePhase::Events:   return "events";
+        case FramePhase::Snapshot: return "snapshot";
+        case FramePhase::Build:    return "build";
+        case FramePhase::Draw:     return "draw";
+        case FramePhase::Display:  return "display";
+        case FramePhase::Idle:     return "idle";
+        case FramePhase::Count:    break;
+    }
+    return "?";
+}
+
+static float ms_between(FrameTimer::clock::time_point a, FrameTimer::clock::time_point b) {
+    return std::chrono::duration<float, std::milli>(b - a).count();
+}
+
+// ========== FrameTimer ==========
+void FrameTimer::beginFrame(clock::time_point now) {
+    current = FrameTiming{};
+    frame_start = now;
+    last_mark = now;
+}
+
+void FrameTimer::mark(FramePhase phase, clock::time_point now) {
+    current.phase_ms[static_cast<std::size_t>(phase)] += ms_between(last_mark, now);
+    last_mark = now;
+}
+
+void FrameTimer::endFrame(clock::time_point now) {
+    current.total_ms = ms_between(frame_start, now);
+
+    // Вытесняемый кадр уходит и из гистограммы
+    if (stored == HISTORY) buckets[bucketOf(ring[head].total_ms)]--;
+    else stored++;
+
+    ring[head] = current;
+    buckets[bucketOf(current.total_ms)]++;
+    head = (head + 1) % HISTORY;
+}
+
+float FrameTimer::elapsedMs(clock::time_point now) const {
+    return ms_between(frame_start, now);
+}
+
+const FrameTiming& FrameTimer::last() const {
+    return frame(0);
+}
+
+const FrameTiming& FrameTimer::frame(std::size_t age) const {
+    return ring[(head + HISTORY - 1 - age % HISTORY) % HISTORY];
+}
+
+std::size_t FrameTimer::bucketOf(float ms) {
+    for (std::size_t i = 0; i < BUCKET_EDGES.size(); ++i)
+        if (ms < BUCKET_EDGES[i]) return i;
+    return BUCKET_EDGES.size();
+}
+
+float FrameTimer::percentile(float p) const {
+    if (stored == 0) return 0;
+    scratch.clear();
+    for (std::size_t i = 0; i < stored; ++i) scratch.push_back(frame(i).total_ms);
+    std::size_t k = static_cast<std::size_t>(std::clamp(p, 0.0f, 1.0f) * (stored - 1));
+    std::nth_element(scratch.begin(), scratch.begin() + k, scratch.end());
+    return scratch[k];
+}
+
+float FrameTimer::average(FramePhase phase) const {
+    if (stored == 0) return 0;
+    float sum = 0;
+    for (std::size_t i = 0; i < stored; ++i) sum += frame(i).phase_ms[static_cast<std::size_t>(phase)];
+    return sum / stored;
+}
+
+// ========== FramePacer ==========
+FramePacer::FramePacer(double fps) {
+    setTargetFps(fps);
+}
+
+void FramePacer::setTargetFps(double fps) {
+    target_fps = std::clamp(fps, 1.0, 1000.0);
+    budget_ms = static_cast<float>(1000.0 / target_fps);
+}
+
+std::chrono::microseconds FramePacer::idleTime(float work_ms) const {
+    float idle = std::max(0.0f, budget_ms - work_ms);
+    return std::chrono::microseconds(static_cast<std::int64_t>(idle * 1000.0f));
+}
+
+bool FramePacer::update(float work_ms) {
+    // Экспоненциальное среднее сглаживает одиночные всплески
+    work_avg = work_avg == 0 ? work_ms : work_avg + (work_ms - work_avg) * 0.1f;
+
+    // Понижаем быстро (10 кадров над 90% бюджета), повышаем медленно
+    // (две секунды под половиной бюджета)
+    const int old_level = quality_level;
+    if (work_avg > budget_ms * 0.9f) {
+        under_frames = 0;
+        if (++over_frames >= 10 && quality_level < MAX_LEVEL) {
+            quality_level++;
+            over_frames = 0;
+        }
+    } else if (work_avg < budget_ms * 0.5f) {
+        over_frames = 0;
+        if (++under_frames >= static_cast<int>(target_fps * 2) && quality_level > 0) {
+            quality_level--;
+            under_frames = 0;
+        }
+    } else {
+        over_frames = 0;
+        under_frames = 0;
+    }
+    return quality_level != old_level;
+}
+
+float FramePacer::quality() const {
+    static constexpr float LEVELS[MAX_LEVEL + 1] = {1.0f, 0.6f, 0.35f, 0.15f};
+    return LEVELS[quality_level];
+}
@@ -1,10 +1,16 @@
 #include "../include/game_utils.h"
+#include "../include/terminal_view.h"
+#include "../include/tick_arena.h"
+#include "../include/memory_tracker.h"
+#include "../include/metrics.h"
+#include "../include/trace.h"
 #include <iostream>
 #include <fstream>
 #include <iomanip>
 #include <unordered_set>
 #include <algorithm>
 #include <sstream>
+#include <memory>
 
 #include <thread>
 #include <mutex>
@@ -16,8 +22,7 @@
 #include <thread>
 
 using namespace std::chrono_literals;
-std::mutex print_mutex;
-std::mutex global_npcs_mutex;
+ProfiledMutex print_mutex{"print_mutex"};
 
 // ---------------- Константы FileObserver ----------------
 const int FileObserver::W1 = 18;
@@ -34,13 +39,16 @@ std::shared_ptr<IInteractionObserver> ConsoleObserver::get() {
     return std::shared_ptr<IInteractionObserver>(&instance, [](IInteractionObserver*) {});
 }
 
-void ConsoleObserver::on_interaction(const std::shared_ptr<NPC>& actor,
-                               const std::shared_ptr<NPC>& target,
-                               InteractionOutcome outcome)
+void ConsoleObserver::on_interaction(const NPCStore& world, NPCHandle actor_handle,
+                               NPCHandle target_handle, InteractionOutcome outcome)
 {
+    TraceZone zone("ConsoleObserver::on_interaction");
+    const NPC* actor = world.get(actor_handle);
+    const NPC* target = world.get(target_handle);
     if (!actor || !target) return;
 
-    std::lock_guard<std::mutex> lck(print_mutex);
+    MemoryScope scope(MemSubsystem::Logs);
+    std::lock_guard<ProfiledMutex> lck(print_mutex);
 
     switch (outcome) {
     case InteractionOutcome::TargetKilled:
@@ -81,7 +89,7 @@ FileObserver::FileObserver(const std::string& filename) : fname(filename)
     std::ofstream f(fname, std::ios::trunc);
     if (!f.good()) return;
 
-    std::lock_guard<std::mutex> lck(print_mutex);
+    std::lock_guard<ProfiledMutex> lck(print_mutex);
 
     f << std::left
       << std::setw(W1)  << "Actor"
@@ -109,22 +117,31 @@ std::shared_ptr<IInteractionObserver> FileObserver::get(const std::string& filen
     return instance;
 }
 
-void FileObserver::on_interaction(const std::shared_ptr<NPC>& actor,
-                            const std::shared_ptr<NPC>& target,
-                            InteractionOutcome outcome)
+void FileObserver::on_interaction(const NPCStore& world, NPCHandle actor_handle,
+                            NPCHandle target_handle, InteractionOutcome outcome)
 {
+    TraceZone zone("FileObserver::on_interaction");
+    const NPC* actor = world.get(actor_handle);
+    const NPC* target = world.get(target_handle);
     if (!actor || !target) return;
 
+    MemoryScope scope(MemSubsystem::Logs);
     std::ofstream f(fname, std::ios::app);
     if (!f.good()) return;
 
-    std::lock_guard<std::mutex> lck(print_mutex);
+    std::lock_guard<ProfiledMutex> lck(print_mutex);
+
+    // Позиция и здоровье — состояние мира, а не поля NPC (см. NPCStore)
+    const auto [ax, ay] = world.position(*actor);
+    const auto [tx, ty] = world.position(*target);
+    const int actor_health = world.health(*actor);
+    const int target_health = world.health(*target);
 
     std::ostringstream ss;
-    ss << '(' << actor->x << ',' << actor->y << ')';
+    ss << '(' << ax << ',' << ay << ')';
     std::string aPos = ss.str();
     ss.str("");
-    ss << '(' << target->x << ',' << target->y << ')';
+    ss << '(' << tx << ',' << ty << ')';
     std::string tPos = ss.str();
 
     switch (outcome) {
@@ -132,12 +149,12 @@ void FileObserver::on_interaction(const std::shared_ptr<NPC>& actor,
         f << std::left
           << std::setw(W1) << actor->name
           << std::setw(W2) << type_to_string(actor->type)
-          << std::setw(WH) << actor->health
+          << std::setw(WH) << actor_health
           << std::setw(WP) << aPos
           << std::setw(WA) << "killed"
           << std::setw(W3) << target->name
           << std::setw(W4) << type_to_string(target->type)
-          << std::setw(WH) << target->health
+          << std::setw(WH) << target_health
           << std::setw(WP) << tPos
           << "\n";
         break;
@@ -146,12 +163,12 @@ void FileObserver::on_interaction(const std::shared_ptr<NPC>& actor,
         f << std::left
           << std::setw(W1) << actor->name
           << std::setw(W2) << type_to_string(actor->type)
-          << std::setw(WH) << actor->health
+          << std::setw(WH) << actor_health
           << std::setw(WP) << aPos
           << std::setw(WA) << "hurted"
           << std::setw(W3) << target->name
           << std::setw(W4) << type_to_string(target->type)
-          << std::setw(WH) << target->health
+          << std::setw(WH) << target_health
           << std::setw(WP) << tPos
           << "\n";
         break;
@@ -160,12 +177,12 @@ void FileObserver::on_interaction(const std::shared_ptr<NPC>& actor,
         f << std::left
           << std::setw(W1) << target->name
           << std::setw(W2) << type_to_string(target->type)
-          << std::setw(WH) << target->health
+          << std::setw(WH) << target_health
           << std::setw(WP) << tPos
           << std::setw(WA) << "escaped"
           << std::setw(W3) << actor->name
           << std::setw(W4) << type_to_string(actor->type)
-          << std::setw(WH) << actor->health
+          << std::setw(WH) << actor_health
           << std::setw(WP) << aPos
           << "\n";
         break;
@@ -174,12 +191,12 @@ void FileObserver::on_interaction(const std::shared_ptr<NPC>& actor,
         f << std::left
           << std::setw(W1) << actor->name
           << std::setw(W2) << type_to_string(actor->type)
-          << std::setw(WH) << actor->health
+          << std::setw(WH) << actor_health
           << std::setw(WP) << aPos
           << std::setw(WA) << "healed"
           << std::setw(W3) << target->name
           << std::setw(W4) << type_to_string(target->type)
-          << std::setw(WH) << target->health
+          << std::setw(WH) << target_health
           << std::setw(WP) << tPos
           << "\n";
         break;
@@ -190,11 +207,14 @@ void FileObserver::on_interaction(const std::shared_ptr<NPC>& actor,
 }
 
 // ---------------- Логика боя ----------------
-AttackVisitor::AttackVisitor(const std::shared_ptr<NPC>& actor_)
-    : actor(actor_) {}
+AttackVisitor::AttackVisitor(const NPC& actor_, const NPCStore& world_, RandomSource& random_)
+    : actor(&actor_), world(&world_), random(&random_) {}
+
+AttackVisitor::AttackVisitor(const NPC& actor_, const NPCStore& world_, std::uint64_t& dice_state_)
+    : actor(&actor_), world(&world_), dice_state(&dice_state_) {}
 
 InteractionOutcome AttackVisitor::visit([[maybe_unused]] Bear& target) {
-    if (!actor->is_alive()) return InteractionOutcome::NoInteraction;
+    if (!world->isAlive(*actor)) return InteractionOutcome::NoInteraction;
 
     NPCType at = actor->type;
     if (at == NPCType::Orc || at == NPCType::Dragon)
@@ -204,7 +224,7 @@ InteractionOutcome AttackVisitor::visit([[maybe_unused]] Bear& target) {
 }
 
 InteractionOutcome AttackVisitor::visit([[maybe_unused]] Dragon& target) {
-    if (!actor->is_alive()) return InteractionOutcome::NoInteraction;
+    if (!world->isAlive(*actor)) return InteractionOutcome::NoInteraction;
 
     NPCType at = actor->type;
     if (at == NPCType::Orc || at == NPCType::Dragon)
@@ -214,7 +234,7 @@ InteractionOutcome AttackVisitor::visit([[maybe_unused]] Dragon& target) {
 }
 
 InteractionOutcome AttackVisitor::visit([[maybe_unused]] Druid& target) {
-    if (!actor->is_alive()) return InteractionOutcome::NoInteraction;
+    if (!world->isAlive(*actor)) return InteractionOutcome::NoInteraction;
 
     NPCType at = actor->type;
     if (at == NPCType::Orc || at == NPCType::Dragon)
@@ -224,7 +244,7 @@ InteractionOutcome AttackVisitor::visit([[maybe_unused]] Druid& target) {
 }
 
 InteractionOutcome AttackVisitor::visit([[maybe_unused]] Orc& target) {
-    if (!actor->is_alive()) return InteractionOutcome::NoInteraction;
+    if (!world->isAlive(*actor)) return InteractionOutcome::NoInteraction;
 
     NPCType at = actor->type;
     if (at == NPCType::Orc || at == NPCType::Dragon)
@@ -234,7 +254,7 @@ InteractionOutcome AttackVisitor::visit([[maybe_unused]] Orc& target) {
 }
 
 InteractionOutcome AttackVisitor::visit([[maybe_unused]] Squirrel& target) {
-    if (!actor->is_alive()) return InteractionOutcome::NoInteraction;
+    if (!world->isAlive(*actor)) return InteractionOutcome::NoInteraction;
 
     NPCType at = actor->type;
     if (at == NPCType::Bear)
@@ -244,14 +264,17 @@ InteractionOutcome AttackVisitor::visit([[maybe_unused]] Squirrel& target) {
 }
 
 bool AttackVisitor::dice() {
-    return roll() > roll();
+    if (!dice_state) return random->roll() > random->roll();
+    // Два броска d6 из одного 64-битного числа
+    const std::uint64_t r = splitmix64(*dice_state);
+    return static_cast<int>((r & 0xFFFFFFFFu) % 6) > static_cast<int>((r >> 32) % 6);
 }
 
-SupportVisitor::SupportVisitor(const std::shared_ptr<NPC>& actor_)
-    : actor(actor_) {}
+SupportVisitor::SupportVisitor(const NPC& actor_, const NPCStore& world_)
+    : actor(&actor_), world(&world_) {}
 
 InteractionOutcome SupportVisitor::visit(Bear& target) {
-    if (actor->type == NPCType::Druid && target.is_alive() && target.get_current_health() != target.get_max_health())
+    if (actor->type == NPCType::Druid && world->isAlive(target) && world->health(target) != target.get_max_health())
         return InteractionOutcome::TargetHealed;
 
     return InteractionOutcome::NoInteraction;
@@ -270,134 +293,344 @@ InteractionOutcome SupportVisitor::visit(Orc&) {
 }
 
 InteractionOutcome SupportVisitor::visit(Squirrel& target) {
-    if (actor->type == NPCType::Druid && target.is_alive() && target.get_current_health() != target.get_max_health())
+    if (actor->type == NPCType::Druid && world->isAlive(target) && world->health(target) != target.get_max_health())
         return InteractionOutcome::TargetHealed;
 
     return InteractionOutcome::NoInteraction;
 }
 
+const char* combat_mode_name(CombatMode mode) {
+    switch (mode) {
+        case CombatMode::Sequential: return "sequential";
+        case CombatMode::TwoPhase:   return "two-phase";
+    }
+    return "?";
+}
+
+// Метрики очереди взаимодействий; регистрируются при первом обращении
+namespace {
+struct InteractionMetrics {
+    Counter& pushed;
+    Counter& resolved;
+    Gauge& queue_depth;
+    Histogram& latency;
+    std::array<Counter*, 5> outcomes;
+
+    void countOutcome(InteractionOutcome outcome) { outcomes[static_cast<std::size_t>(outcome)]->add(); }
+};
+
+InteractionMetrics& interaction_metrics() {
+    static InteractionMetrics m = [] {
+        MetricsRegistry& r = MetricsRegistry::instance();
+        InteractionMetrics built{
+            r.counter("pixelrpg_events_pushed_total", "Interaction events queued by pair detection."),
+            r.counter("pixelrpg_events_resolved_total", "Interaction events resolved by combat."),
+            r.gauge("pixelrpg_interaction_queue_depth", "Interaction events waiting when the last resolve phase began."),
+            r.histogram("pixelrpg_event_latency_seconds",
+                        "Time from queuing an interaction event to applying it (every 64th event).", 1e-9),
+            {}};
+        for (std::size_t i = 0; i < built.outcomes.size(); ++i) {
+            const auto outcome = static_cast<InteractionOutcome>(i);
+            built.outcomes[i] = &r.counter("pixelrpg_outcomes_total", "Interaction outcomes delivered to observers.",
+                                           std::string("outcome=\"") + outcome_name(outcome) + "\"");
+        }
+        return built;
+    }();
+    return m;
+}
+} // namespace
+
+InteractionManager::InteractionManager() : random(&default_random()) {}
+
 InteractionManager& InteractionManager::instance() {
     static InteractionManager inst;
     return inst;
 }
 
+void InteractionManager::setArena(std::pmr::memory_resource* arena) {
+    std::lock_guard<ProfiledMutex> lock(mtx);
+    std::pmr::memory_resource* resource = arena ? arena : std::pmr::get_default_resource();
+    // polymorphic_allocator не переносится присваиванием — контейнеры пересоздаются
+    auto rebind = [resource](auto& container) {
+        std::destroy_at(&container);
+        std::construct_at(&container, resource);
+    };
+    rebind(queue);
+    rebind(pushed_at);
+    rebind(notifications);
+    rebind(computed);
+    rebind(touched);
+}
+
+void InteractionManager::releaseTickStorage() {
+    std::lock_guard<ProfiledMutex> lock(mtx);
+    release_tick_storage(queue);
+    release_tick_storage(pushed_at);
+    release_tick_storage(notifications);
+    release_tick_storage(computed);
+    release_tick_storage(touched);
+}
+
+void InteractionManager::reserve(std::size_t events) {
+    std::lock_guard<ProfiledMutex> lock(mtx);
+    events += queue.size();
+    queue.reserve(events);
+    pushed_at.reserve(events / LATENCY_SAMPLE + 1);
+    // Исходов последовательного боя заранее не знает никто: в плотной толпе
+    // большинство пар приходит к уже погибшим, и запас под все пары занял бы
+    // больше самой очереди. Двухфазный бой размечает их точно (commitComputed)
+}
+
 void InteractionManager::push(InteractionEvent ev) {
-    std::lock_guard<std::mutex> lock(mtx);
-    queue.push(std::move(ev));
+    std::lock_guard<ProfiledMutex> lock(mtx);
+    if (queue.size() % LATENCY_SAMPLE == 0) pushed_at.push_back(metrics_now_ns());
+    queue.push_back(std::move(ev));
 }
 
-void InteractionManager::apply_outcome(const std::shared_ptr<NPC>& actor,
-                   const std::shared_ptr<NPC>& target,
-                   InteractionOutcome outcome)
+std::size_t InteractionManager::pending() const {
+    std::lock_guard<ProfiledMutex> lock(mtx);
+    return queue.size();
+}
+
+void InteractionManager::apply_outcome(NPC& actor, NPC& target, InteractionOutcome outcome)
 {
-    std::lock_guard<std::mutex> lock(global_npcs_mutex);
+    TraceZone zone("InteractionManager::apply_outcome");
+    std::lock_guard<ProfiledMutex> lock(apply_mtx);
 
     switch (outcome) {
     case InteractionOutcome::TargetHurted:
         {
-            int damage = actor->get_damage_amount();
-            std::lock_guard<std::mutex> lck(target->mtx);
-            target->health -= damage;
-            if (target->health <= 0) {
-                target->health = 0;
-                target->alive = false;
+            int damage = actor.get_damage_amount();
+            if (!store->setHealth(target, store->health(target) - damage))
                 outcome = InteractionOutcome::TargetKilled;
-            }
         }
-        actor->notify_interaction(target, outcome);
         break;
 
     case InteractionOutcome::TargetEscaped:
-        actor->notify_interaction(target, outcome);
         break;
 
     case InteractionOutcome::TargetHealed:
-        target->heal();
-        actor->notify_interaction(target, outcome);
+        store->setHealth(target, target.get_max_health());
         break;
 
     case InteractionOutcome::NoInteraction:
-        break;
+        return;
     }
 
-    effects_cv.notify_one();
+    // Наблюдатели узнают об исходе в фазе уведомлений, после всех боёв тика
+    notifications.push_back({actor.handle(), target.handle(), outcome});
 }
 
-void InteractionManager::operator()() {
-    using namespace std::chrono_literals;
+void InteractionManager::resolve(const InteractionEvent& ev) {
+    TraceZone zone("InteractionManager::resolve");
+    // Устаревшая ссылка (слот занят другим NPC) просто пропускается
+    NPC* a = store->get(ev.actor);
+    NPC* t = store->get(ev.target);
+    if (!a || !t) return;
+
+    // Проверяем расстояние БЕЗ разрыва между проверкой и действием
+    bool alive_a = store->isAlive(*a);
+    bool alive_t = store->isAlive(*t);
+    
+    // Получаем расстояние thread-safe способом
+    int distance = -1;
+    if (alive_a && alive_t) {
+        distance = store->distance(*a, *t);
+    }
+    
+    int interaction_dist = a->get_interaction_distance();
+    
+    if (alive_a && alive_t && distance >= 0 && distance <= interaction_dist) {
+        // Атака
+        AttackVisitor av1(*a, *store, *random);
+        InteractionOutcome outcome1 = t->accept(av1);
+        apply_outcome(*a, *t, outcome1);
+        
+        // Контратака (если target ещё жив)
+        if (store->isAlive(*t)) {
+            AttackVisitor av2(*t, *store, *random);
+            InteractionOutcome outcome2 = a->accept(av2);
+            apply_outcome(*t, *a, outcome2);
+        }
+    }
 
-    while (running) {
-        std::optional<InteractionEvent> ev;
+    // Поддержка (лечение)
+    alive_a = store->isAlive(*a);
+    alive_t = store->isAlive(*t);
+    
+    if ((alive_a && alive_t)) {
+        distance = store->distance(*a, *t);
+        if (distance >= 0 && distance <= interaction_dist) {
+            SupportVisitor sv1(*a, *store);
+            InteractionOutcome outcome = t->accept(sv1);
+            apply_outcome(*a, *t, outcome);
+
+            SupportVisitor sv2(*t, *store);
+            InteractionOutcome outcome2 = a->accept(sv2);
+            apply_outcome(*t, *a, outcome2);
+        }
+    }
+}
 
-        {
-            std::lock_guard<std::mutex> lock(mtx);
-            if (!queue.empty()) {
-                ev = queue.front();
-                queue.pop();
-            }
+std::size_t InteractionManager::resolvePending() {
+    TraceZone zone("InteractionManager::resolvePending");
+    std::lock_guard<ProfiledMutex> lock(mtx);
+    InteractionMetrics& metrics = interaction_metrics();
+    std::size_t n = queue.size();
+    metrics.queue_depth.set(static_cast<std::int64_t>(n));
+    metrics.pushed.add(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        resolve(queue[i]);
+        if (i % LATENCY_SAMPLE == 0)
+            metrics.latency.record(static_cast<std::uint64_t>(metrics_now_ns() - pushed_at[i / LATENCY_SAMPLE]));
+    }
+    metrics.resolved.add(n);
+    queue.clear();  // ёмкость остаётся на следующий тик
+    pushed_at.clear();
+    return n;
+}
+
+std::size_t InteractionManager::notifyPending() {
+    TraceZone zone("InteractionManager::notifyPending");
+    std::size_t n;
+    {
+        std::lock_guard<ProfiledMutex> lock(mtx);
+        InteractionMetrics& metrics = interaction_metrics();
+        for (const Notification& note : notifications) {
+            metrics.countOutcome(note.outcome);
+            // Наблюдатели унаследованного при ветвлении NPC — наблюдатели родителя
+            NPC* actor = store->get(note.actor);
+            if (actor && !store->inherited(*actor)) actor->notify_interaction(*store, note.target, note.outcome);
         }
+        n = notifications.size();
+        notifications.clear();
+    }
+
+    if (n > 0) effects_cv.notify_one();
+    return n;
+}
 
-        if (ev) {
-            auto a = ev->actor;
-            auto t = ev->target;
+std::size_t InteractionManager::beginCompute(std::size_t npc_count, std::uint64_t seed) {
+    std::lock_guard<ProfiledMutex> lock(mtx);
+    compute_seed = seed;
+    interaction_metrics().queue_depth.set(static_cast<std::int64_t>(queue.size()));
+    interaction_metrics().pushed.add(queue.size());
+    computed.resize(queue.size());
+    if (deltas.size() < npc_count) deltas.resize(npc_count);
+    return queue.size();
+}
+
+void InteractionManager::computeRange(std::size_t begin, std::size_t end) {
+    TraceZone zone("InteractionManager::computeRange");
+    // Между beginCompute() и commitComputed() очередь и NPC не меняются,
+    // поэтому диапазоны читают их без мьютекса менеджера
+    for (std::size_t i = begin; i < end; ++i) {
+        const InteractionEvent& ev = queue[i];
+        ComputedEvent& out = computed[i];
+        out.outcomes.fill(InteractionOutcome::NoInteraction);
+
+        NPC* a = store->get(ev.actor);
+        NPC* t = store->get(ev.target);
+        if (!a || !t || !store->isAlive(*a) || !store->isAlive(*t)) continue;
+        if (store->distance(*a, *t) > a->get_interaction_distance()) continue;
+
+        // Поток кубиков зависит только от номера события, не от разбиения на куски
+        std::uint64_t state = compute_seed ^ (i * 0xA24BAED4963EE407ull);
+
+        // Удары одновременные: контратака не зависит от исхода атаки
+        AttackVisitor av1(*a, *store, state);
+        out.outcomes[0] = t->accept(av1);
+        AttackVisitor av2(*t, *store, state);
+        out.outcomes[1] = a->accept(av2);
+
+        SupportVisitor sv1(*a, *store);
+        out.outcomes[2] = t->accept(sv1);
+        SupportVisitor sv2(*t, *store);
+        out.outcomes[3] = a->accept(sv2);
+    }
+}
 
-            if (!a || !t) {
-                std::this_thread::sleep_for(1ms);
+std::size_t InteractionManager::commitComputed() {
+    TraceZone zone("InteractionManager::commitComputed");
+    std::lock_guard<ProfiledMutex> lock(mtx);
+    const std::size_t n = queue.size();
+    touched.reserve(std::min(deltas.size(), 2 * n));
+
+    // Редукция: урон и лечение суммируются по NPC; порядок сложения не влияет на итог
+    for (std::size_t i = 0; i < n; ++i) {
+        const InteractionEvent& ev = queue[i];
+        for (std::size_t k = 0; k < 4; ++k) {
+            const InteractionOutcome outcome = computed[i].outcomes[k];
+            if (outcome != InteractionOutcome::TargetHurted && outcome != InteractionOutcome::TargetHealed)
                 continue;
-            }
 
-            // Проверяем расстояние БЕЗ разрыва между проверкой и действием
-            bool alive_a = a->is_alive();
-            bool alive_t = t->is_alive();
-            
-            // Получаем расстояние thread-safe способом
-            int distance = -1;
-            if (alive_a && alive_t) {
-                distance = a->get_distance_to(t);
+            // Исход есть только у событий, чьи ссылки разыменовались в computeRange()
+            const bool forward = (k % 2) == 0;
+            NPC* actor = store->get(forward ? ev.actor : ev.target);
+            NPC* target = store->get(forward ? ev.target : ev.actor);
+            if (target->id >= deltas.size()) continue;
+
+            PendingDelta& d = deltas[target->id];
+            if (!d.npc) {
+                d.npc = target;
+                touched.push_back(target->id);
             }
-            
-            int interaction_dist = a->get_interaction_distance();
-            
-            // Проверка близости с логированием для отладки
-            if (alive_a && alive_t && distance >= 0 && distance <= interaction_dist) {
-                // Атака
-                AttackVisitor av1(a);
-                InteractionOutcome outcome1 = t->accept(av1);
-                apply_outcome(a, t, outcome1);
-                
-                // Контратака (если target ещё жив)
-                if (t->is_alive()) {
-                    AttackVisitor av2(t);
-                    InteractionOutcome outcome2 = a->accept(av2);
-                    apply_outcome(t, a, outcome2);
-                }
+            if (outcome == InteractionOutcome::TargetHealed) {
+                d.healed = true;
+            } else {
+                if (!d.hit) d.first_hit = static_cast<std::uint32_t>(i * 4 + k);
+                d.hit = true;
+                d.damage += actor->get_damage_amount();
             }
+        }
+    }
 
-            // Поддержка (лечение)
-            alive_a = a->is_alive();
-            alive_t = t->is_alive();
-            
-            if ((alive_a && alive_t)) {
-                distance = a->get_distance_to(t);
-                if (distance >= 0 && distance <= interaction_dist) {
-                    SupportVisitor sv1(a);
-                    InteractionOutcome outcome = t->accept(sv1);
-                    apply_outcome(a, t, outcome);
-
-                    SupportVisitor sv2(t);
-                    InteractionOutcome outcome2 = a->accept(sv2);
-                    apply_outcome(t, a, outcome2);
-                }
-            }
+    // Фиксация: лечение восстанавливает здоровье на начало тика, затем вычитается урон
+    {
+        std::lock_guard<ProfiledMutex> world_lock(apply_mtx);
+        for (std::uint32_t id : touched) {
+            PendingDelta& d = deltas[id];
+            const int before = d.healed ? d.npc->get_max_health() : store->health(*d.npc);
+            if (!store->setHealth(*d.npc, before - d.damage)) d.killed = true;
+        }
+    }
 
-            std::this_thread::sleep_for(5ms);
+    // Исходы в порядке событий; лечение погибших в этом тике не сообщается
+    std::size_t outcomes = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        for (const InteractionOutcome outcome : computed[i].outcomes)
+            outcomes += outcome != InteractionOutcome::NoInteraction;
+    notifications.reserve(notifications.size() + outcomes);
+    for (std::size_t i = 0; i < n; ++i) {
+        const InteractionEvent& ev = queue[i];
+        for (std::size_t k = 0; k < 4; ++k) {
+            InteractionOutcome outcome = computed[i].outcomes[k];
+            if (outcome == InteractionOutcome::NoInteraction) continue;
+
+            const bool forward = (k % 2) == 0;
+            const NPCHandle actor = forward ? ev.actor : ev.target;
+            const NPCHandle target = forward ? ev.target : ev.actor;
+            if (target.index() < deltas.size() && deltas[target.index()].killed) {
+                if (outcome == InteractionOutcome::TargetHealed) continue;
+                if (outcome == InteractionOutcome::TargetHurted && deltas[target.index()].first_hit == i * 4 + k)
+                    outcome = InteractionOutcome::TargetKilled;
+            }
+            notifications.push_back({actor, target, outcome});
         }
-        std::this_thread::sleep_for(5ms);
     }
-}
 
-void InteractionManager::stop() {
-    running = false;
+    // Все события тика применяются одновременно, в момент фиксации
+    InteractionMetrics& metrics = interaction_metrics();
+    const std::int64_t applied = metrics_now_ns();
+    for (std::int64_t pushed : pushed_at)
+        metrics.latency.record(static_cast<std::uint64_t>(applied - pushed));
+    metrics.resolved.add(n);
+
+    for (std::uint32_t id : touched) deltas[id] = PendingDelta{};
+    touched.clear();
+    queue.clear();
+    pushed_at.clear();
+    return n;
 }
 
 // ---------------- Сохранение/Загрузка ----------------
@@ -446,7 +679,7 @@ void print_all(const std::vector<std::shared_ptr<NPC>> &list) {
 }
 
 void print_survivors(const std::vector<std::shared_ptr<NPC>>& npcs) {
-    std::lock_guard<std::mutex> lck(print_mutex);
+    std::lock_guard<ProfiledMutex> lck(print_mutex);
     std::cout << "\n=== Survivors ===\n";
     for (auto& npc : npcs)
         if (npc->is_alive()) {
@@ -456,8 +689,10 @@ void print_survivors(const std::vector<std::shared_ptr<NPC>>& npcs) {
 }
 
 void draw_map(const std::vector<std::shared_ptr<NPC>>& list) {
-    std::array<std::pair<std::string, char>, GRID * GRID> field{};
-    field.fill({"", ' '});
+    // Цвет и символ берутся из таблицы TerminalView — без блокировки NPC
+    // и без строки на клетку; кадр собирается целиком и выводится разом
+    std::array<std::pair<const char*, char>, GRID * GRID> field{};
+    field.fill({"0", ' '});
 
     for (auto& npc : list) {
         auto [x, y] = npc->position();
@@ -465,56 +700,94 @@ void draw_map(const std::vector<std::shared_ptr<NPC>>& list) {
         int gx = std::clamp(x * GRID / MAP_X, 0, GRID - 1);
         int gy = std::clamp(y * GRID / MAP_Y, 0, GRID - 1);
 
-        char c;
-        if (!npc->is_alive())
-            c = '*';
-        else {
-            switch (npc->type) {
-                case NPCType::Bear:     c = 'B'; break;
-                case NPCType::Dragon:   c = 'D'; break;
-                case NPCType::Druid:    c = 'D'; break;
-                case NPCType::Orc:      c = 'O'; break;
-                case NPCType::Squirrel: c = 'S'; break;
-                default: c = '?';
-            }
-        }
-
-        field[gx + gy * GRID] = {npc->get_color(npc->type), c};
+        bool alive = npc->is_alive();
+        field[gx + gy * GRID] = {ansi_sgr(npc->type, alive), npc_glyph(npc->type, alive)};
     }
 
-    std::lock_guard<std::mutex> lck(print_mutex);
-
-    std::cout << std::string(3 * GRID, '=') << "\n";
+    std::string out;
+    out.reserve(GRID * GRID * 16);
+    out.append(3 * GRID, '=');
+    out += '\n';
     for (int y = 0; y < GRID; ++y) {
         for (int x = 0; x < GRID; ++x) {
             auto [color, ch] = field[x + y * GRID];
-            std::string reset = "\033[0m";
-            std::cout << "[" << color << ch << reset << "]";
+            out += "[\033[";
+            out += color;
+            out += 'm';
+            out += ch;
+            out += "\033[0m]";
         }
-        std::cout << '\n';
+        out += '\n';
     }
-    std::cout << std::string(3 * GRID, '=') << "\n\n";
+    out.append(3 * GRID, '=');
+    out += "\n\n";
+
+    std::lock_guard<ProfiledMutex> lck(print_mutex);
+    std::cout << out;
 }
 
 // ---------------- Функции рандома ----------------
-NPCType random_type() {
-    static std::mt19937 gen(std::random_device{}());
+RandomSource::RandomSource()
+    : type_gen(std::random_device{}()), coord_gen(std::random_device{}()), gen(std::random_device{}()) {}
+
+RandomSource::RandomSource(std::uint64_t seed_) {
+    seed(seed_);
+}
+
+void RandomSource::seed(std::uint64_t seed) {
+    type_gen.seed(static_cast<std::mt19937::result_type>(splitmix64(seed)));
+    coord_gen.seed(static_cast<std::mt19937::result_type>(splitmix64(seed)));
+    gen.seed(static_cast<std::mt19937::result_type>(splitmix64(seed)));
+}
+
+NPCType RandomSource::type() {
     std::uniform_int_distribution<int> dist(1, static_cast<int>(NPCType::Count) - 1);
-    return static_cast<NPCType>(dist(gen));
+    return static_cast<NPCType>(dist(type_gen));
 }
 
-int random_coord(int min, int max) {
-    static std::mt19937 gen(std::random_device{}());
+int RandomSource::coord(int min, int max) {
     std::uniform_int_distribution<int> dist(min, max);
-    return dist(gen);
+    return dist(coord_gen);
+}
+
+int RandomSource::roll() {
+    std::uniform_int_distribution<int> d(1, 6);
+    return d(gen);
+}
+
+RandomSource& default_random() {
+    static RandomSource source;
+    return source;
+}
+
+NPCType random_type() {
+    return default_random().type();
+}
+
+int random_coord(int min, int max) {
+    return default_random().coord(min, max);
 }
 
 std::mt19937& rng() {
-    static std::mt19937 gen{std::random_device{}()};
-    return gen;
+    return default_random().engine();
 }
 
 int roll() {
-    static std::uniform_int_distribution<int> d(1, 6);
-    return d(rng());
-}
\ No newline at end of file
+    return default_random().roll();
+}
+
+void seed_random(std::uint64_t seed) {
+    default_random().seed(seed);
+}
+
+std::shared_ptr<NPC> NPCFactory::make() {
+    NPCType t = random->type();
+    while (t == NPCType::Dragon && dragons >= max_dragons)
+        t = random->type();
+    if (t == NPCType::Dragon) dragons++;
+
+    const std::string name = std::string(type_to_string(t)) + "_" + std::to_string(++number);
+    const int x = random->coord(0, MAP_X);
+    const int y = random->coord(0, MAP_Y);
+    return createNPC(t, name, x, y);
+}
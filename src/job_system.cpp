@@ -0,0 +1,143 @@
+#include "../include/job_system.h"
+#include "../include/trace.h"
+#include <algorithm>
+#include <string>
+
+// Номер очереди текущего потока: 0 — внешний поток, 1.. — рабочие
+static thread_local std::size_t tls_queue = 0;
+static thread_local const JobSystem* tls_owner = nullptr;
+
+JobSystem::JobSystem(unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    queues.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) queues.push_back(std::make_unique<WorkQueue>());
+
+    workers.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i)
+        workers.emplace_back([this, i]() { workerLoop(i); });
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<ProfiledMutex> lck(sleep_mtx);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+void JobSystem::WorkQueue::pushBack(Job&& job) {
+    if (count == ring.size()) {
+        // Переложить по порядку в буфер вдвое больше
+        std::vector<Job> grown(ring.size() * 2);
+        for (std::size_t i = 0; i < count; ++i)
+            grown[i] = std::move(ring[(head + i) % ring.size()]);
+        ring.swap(grown);
+        head = 0;
+    }
+    ring[(head + count) % ring.size()] = std::move(job);
+    count++;
+}
+
+bool JobSystem::WorkQueue::popBack(Job& job) {
+    if (count == 0) return false;
+    count--;
+    job = std::move(ring[(head + count) % ring.size()]);
+    return true;
+}
+
+bool JobSystem::WorkQueue::popFront(Job& job) {
+    if (count == 0) return false;
+    job = std::move(ring[head]);
+    head = (head + 1) % ring.size();
+    count--;
+    return true;
+}
+
+void JobSystem::spawn(TaskGroup& group, std::function<void()> fn) {
+    Job job;
+    job.fn = std::move(fn);
+    job.group = &group;
+    enqueue(std::move(job));
+}
+
+void JobSystem::spawnRange(TaskGroup& group, RangeFn fn, void* ctx, std::size_t begin, std::size_t end) {
+    Job job;
+    job.range = fn;
+    job.ctx = ctx;
+    job.begin = begin;
+    job.end = end;
+    job.group = &group;
+    enqueue(std::move(job));
+}
+
+void JobSystem::enqueue(Job&& job) {
+    job.group->pending.fetch_add(1, std::memory_order_relaxed);
+    job.subsystem = memory_scope_current();
+    const std::size_t q = tls_owner == this ? tls_queue : 0;
+    {
+        std::lock_guard<ProfiledMutex> lck(queues[q]->mtx);
+        queues[q]->pushBack(std::move(job));
+    }
+    queued.fetch_add(1, std::memory_order_release);
+    if (!workers.empty()) {
+        // Пустой захват мьютекса не даёт уведомлению проскочить мимо засыпающего рабочего
+        { std::lock_guard<ProfiledMutex> lck(sleep_mtx); }
+        wake.notify_one();
+    }
+}
+
+bool JobSystem::popOwn(std::size_t own, Job& job) {
+    WorkQueue& q = *queues[own];
+    std::lock_guard<ProfiledMutex> lck(q.mtx);
+    return q.popBack(job);
+}
+
+bool JobSystem::steal(std::size_t thief, Job& job) {
+    const std::size_t n = queues.size();
+    for (std::size_t k = 1; k < n; ++k) {
+        WorkQueue& q = *queues[(thief + k) % n];
+        std::lock_guard<ProfiledMutex> lck(q.mtx);
+        if (!q.popFront(job)) continue;
+        stolen.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::execute(Job& job) {
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    MemoryScope scope(job.subsystem);
+    TraceZone zone("job");
+    if (job.range) job.range(job.ctx, job.begin, job.end);
+    else job.fn();
+    job.group->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+bool JobSystem::tryRun(std::size_t own) {
+    Job job;
+    if (!popOwn(own, job) && !steal(own, job)) return false;
+    execute(job);
+    return true;
+}
+
+void JobSystem::wait(TaskGroup& group) {
+    const std::size_t own = tls_owner == this ? tls_queue : 0;
+    while (!group.done()) {
+        if (!tryRun(own)) std::this_thread::yield();  // остаток группы доделывают рабочие
+    }
+}
+
+void JobSystem::workerLoop(std::size_t index) {
+    tls_queue = index;
+    tls_owner = this;
+    trace_thread_name("worker " + std::to_string(index));
+    while (true) {
+        if (tryRun(index)) continue;
+
+        std::unique_lock<ProfiledMutex> lck(sleep_mtx);
+        wake.wait(lck, [this]() { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping) return;
+    }
+}
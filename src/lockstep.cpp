@@ -0,0 +1,136 @@
+#include "../include/lockstep.h"
+#include "../include/job_system.h"
+#include "../include/memory_tracker.h"
+#include "../include/sim_clock.h"
+#include "../include/state_hash.h"
+#include "../include/tick_scheduler.h"
+#include "../include/world_context.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+bool parse_lockstep_config(const std::string& text, CombatMode default_combat, LockstepConfig& out) {
+    const std::size_t colon = text.find(':');
+    try {
+        std::size_t used = 0;
+        const unsigned long threads = std::stoul(text.substr(0, colon), &used);
+        if (used != (colon == std::string::npos ? text.size() : colon) || threads == 0) return false;
+        out.threads = static_cast<unsigned>(threads);
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    out.combat = default_combat;
+    if (colon == std::string::npos) return true;
+    const std::string mode = text.substr(colon + 1);
+    if (mode == "two-phase") out.combat = CombatMode::TwoPhase;
+    else if (mode == "sequential") out.combat = CombatMode::Sequential;
+    else return false;
+    return true;
+}
+
+std::vector<std::uint64_t> run_lockstep(const LockstepSetup& setup, const LockstepConfig& config) {
+    // Свой мир с генераторами от seed: тот же порядок потребления, что и в main
+    // (мир, затем зерно планировщика), поэтому хэши совпадают с --seed/--ticks
+    WorldContext world(setup.seed);
+    world.interactions().setCombatMode(config.combat);
+    for (int i = 0; i < setup.npcs; ++i) world.spawn();
+
+    std::vector<std::uint64_t> hashes;
+    hashes.reserve(setup.ticks);
+    JobSystem jobs(config.threads);
+    TickScheduler scheduler(world.store(), jobs, MAP_X, MAP_Y, CELL_SIZE, world.interactions());
+    scheduler.setSeed(world.random().engine()());
+    scheduler.setHashing(true);
+
+    double spawn_debt = 0;
+    for (std::uint64_t t = 0; t < setup.ticks; ++t) {
+        spawn_debt += setup.spawn_rate * SimulationClock::TICK_MS / 1000.0;
+        for (; spawn_debt >= 1.0; spawn_debt -= 1.0) world.spawn();
+        scheduler.tick();
+        hashes.push_back(scheduler.last().world_hash);
+    }
+    return hashes;
+}
+
+static std::string describe(const LockstepConfig& config) {
+    return std::to_string(config.threads) + (config.threads == 1 ? " thread, " : " threads, ") +
+           combat_mode_name(config.combat) + " combat";
+}
+
+bool check_lockstep(const LockstepSetup& setup, const LockstepConfig& a, const LockstepConfig& b) {
+    using clock = std::chrono::steady_clock;
+    std::cout << "=== Lockstep check: seed " << setup.seed << ", " << setup.ticks << " ticks, " << setup.npcs
+              << " NPCs, spawn rate " << setup.spawn_rate << " ===\n";
+
+    const LockstepConfig configs[2] = {a, b};
+    std::vector<std::uint64_t> hashes[2];
+    for (int k = 0; k < 2; ++k) {
+        const auto start = clock::now();
+        hashes[k] = run_lockstep(setup, configs[k]);
+        const double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        std::cout << (k == 0 ? "A" : "B") << ": " << describe(configs[k]) << " -> final hash ";
+        state_hash::write_hex(std::cout, hashes[k].empty() ? 0 : hashes[k].back())
+            << " (" << std::fixed << std::setprecision(1) << ms << " ms)\n";
+    }
+
+    for (std::size_t t = 0; t < hashes[0].size(); ++t) {
+        if (hashes[0][t] == hashes[1][t]) continue;
+        std::cout << "DIVERGED at tick " << t + 1 << ": A ";
+        state_hash::write_hex(std::cout, hashes[0][t]) << " vs B ";
+        state_hash::write_hex(std::cout, hashes[1][t]) << "\n";
+        return false;
+    }
+    std::cout << "identical: all " << hashes[0].size() << " tick hashes match\n";
+    return true;
+}
+
+bool check_steady_allocations(const LockstepSetup& setup, const LockstepConfig& config, std::uint64_t warmup) {
+    std::cout << "=== Steady-state allocation check: seed " << setup.seed << ", " << setup.npcs << " NPCs, "
+              << warmup << " warm-up + " << setup.ticks << " ticks, spawn rate " << setup.spawn_rate << ", "
+              << describe(config) << " ===\n";
+    if (!memory_tracking_enabled()) {
+        std::cerr << "allocation counts need a build with PIXELRPG_TRACK_ALLOCATIONS=ON\n";
+        return false;
+    }
+
+    WorldContext world(setup.seed);
+    world.interactions().setCombatMode(config.combat);
+    for (int i = 0; i < setup.npcs; ++i) world.spawn();
+
+    JobSystem jobs(config.threads);
+    TickScheduler scheduler(world.store(), jobs, MAP_X, MAP_Y, CELL_SIZE, world.interactions());
+    scheduler.setSeed(world.random().engine()());
+
+    constexpr std::size_t MAX_REPORTED = 10;
+    std::size_t failed = 0, shrinks = 0;
+    std::uint64_t total = 0;
+    double spawn_debt = 0;
+    for (std::uint64_t t = 0; t < warmup + setup.ticks; ++t) {
+        spawn_debt += setup.spawn_rate * SimulationClock::TICK_MS / 1000.0;
+        for (; spawn_debt >= 1.0; spawn_debt -= 1.0) world.spawn();
+        scheduler.tick();
+
+        const std::uint64_t allocs = scheduler.last().allocations;
+        if (t < warmup || allocs == 0) continue;
+        if (scheduler.last().shrunk) {
+            // Буферы тика ужаты после всплеска — разовое выделение, не утечка в цикле
+            std::cout << "tick " << t + 1 << ": " << allocs << " heap allocations while shrinking tick buffers\n";
+            shrinks++;
+            continue;
+        }
+        total += allocs;
+        if (++failed <= MAX_REPORTED)
+            std::cout << "tick " << t + 1 << ": " << allocs << " heap allocations (" << world.store().size()
+                      << " NPCs, " << scheduler.last().candidates << " pairs)\n";
+    }
+
+    if (failed == 0) {
+        std::cout << "ok: no heap allocations in " << setup.ticks << " ticks after warm-up";
+        if (shrinks) std::cout << " (besides " << shrinks << " buffer shrinks)";
+        std::cout << "\n";
+        return true;
+    }
+    std::cout << "FAILED: " << failed << " of " << setup.ticks << " ticks allocated, " << total << " allocations\n";
+    return false;
+}
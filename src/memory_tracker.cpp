@@ -0,0 +1,204 @@
+#include "../include/memory_tracker.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+static thread_local MemSubsystem tls_subsystem = MemSubsystem::Other;
+
+const char* mem_subsystem_name(MemSubsystem subsystem) {
+    switch (subsystem) {
+        case MemSubsystem::Other:        return "other";
+        case MemSubsystem::World:        return "world";
+        case MemSubsystem::Grid:         return "grid";
+        case MemSubsystem::Interactions: return "interactions";
+        case MemSubsystem::Observers:    return "observers";
+        case MemSubsystem::Logs:         return "logs";
+        case MemSubsystem::Snapshots:    return "snapshots";
+        case MemSubsystem::Effects:      return "effects";
+        case MemSubsystem::Count:        break;
+    }
+    return "?";
+}
+
+MemSubsystem memory_scope_current() { return tls_subsystem; }
+void memory_scope_set(MemSubsystem subsystem) { tls_subsystem = subsystem; }
+
+#ifdef PIXELRPG_TRACK_ALLOCATIONS
+
+namespace {
+
+struct AtomicCounters {
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> frees{0};
+    std::atomic<std::int64_t> live_bytes{0};
+    std::atomic<std::int64_t> peak_bytes{0};
+};
+
+// Статическая инициализация нулями: счётчики готовы до первого operator new
+AtomicCounters counters[MEM_SUBSYSTEM_COUNT];
+
+// Заголовок перед каждым блоком: размер и подсистема для operator delete.
+// 16 байт сохраняют выравнивание max_align_t у пользовательского указателя.
+struct alignas(16) BlockHeader {
+    std::size_t size;
+    MemSubsystem subsystem;
+};
+static_assert(sizeof(BlockHeader) == 16, "header must keep malloc alignment");
+
+void count_alloc(MemSubsystem subsystem, std::size_t size) {
+    AtomicCounters& c = counters[static_cast<std::size_t>(subsystem)];
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    const std::int64_t live = c.live_bytes.fetch_add(static_cast<std::int64_t>(size), std::memory_order_relaxed) +
+                              static_cast<std::int64_t>(size);
+    std::int64_t peak = c.peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !c.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+}
+
+void count_free(MemSubsystem subsystem, std::size_t size) {
+    // Освобождение засчитывается подсистеме, которая выделяла
+    AtomicCounters& c = counters[static_cast<std::size_t>(subsystem)];
+    c.frees.fetch_add(1, std::memory_order_relaxed);
+    c.live_bytes.fetch_sub(static_cast<std::int64_t>(size), std::memory_order_relaxed);
+}
+
+void* tracked_alloc(std::size_t size) {
+    auto* header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size));
+    if (!header) return nullptr;
+    header->size = size;
+    header->subsystem = tls_subsystem;
+    count_alloc(header->subsystem, size);
+    return header + 1;
+}
+
+void tracked_free(void* p) {
+    if (!p) return;
+    auto* header = static_cast<BlockHeader*>(p) - 1;
+    count_free(header->subsystem, header->size);
+    std::free(header);
+}
+
+// Выравнивание сверх __STDCPP_DEFAULT_NEW_ALIGNMENT__ (alignas(64) у шардов
+// метрик, SpscQueue): блок берётся с запасом, указатель выравнивается, а
+// заголовок с началом блока лежит прямо перед ним
+struct AlignedHeader {
+    void* block;
+    std::size_t size;
+    MemSubsystem subsystem;
+};
+
+void* tracked_alloc_aligned(std::size_t size, std::align_val_t align) {
+    const std::size_t alignment = std::max(static_cast<std::size_t>(align), alignof(AlignedHeader));
+    void* block = std::malloc(sizeof(AlignedHeader) + alignment + size);
+    if (!block) return nullptr;
+    const auto first = reinterpret_cast<std::uintptr_t>(block) + sizeof(AlignedHeader);
+    auto* user = reinterpret_cast<void*>((first + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1));
+    auto* header = static_cast<AlignedHeader*>(user) - 1;
+    header->block = block;
+    header->size = size;
+    header->subsystem = tls_subsystem;
+    count_alloc(header->subsystem, size);
+    return user;
+}
+
+void tracked_free_aligned(void* p) {
+    if (!p) return;
+    auto* header = static_cast<AlignedHeader*>(p) - 1;
+    count_free(header->subsystem, header->size);
+    std::free(header->block);
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    if (void* p = tracked_alloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* p = tracked_alloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return tracked_alloc(size ? size : 1); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return tracked_alloc(size ? size : 1); }
+
+void operator delete(void* p) noexcept { tracked_free(p); }
+void operator delete[](void* p) noexcept { tracked_free(p); }
+void operator delete(void* p, std::size_t) noexcept { tracked_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { tracked_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { tracked_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { tracked_free(p); }
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    if (void* p = tracked_alloc_aligned(size ? size : 1, align)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    if (void* p = tracked_alloc_aligned(size ? size : 1, align)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return tracked_alloc_aligned(size ? size : 1, align);
+}
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return tracked_alloc_aligned(size ? size : 1, align);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept { tracked_free_aligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { tracked_free_aligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { tracked_free_aligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { tracked_free_aligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { tracked_free_aligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { tracked_free_aligned(p); }
+
+bool memory_tracking_enabled() { return true; }
+
+MemSnapshot memory_snapshot() {
+    MemSnapshot snap{};
+    for (std::size_t i = 0; i < MEM_SUBSYSTEM_COUNT; ++i) {
+        snap[i].allocations = counters[i].allocations.load(std::memory_order_relaxed);
+        snap[i].frees = counters[i].frees.load(std::memory_order_relaxed);
+        snap[i].live_bytes = counters[i].live_bytes.load(std::memory_order_relaxed);
+        snap[i].peak_bytes = counters[i].peak_bytes.load(std::memory_order_relaxed);
+    }
+    return snap;
+}
+
+std::uint64_t memory_total_allocations() {
+    std::uint64_t total = 0;
+    for (const auto& c : counters) total += c.allocations.load(std::memory_order_relaxed);
+    return total;
+}
+
+#else
+
+bool memory_tracking_enabled() { return false; }
+MemSnapshot memory_snapshot() { return MemSnapshot{}; }
+std::uint64_t memory_total_allocations() { return 0; }
+
+#endif
+
+void print_memory_report(std::size_t npc_count) {
+    if (!memory_tracking_enabled()) return;
+    const MemSnapshot snap = memory_snapshot();
+
+    std::cout << "\n=== Memory by subsystem ===\n"
+              << std::left << std::setw(14) << "subsystem" << std::right
+              << std::setw(12) << "allocs" << std::setw(12) << "frees"
+              << std::setw(14) << "live bytes" << std::setw(14) << "peak bytes" << "\n";
+    for (std::size_t i = 0; i < MEM_SUBSYSTEM_COUNT; ++i) {
+        const MemCounters& c = snap[i];
+        std::cout << std::left << std::setw(14) << mem_subsystem_name(static_cast<MemSubsystem>(i)) << std::right
+                  << std::setw(12) << c.allocations << std::setw(12) << c.frees
+                  << std::setw(14) << c.live_bytes << std::setw(14) << c.peak_bytes << "\n";
+    }
+    if (npc_count > 0) {
+        const auto world = snap[static_cast<std::size_t>(MemSubsystem::World)].live_bytes;
+        std::cout << "world bytes per live NPC: " << world / static_cast<std::int64_t>(npc_count) << "\n";
+    }
+}
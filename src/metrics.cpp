@@ -0,0 +1,213 @@
+#include "../include/metrics.h"
+#include "../include/memory_tracker.h"
+#include "../include/trace.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <unordered_set>
+
+// ---------------- Метрики ----------------
+std::uint64_t Counter::value() const {
+    std::uint64_t total = 0;
+    for (const Shard& s : shards) total += s.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+std::uint64_t Histogram::bucketLow(std::size_t b) {
+    if (b < SUB) return b;
+    const std::size_t group = b / SUB;
+    return (SUB + b % SUB) << (group - 1);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snap;
+    for (const Shard& s : shards) {
+        for (std::size_t b = 0; b < BUCKETS; ++b)
+            snap.buckets[b] += s.buckets[b].load(std::memory_order_relaxed);
+        snap.count += s.count.load(std::memory_order_relaxed);
+        snap.sum += s.sum.load(std::memory_order_relaxed);
+    }
+    return snap;
+}
+
+std::uint64_t Histogram::Snapshot::percentile(double p) const {
+    if (count == 0) return 0;
+    const auto rank = static_cast<std::uint64_t>(p * static_cast<double>(count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t b = 0; b < BUCKETS; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) return bucketLow(b) + bucketWidth(b) - 1;
+    }
+    return ~std::uint64_t{0};
+}
+
+// ---------------- Реестр ----------------
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Entry& MetricsRegistry::find(Kind kind, const std::string& name, const std::string& help,
+                                              const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (Entry& e : entries)
+        if (e.kind == kind && e.name == name && e.labels == labels) return e;
+
+    Entry& e = entries.emplace_back();
+    e.kind = kind;
+    e.name = name;
+    e.help = help;
+    e.labels = labels;
+    return e;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    Entry& e = find(Kind::Counter, name, help, labels);
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!e.counter) e.counter = std::make_unique<Counter>();
+    return *e.counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, const std::string& labels) {
+    Entry& e = find(Kind::Gauge, name, help, labels);
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!e.gauge) e.gauge = std::make_unique<Gauge>();
+    return *e.gauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, double scale,
+                                      const std::string& labels) {
+    Entry& e = find(Kind::Histogram, name, help, labels);
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!e.histogram) {
+        e.histogram = std::make_unique<Histogram>();
+        e.scale = scale;
+    }
+    return *e.histogram;
+}
+
+// ---------------- Текстовый формат Prometheus ----------------
+// Метки серии: свои метки плюс дополнительная (le для корзин)
+static std::string series_labels(const std::string& own, const std::string& extra = {}) {
+    if (own.empty() && extra.empty()) return {};
+    if (own.empty()) return "{" + extra + "}";
+    if (extra.empty()) return "{" + own + "}";
+    return "{" + own + "," + extra + "}";
+}
+
+// Корзины экспортируются по степеням двойки: у лог-линейной гистограммы
+// это границы групп, поэтому накопленные счётчики точные
+static void write_histogram(std::ostream& out, const std::string& name, const std::string& labels, double scale,
+                            const Histogram::Snapshot& snap) {
+    std::size_t last = 0;
+    for (std::size_t b = 0; b < Histogram::BUCKETS; ++b)
+        if (snap.buckets[b]) last = b;
+    const std::uint64_t top = Histogram::bucketLow(last) + Histogram::bucketWidth(last);
+
+    std::uint64_t cumulative = 0;
+    std::size_t b = 0;
+    for (std::uint64_t edge = 1; snap.count > 0; edge <<= 1) {
+        for (; b < Histogram::BUCKETS && Histogram::bucketLow(b) + Histogram::bucketWidth(b) <= edge; ++b)
+            cumulative += snap.buckets[b];
+        std::ostringstream le;
+        le << std::setprecision(10) << "le=\"" << static_cast<double>(edge) * scale << "\"";
+        out << name << "_bucket" << series_labels(labels, le.str()) << ' ' << cumulative << '\n';
+        if (edge >= top || edge >> 63) break;
+    }
+    out << name << "_bucket" << series_labels(labels, "le=\"+Inf\"") << ' ' << snap.count << '\n'
+        << name << "_sum" << series_labels(labels) << ' ' << static_cast<double>(snap.sum) * scale << '\n'
+        << name << "_count" << series_labels(labels) << ' ' << snap.count << '\n';
+}
+
+static void write_memory(std::ostream& out) {
+    const MemSnapshot snap = memory_snapshot();
+    auto family = [&](const char* name, const char* help, const char* type, auto field) {
+        out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+        for (std::size_t i = 0; i < MEM_SUBSYSTEM_COUNT; ++i)
+            out << name << "{subsystem=\"" << mem_subsystem_name(static_cast<MemSubsystem>(i)) << "\"} "
+                << field(snap[i]) << '\n';
+    };
+    family("pixelrpg_memory_allocations_total", "Heap allocations by subsystem.", "counter",
+           [](const MemCounters& c) { return static_cast<std::int64_t>(c.allocations); });
+    family("pixelrpg_memory_frees_total", "Heap frees by subsystem.", "counter",
+           [](const MemCounters& c) { return static_cast<std::int64_t>(c.frees); });
+    family("pixelrpg_memory_live_bytes", "Heap bytes currently allocated by subsystem.", "gauge",
+           [](const MemCounters& c) { return c.live_bytes; });
+    family("pixelrpg_memory_peak_bytes", "Peak heap bytes by subsystem.", "gauge",
+           [](const MemCounters& c) { return c.peak_bytes; });
+}
+
+void MetricsRegistry::writePrometheus(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    out << std::setprecision(10);
+
+    // Серии одного семейства идут подряд под общими HELP/TYPE, в порядке регистрации
+    std::unordered_set<std::string> written;
+    for (const Entry& family : entries) {
+        if (!written.insert(family.name).second) continue;
+        out << "# HELP " << family.name << ' ' << family.help << '\n'
+            << "# TYPE " << family.name << ' '
+            << (family.kind == Kind::Counter ? "counter" : family.kind == Kind::Gauge ? "gauge" : "histogram")
+            << '\n';
+
+        for (const Entry& e : entries) {
+            if (e.name != family.name || e.kind != family.kind) continue;
+            switch (e.kind) {
+                case Kind::Counter:
+                    out << e.name << series_labels(e.labels) << ' ' << (e.counter ? e.counter->value() : 0) << '\n';
+                    break;
+                case Kind::Gauge:
+                    out << e.name << series_labels(e.labels) << ' ' << (e.gauge ? e.gauge->value() : 0) << '\n';
+                    break;
+                case Kind::Histogram:
+                    if (e.histogram) write_histogram(out, e.name, e.labels, e.scale, e.histogram->snapshot());
+                    break;
+            }
+        }
+    }
+
+    if (memory_tracking_enabled()) write_memory(out);
+}
+
+// ---------------- Выгрузка в файл ----------------
+MetricsFileExporter::MetricsFileExporter(std::string path_, double interval_s)
+    : path(std::move(path_)), interval(std::max(0.1, interval_s))
+{
+    worker = std::thread([this]() {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (!wake.wait_for(lock, interval, [this] { return stopping; })) {
+            lock.unlock();
+            writeNow();
+            lock.lock();
+        }
+    });
+}
+
+MetricsFileExporter::~MetricsFileExporter() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+    writeNow();  // итог прогона
+}
+
+bool MetricsFileExporter::writeNow() {
+    TraceZone zone("MetricsFileExporter::writeNow");
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::trunc);
+        if (!f.good()) return false;
+        MetricsRegistry::instance().writePrometheus(f);
+        if (!f.good()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) return false;
+    ++written;
+    return true;
+}
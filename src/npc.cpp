@@ -21,19 +21,19 @@ void NPC::subscribe(const std::shared_ptr<IInteractionObserver> &obs) {
     observers.push_back(obs);
 }
 
-void NPC::notify_interaction(const std::shared_ptr<NPC>& other,
+void NPC::notify_interaction(const NPCStore& world, NPCHandle target,
                        InteractionOutcome outcome)
 {
-
+    const NPCHandle self = handle();
     for (auto &o : observers)
-        o->on_interaction(std::shared_ptr<NPC>(this, [](NPC *) {}), other, outcome);
+        o->on_interaction(world, self, target, outcome);
 }
 
 void NPC::save(std::ostream &os) const {
     os << static_cast<int>(type) << ' ' << name << ' ' << x << ' ' << y << '\n';
 }
 
-std::string type_to_string(NPCType t) {
+std::string_view type_to_string(NPCType t) {
     switch (t) {
         case NPCType::Bear:     return "Bear";
         case NPCType::Dragon:   return "Dragon";
@@ -44,6 +44,17 @@ std::string type_to_string(NPCType t) {
     }
 }
 
+const char* outcome_name(InteractionOutcome outcome) {
+    switch (outcome) {
+        case InteractionOutcome::TargetKilled:  return "killed";
+        case InteractionOutcome::TargetHurted:  return "hurt";
+        case InteractionOutcome::TargetEscaped: return "escaped";
+        case InteractionOutcome::TargetHealed:  return "healed";
+        case InteractionOutcome::NoInteraction: return "none";
+    }
+    return "?";
+}
+
 void NPC::print(std::ostream &os) const {
     os << name << " [" << type_to_string(type) << "] at (" << x << "," << y << ")";
 }
@@ -51,8 +62,8 @@ void NPC::print(std::ostream &os) const {
 // ИСПРАВЛЕНО: Добавлена защита mutex
 bool NPC::is_close(const std::shared_ptr<NPC> &other, int distance) const {
     // Блокировка обоих NPC для атомарного чтения координат
-    std::lock_guard<std::mutex> lck1(mtx);
-    std::lock_guard<std::mutex> lck2(other->mtx);
+    std::lock_guard<ProfiledMutex> lck1(mtx);
+    std::lock_guard<ProfiledMutex> lck2(other->mtx);
     
     int dx = x - other->x;
     int dy = y - other->y;
@@ -61,7 +72,7 @@ bool NPC::is_close(const std::shared_ptr<NPC> &other, int distance) const {
 }
 
 void NPC::move(int shift_x, int shift_y, int max_x, int max_y) {
-    std::lock_guard<std::mutex> lck(mtx);
+    std::lock_guard<ProfiledMutex> lck(mtx);
     
     // Сохранить предыдущую позицию для интерполяции
     prev_x = x;
@@ -75,8 +86,18 @@ void NPC::move(int shift_x, int shift_y, int max_x, int max_y) {
     grid_cell = {x / 5, y / 5};
 }
 
+void NPC::move_to(int new_x, int new_y, std::chrono::steady_clock::time_point when) {
+    std::lock_guard<ProfiledMutex> lck(mtx);
+    prev_x = x;
+    prev_y = y;
+    last_move_time = when;
+    x = new_x;
+    y = new_y;
+    grid_cell = {x / 5, y / 5};
+}
+
 std::pair<float, float> NPC::get_visual_position(float interpolation_time_ms) const {
-    std::lock_guard<std::mutex> lck(mtx);
+    std::lock_guard<ProfiledMutex> lck(mtx);
     
     auto now = std::chrono::steady_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_move_time).count();
@@ -93,27 +114,27 @@ std::pair<float, float> NPC::get_visual_position(float interpolation_time_ms) co
 }
 
 bool NPC::is_alive() const {
-    std::lock_guard<std::mutex> lck(mtx);
+    std::lock_guard<ProfiledMutex> lck(mtx);
     return alive;
 }
 
 void NPC::must_die() {
-    std::lock_guard<std::mutex> lck(mtx);
+    std::lock_guard<ProfiledMutex> lck(mtx);
     alive = false;
 }
 
 void NPC::heal() {
-    std::lock_guard<std::mutex> lck(mtx);
+    std::lock_guard<ProfiledMutex> lck(mtx);
     health = get_max_health();
 }
 
 std::pair<int,int> NPC::position() const {
-    std::lock_guard<std::mutex> lck(mtx);
+    std::lock_guard<ProfiledMutex> lck(mtx);
     return {x, y};
 }
 
 std::string NPC::get_color(NPCType t) const {
-    std::lock_guard<std::mutex> lck(mtx);
+    std::lock_guard<ProfiledMutex> lck(mtx);
     switch (t) {
         case NPCType::Bear:     return "\033[33m";
         case NPCType::Dragon:   return "\033[0;33m";
@@ -171,7 +192,7 @@ int NPC::get_damage_amount() const {
 }
 
 bool NPC::get_state(int& x_, int& y_) const {
-    std::lock_guard<std::mutex> lck(mtx);
+    std::lock_guard<ProfiledMutex> lck(mtx);
     if (!alive) return false;
     x_ = x;
     y_ = y;
@@ -179,18 +200,18 @@ bool NPC::get_state(int& x_, int& y_) const {
 }
 
 // НОВЫЙ МЕТОД: Получить расстояние до другого NPC
-int NPC::get_distance_to(const std::shared_ptr<NPC> &other) const {
-    std::lock_guard<std::mutex> lck1(mtx);
-    std::lock_guard<std::mutex> lck2(other->mtx);
+int NPC::get_distance_to(const NPC &other) const {
+    std::lock_guard<ProfiledMutex> lck1(mtx);
+    std::lock_guard<ProfiledMutex> lck2(other.mtx);
     
-    int dx = x - other->x;
-    int dy = y - other->y;
+    int dx = x - other.x;
+    int dy = y - other.y;
     
     return static_cast<int>(std::sqrt(dx * dx + dy * dy));
 }
 
 int NPC::get_current_health() const {
-    std::lock_guard<std::mutex> lck(mtx);
+    std::lock_guard<ProfiledMutex> lck(mtx);
     return health;
 }
 
@@ -211,4 +232,22 @@ std::shared_ptr<NPC> createNPCFromStream(std::istream &is) {
     int x, y;
     if (!(is >> t >> name >> x >> y)) return nullptr;
     return createNPC(static_cast<NPCType>(t), name, x, y);
+}
+
+std::shared_ptr<NPC> cloneNPC(const NPC &src, bool keep_observers) {
+    auto copy = createNPC(src.type, src.name, 0, 0);
+    if (!copy) return nullptr;
+    std::lock_guard<ProfiledMutex> lck(src.mtx);
+    copy->id = src.id;
+    copy->generation = src.generation;
+    copy->x = src.x;
+    copy->y = src.y;
+    copy->health = src.health;
+    copy->alive = src.alive;
+    copy->prev_x = src.prev_x;
+    copy->prev_y = src.prev_y;
+    copy->last_move_time = src.last_move_time;
+    copy->grid_cell = src.grid_cell;
+    if (keep_observers) copy->observers = src.observers;
+    return copy;
 }
\ No newline at end of file
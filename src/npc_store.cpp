@@ -0,0 +1,186 @@
+#include "../include/npc_store.h"
+#include "../include/memory_tracker.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+NPCStore::NPCStore(std::vector<std::shared_ptr<NPC>>& npcs_) : npcs(npcs_) {
+    if (npcs.size() > NPCHandle::MAX_SLOTS)
+        throw std::length_error("NPCStore: more than " + std::to_string(NPCHandle::MAX_SLOTS) + " NPC slots");
+    slots.resize(npcs.size());
+    for (std::size_t i = 0; i < npcs.size(); ++i) {
+        npcs[i]->id = static_cast<std::uint32_t>(i);
+        slots[i] = Slot{static_cast<std::uint32_t>(i), npcs[i]->generation};
+    }
+}
+
+NPCStore::NPCStore(std::vector<std::shared_ptr<NPC>>& npcs_, NPCStore& parent)
+    : npcs(npcs_), free_slots(parent.free_slots), removed_count(parent.removed_count), packed(true)
+{
+    MemoryScope scope(MemSubsystem::World);
+    parent.pack();
+    slots = parent.slots;
+    for (Slot& slot : slots) slot.inherited = slot.dense != FREE;
+    chunks = parent.chunks;
+    sharing = !chunks.empty();
+    parent.sharing = parent.sharing || sharing;
+    npcs = parent.npcs;  // ссылки, не копии NPC
+}
+
+void NPCStore::pack() {
+    if (packed) return;
+    packed = true;
+    trackChunks();
+    for (const auto& npc : npcs) {
+        ChunkState& state = *chunks[npc->id / CHUNK_SLOTS];
+        const std::size_t k = npc->id % CHUNK_SLOTS;
+        std::lock_guard<ProfiledMutex> lck(npc->mtx);
+        state.x[k] = npc->x;
+        state.y[k] = npc->y;
+        state.health[k] = npc->health;
+        state.alive[k] = npc->alive ? 1 : 0;
+    }
+}
+
+void NPCStore::trackChunks() {
+    while (chunks.size() * CHUNK_SLOTS < slots.size()) chunks.push_back(std::make_shared<ChunkState>());
+}
+
+std::pair<int, int> NPCStore::position(const NPC& npc) const {
+    if (!packed) return npc.position();
+    const ChunkState& state = stateOf(npc.id);
+    return {state.x[npc.id % CHUNK_SLOTS], state.y[npc.id % CHUNK_SLOTS]};
+}
+
+bool NPCStore::getState(const NPC& npc, int& x, int& y) const {
+    if (!packed) return npc.get_state(x, y);
+    const ChunkState& state = stateOf(npc.id);
+    const std::size_t k = npc.id % CHUNK_SLOTS;
+    if (!state.alive[k]) return false;
+    x = state.x[k];
+    y = state.y[k];
+    return true;
+}
+
+int NPCStore::distance(const NPC& a, const NPC& b) const {
+    if (!packed) return a.get_distance_to(b);
+    const ChunkState& sa = stateOf(a.id);
+    const ChunkState& sb = stateOf(b.id);
+    const int dx = sa.x[a.id % CHUNK_SLOTS] - sb.x[b.id % CHUNK_SLOTS];
+    const int dy = sa.y[a.id % CHUNK_SLOTS] - sb.y[b.id % CHUNK_SLOTS];
+    return static_cast<int>(std::sqrt(dx * dx + dy * dy));
+}
+
+bool NPCStore::setHealth(NPC& npc, int value) {
+    const bool alive = value > 0;
+    value = std::max(value, 0);
+    if (!packed) {
+        std::lock_guard<ProfiledMutex> lck(npc.mtx);
+        npc.health = value;
+        if (!alive) npc.alive = false;
+        return npc.alive;
+    }
+    ChunkState& state = writableState(npc.id);
+    const std::size_t k = npc.id % CHUNK_SLOTS;
+    state.health[k] = value;
+    if (!alive) state.alive[k] = 0;
+    return state.alive[k] != 0;
+}
+
+NPCStore::ChunkState& NPCStore::writableState(std::uint32_t slot) {
+    const std::size_t chunk = slot / CHUNK_SLOTS;
+    copyChunk(chunk, false);
+    return *chunks[chunk];
+}
+
+void NPCStore::copyInherited() {
+    MemoryScope scope(MemSubsystem::World);
+    for (Slot& slot : slots) {
+        if (!slot.inherited) continue;
+        auto& npc = npcs[slot.dense];
+        npc = cloneNPC(*npc, false);
+        slot.inherited = false;
+    }
+}
+
+bool NPCStore::chunkShared(std::size_t chunk) const {
+    if (chunks[chunk].use_count() == 1) {
+        // Другой мир мог только что отпустить кусок после копирования
+        // наших общих массивов: его чтения должны завершиться до нашей записи
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return false;
+    }
+    return true;
+}
+
+bool NPCStore::copyChunk(std::size_t chunk, bool live_only) {
+    if (!chunkShared(chunk)) return false;
+    const ChunkState& shared = *chunks[chunk];
+    if (live_only) {
+        const std::size_t begin = chunk * CHUNK_SLOTS;
+        const std::size_t end = std::min(slots.size(), begin + CHUNK_SLOTS);
+        bool live = false;
+        for (std::size_t s = begin; s < end && !live; ++s)
+            live = slots[s].dense != FREE && shared.alive[s - begin];
+        if (!live) return false;  // мёртвых тик не меняет, их удалит уплотнение
+    }
+
+    MemoryScope scope(MemSubsystem::World);
+    chunks[chunk] = std::make_shared<ChunkState>(shared);
+    copied_chunks.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void NPCStore::refreshSharing() {
+    sharing = false;
+    for (std::size_t c = 0; c < chunks.size() && !sharing; ++c) sharing = chunkShared(c);
+}
+
+NPCHandle NPCStore::spawn(std::shared_ptr<NPC> npc) {
+    MemoryScope scope(MemSubsystem::World);
+    std::uint32_t slot_index;
+    if (!free_slots.empty()) {
+        slot_index = free_slots.back();
+        free_slots.pop_back();
+    } else {
+        if (slots.size() >= NPCHandle::MAX_SLOTS)
+            throw std::length_error("NPCStore: more than " + std::to_string(NPCHandle::MAX_SLOTS) + " NPC slots");
+        slot_index = static_cast<std::uint32_t>(slots.size());
+        slots.emplace_back();
+        if (packed) trackChunks();
+    }
+
+    Slot& slot = slots[slot_index];
+    slot.dense = static_cast<std::uint32_t>(npcs.size());
+    slot.inherited = false;
+    npc->id = slot_index;
+    npc->generation = slot.generation;
+    if (packed) {
+        // Новый NPC только что создан: его поля — начальное состояние
+        ChunkState& state = writableState(slot_index);
+        const std::size_t k = slot_index % CHUNK_SLOTS;
+        state.x[k] = npc->x;
+        state.y[k] = npc->y;
+        state.health[k] = npc->health;
+        state.alive[k] = npc->alive ? 1 : 0;
+    }
+    npcs.push_back(std::move(npc));
+    return npcs.back()->handle();
+}
+
+void NPCStore::remove(std::size_t index) {
+    Slot& slot = slots[npcs[index]->id];
+    slot.dense = FREE;
+    slot.inherited = false;
+    ++slot.generation;  // переполнение допустимо: 8 бит ловят ссылки на недавно удалённых
+    free_slots.push_back(npcs[index]->id);
+
+    if (index + 1 != npcs.size()) {
+        npcs[index] = std::move(npcs.back());
+        slots[npcs[index]->id].dense = static_cast<std::uint32_t>(index);
+    }
+    npcs.pop_back();
+    ++removed_count;
+}
@@ -0,0 +1,104 @@
+#include "../include/particle_pool.h"
+#include <algorithm>
+#include <cmath>
+
+ParticlePool::ParticlePool(std::size_t capacity)
+    : cap(capacity),
+      x(capacity), y(capacity),
+      vx(capacity), vy(capacity),
+      life(capacity), inv_max_life(capacity),
+      rgba(capacity)
+{
+}
+
+void ParticlePool::setFrameBudget(std::size_t budget) {
+    frame_budget = budget;
+}
+
+float ParticlePool::nextUnit() {
+    // xorshift32 — достаточно для визуального разброса и не требует блокировок
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return static_cast<float>(rng_state >> 8) * (1.0f / 16777216.0f);
+}
+
+std::size_t ParticlePool::spawn(float px, float py, int requested, std::uint32_t color, float lifetime) {
+    if (requested <= 0 || lifetime <= 0.0f) return 0;
+
+    std::size_t budget_left = frame_budget > spawned_this_frame ? frame_budget - spawned_this_frame : 0;
+    std::size_t free_slots = cap - count;
+    if (budget_left == 0 || free_slots == 0) return 0;
+
+    // Плавная деградация: после заполнения пула наполовину каждый взрыв
+    // получает всё меньше частиц, но хотя бы одну — чтобы эффект не пропал.
+    float occupancy = static_cast<float>(count) / static_cast<float>(cap);
+    std::size_t wanted = static_cast<std::size_t>(requested);
+    if (occupancy > 0.5f) {
+        float scale = (1.0f - occupancy) * 2.0f;
+        wanted = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(wanted * scale)));
+    }
+
+    std::size_t granted = std::min({wanted, budget_left, free_slots});
+    const float inv_life = 1.0f / lifetime;
+
+    for (std::size_t k = 0; k < granted; ++k) {
+        float angle = nextUnit() * 2.0f * 3.14159f;
+        float speed = 20.0f + nextUnit() * 40.0f;
+
+        std::size_t i = count++;
+        x[i] = px;
+        y[i] = py;
+        vx[i] = std::cos(angle) * speed;
+        vy[i] = std::sin(angle) * speed;
+        life[i] = lifetime;
+        inv_max_life[i] = inv_life;
+        rgba[i] = color;
+    }
+
+    spawned_this_frame += granted;
+    return granted;
+}
+
+void ParticlePool::update(float dt) {
+    spawned_this_frame = 0;
+
+    const std::size_t n = count;
+    float* __restrict px = x.data();
+    float* __restrict py = y.data();
+    const float* __restrict pvx = vx.data();
+    const float* __restrict pvy = vy.data();
+    float* __restrict pl = life.data();
+
+    // Без ветвлений — цикл векторизуется компилятором
+    for (std::size_t i = 0; i < n; ++i) {
+        px[i] += pvx[i] * dt;
+        py[i] += pvy[i] * dt;
+        pl[i] -= dt;
+    }
+
+    std::size_t i = 0;
+    while (i < count) {
+        if (life[i] <= 0.0f)
+            removeAt(i);
+        else
+            ++i;
+    }
+}
+
+void ParticlePool::removeAt(std::size_t i) {
+    std::size_t last = --count;
+    if (i == last) return;
+    x[i] = x[last];
+    y[i] = y[last];
+    vx[i] = vx[last];
+    vy[i] = vy[last];
+    life[i] = life[last];
+    inv_max_life[i] = inv_max_life[last];
+    rgba[i] = rgba[last];
+}
+
+void ParticlePool::clear() {
+    count = 0;
+    spawned_this_frame = 0;
+}
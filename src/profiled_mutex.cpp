@@ -0,0 +1,125 @@
+#include "../include/profiled_mutex.h"
+#include "../include/metrics.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef PIXELRPG_PROFILE_LOCKS
+
+// Статистика места блокировки; метрики живут в реестре и попадают в --metrics-file
+struct LockSite {
+    const char* name;
+    Counter& acquisitions;
+    Counter& contended;
+    Histogram& wait_ns;
+    Histogram& hold_ns;
+};
+
+namespace {
+
+// Глобальные мьютексы (print_mutex) создаются при статической инициализации,
+// поэтому список мест — статики функций, а не переменные файла
+std::mutex& sites_mutex() {
+    static std::mutex m;
+    return m;
+}
+
+std::vector<std::unique_ptr<LockSite>>& all_sites() {
+    static std::vector<std::unique_ptr<LockSite>> sites;
+    return sites;
+}
+
+LockSite* lock_site(const char* name) {
+    std::lock_guard<std::mutex> lock(sites_mutex());
+    auto& sites = all_sites();
+    for (auto& site : sites)
+        if (std::string_view(site->name) == name) return site.get();
+
+    MetricsRegistry& r = MetricsRegistry::instance();
+    const std::string label = std::string("site=\"") + name + "\"";
+    sites.push_back(std::make_unique<LockSite>(LockSite{
+        name,
+        r.counter("pixelrpg_lock_acquisitions_total", "Lock acquisitions per lock site.", label),
+        r.counter("pixelrpg_lock_contended_total", "Lock acquisitions that had to wait.", label),
+        r.histogram("pixelrpg_lock_wait_seconds", "Time spent waiting to acquire a lock.", 1e-9, label),
+        r.histogram("pixelrpg_lock_hold_seconds", "Time a lock was held.", 1e-9, label)}));
+    return sites.back().get();
+}
+
+} // namespace
+
+ProfiledMutex::ProfiledMutex(const char* site_name) : site(lock_site(site_name)) {}
+
+void ProfiledMutex::lock() {
+    std::int64_t waited = 0;
+    if (!m.try_lock()) {
+        const std::int64_t start = metrics_now_ns();
+        m.lock();
+        locked_at = metrics_now_ns();
+        waited = locked_at - start;
+        site->contended.add();
+    } else {
+        locked_at = metrics_now_ns();
+    }
+    site->acquisitions.add();
+    site->wait_ns.record(static_cast<std::uint64_t>(waited));
+}
+
+bool ProfiledMutex::try_lock() {
+    if (!m.try_lock()) return false;
+    locked_at = metrics_now_ns();
+    site->acquisitions.add();
+    site->wait_ns.record(0);
+    return true;
+}
+
+void ProfiledMutex::unlock() {
+    const std::int64_t held = metrics_now_ns() - locked_at;
+    m.unlock();
+    site->hold_ns.record(static_cast<std::uint64_t>(held));
+}
+
+bool lock_profiling_enabled() { return true; }
+
+void print_lock_report() {
+    struct Row {
+        const char* name;
+        std::uint64_t acquisitions, contended;
+        Histogram::Snapshot wait, hold;
+    };
+    std::vector<Row> rows;
+    {
+        std::lock_guard<std::mutex> lock(sites_mutex());
+        for (const auto& site : all_sites())
+            rows.push_back({site->name, site->acquisitions.value(), site->contended.value(),
+                            site->wait_ns.snapshot(), site->hold_ns.snapshot()});
+    }
+    // Без ожиданий (один поток) порядок задаёт время удержания
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+        return a.wait.sum != b.wait.sum ? a.wait.sum > b.wait.sum : a.hold.sum > b.hold.sum;
+    });
+
+    std::cout << "\n=== Lock contention (by total wait) ===\n"
+              << std::left << std::setw(28) << "site" << std::right
+              << std::setw(12) << "acquired" << std::setw(11) << "contended"
+              << std::setw(12) << "wait ms" << std::setw(12) << "wait p99" << std::setw(12) << "hold ms"
+              << std::setw(12) << "hold p99" << "\n"
+              << std::fixed << std::setprecision(1);
+    for (const Row& r : rows) {
+        if (r.acquisitions == 0) continue;
+        std::cout << std::left << std::setw(28) << r.name << std::right
+                  << std::setw(12) << r.acquisitions
+                  << std::setw(10) << 100.0 * static_cast<double>(r.contended) / static_cast<double>(r.acquisitions) << '%'
+                  << std::setw(12) << r.wait.sum / 1e6 << std::setw(9) << r.wait.percentile(0.99) / 1e3 << " us"
+                  << std::setw(12) << r.hold.sum / 1e6 << std::setw(9) << r.hold.percentile(0.99) / 1e3 << " us\n";
+    }
+}
+
+#else
+
+bool lock_profiling_enabled() { return false; }
+void print_lock_report() {}
+
+#endif
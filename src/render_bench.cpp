@@ -0,0 +1,90 @@
+#include "../include/render_bench.h"
+#include "../include/frame_builder.h"
+#include "../include/game_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+int run_render_benchmark(int frames, int npc_count, float zoom) {
+    using clock = std::chrono::steady_clock;
+
+    std::vector<std::shared_ptr<NPC>> npcs;
+    npcs.reserve(npc_count);
+    for (int i = 0; i < npc_count; ++i) {
+        NPCType t = random_type();
+        auto npc = createNPC(t, std::string(type_to_string(t)) + "_" + std::to_string(i + 1),
+                             random_coord(0, MAP_X), random_coord(0, MAP_Y));
+        npc->id = static_cast<std::uint32_t>(i);
+        npcs.push_back(npc);
+    }
+
+    NPCStore store(npcs);
+    auto obs = std::static_pointer_cast<VisualObserver>(VisualObserver::get());
+    SnapshotPublisher snapshots;
+    snapshots.publish(npcs, true);
+
+    FrameBuilder builder;
+    RenderCommandList commands;
+    if (zoom != 1.0f) {
+        Viewport vp = builder.camera().view(800, 600);
+        builder.camera().zoomAt(zoom, 400, 300, vp);
+    }
+    NullRenderBackend backend;
+    std::vector<double> build_us;
+    build_us.reserve(frames);
+
+    const std::string message = "Benchmark frame";
+    const int frames_per_tick = 30;  // 500 мс симуляции при 60 FPS
+    const InteractionOutcome outcomes[] = {
+        InteractionOutcome::TargetKilled, InteractionOutcome::TargetHurted,
+        InteractionOutcome::TargetEscaped, InteractionOutcome::TargetHealed
+    };
+
+    auto now = clock::now();
+    for (int f = 0; f < frames; ++f) {
+        if (f % frames_per_tick == 0) {
+            for (auto& npc : npcs) {
+                int d = npc->get_move_distance();
+                npc->move(std::rand() % (2 * d + 1) - d, std::rand() % (2 * d + 1) - d, MAP_X, MAP_Y);
+            }
+            snapshots.publish(npcs, true);
+        }
+
+        // Несколько взаимодействий за кадр — как в разгар битвы
+        for (int k = 0; k < 4 && npc_count > 1; ++k) {
+            NPCHandle a = store.handle(std::rand() % npc_count);
+            NPCHandle b = store.handle(std::rand() % npc_count);
+            obs->on_interaction(store, a, b, outcomes[std::rand() % 4]);
+        }
+
+        now += std::chrono::microseconds(16667);
+        auto start = clock::now();
+        obs->updateParticles(1.0f / 60.0f);
+        builder.build(snapshots.acquire(), *obs, now, 800, 600, message, commands);
+        backend.execute(commands);
+        build_us.push_back(std::chrono::duration<double, std::micro>(clock::now() - start).count());
+    }
+
+    if (build_us.empty()) return 0;
+    std::sort(build_us.begin(), build_us.end());
+    double sum = 0;
+    for (double v : build_us) sum += v;
+    auto pct = [&](double p) { return build_us[static_cast<std::size_t>(p * (build_us.size() - 1))]; };
+
+    const auto& stats = builder.stats();
+    std::cout << "\n=== Render benchmark (" << frames << " frames, " << npc_count << " NPCs, zoom "
+              << builder.camera().zoom() << ") ===\n"
+              << std::fixed << std::setprecision(1)
+              << "build avg: " << sum / build_us.size() << " us"
+              << " | p50: " << pct(0.50) << " us"
+              << " | p99: " << pct(0.99) << " us"
+              << " | max: " << build_us.back() << " us\n"
+              << "commands/frame: " << (backend.quads + backend.circles) / backend.frames
+              << " (quads " << backend.quads / backend.frames
+              << ", circles " << backend.circles / backend.frames
+              << ")\n"
+              << "last frame: " << (stats.heatmap ? "density heatmap" : "sprites")
+              << ", sprites " << stats.sprites << ", culled " << stats.culled << "\n";
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include "../include/render_commands.h"
+
+void RenderCommandList::clear() {
+    cmds.clear();
+}
+
+void RenderCommandList::quad(float x, float y, float w, float h, std::uint32_t color) {
+    cmds.push_back({RenderCommandType::Quad, TextureId::None, x, y, w, h, color, {}});
+}
+
+void RenderCommandList::texturedQuad(TextureId tex, float x, float y, float w, float h, std::uint32_t color) {
+    cmds.push_back({RenderCommandType::Quad, tex, x, y, w, h, color, {}});
+}
+
+void RenderCommandList::sprite(TextureId tex, TextureRect src, float x, float y, float w, float h, std::uint32_t color) {
+    cmds.push_back({RenderCommandType::Quad, tex, x, y, w, h, color, src});
+}
+
+void RenderCommandList::circle(float cx, float cy, float radius, std::uint32_t color) {
+    cmds.push_back({RenderCommandType::Circle, TextureId::None, cx, cy, radius, radius, color, {}});
+}
+
+void RenderCommandList::outline(float x, float y, float w, float h, float thickness, std::uint32_t color) {
+    quad(x - thickness, y - thickness, w + 2 * thickness, thickness, color);  // верх
+    quad(x - thickness, y + h, w + 2 * thickness, thickness, color);          // низ
+    quad(x - thickness, y, thickness, h, color);                              // лево
+    quad(x + w, y, thickness, h, color);                                      // право
+}
+
+void NullRenderBackend::execute(const RenderCommandList& list) {
+    frames++;
+    for (const auto& cmd : list.commands()) {
+        switch (cmd.type) {
+            case RenderCommandType::Quad:   quads++;   break;
+            case RenderCommandType::Circle: circles++; break;
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#include "../include/render_snapshot.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void SnapshotPublisher::publish(const std::vector<std::shared_ptr<NPC>>& npcs, bool new_tick, std::uint64_t removed) {
+    std::lock_guard<ProfiledMutex> lck(writer_mtx);
+
+    if (new_tick) {
+        ++tick;
+        tick_time = std::chrono::steady_clock::now();
+        if (sim_clock) tick_sim_ms = sim_clock->tickTime();
+    }
+
+    FrameSnapshot& snap = buffer.writeBuffer();
+    snap.tick = tick;
+    snap.version = ++version;
+    snap.tick_time = tick_time;
+    snap.tick_sim_ms = tick_sim_ms;
+    snap.alive_count = 0;
+    snap.dead_count = static_cast<int>(removed);
+    snap.npcs.resize(npcs.size());  // ёмкость переиспользуется между кадрами
+    snap.slot_index.assign(snap.slot_index.size(), FrameSnapshot::NO_INDEX);
+
+    for (std::size_t i = 0; i < npcs.size(); ++i) {
+        const auto& npc = npcs[i];
+        NPCRenderState& st = snap.npcs[i];
+        if (!npc) {
+            st = NPCRenderState{};
+            continue;
+        }
+
+        {
+            std::lock_guard<ProfiledMutex> npc_lck(npc->mtx);
+            st.x = static_cast<float>(npc->x);
+            st.y = static_cast<float>(npc->y);
+            st.prev_x = static_cast<float>(npc->prev_x);
+            st.prev_y = static_cast<float>(npc->prev_y);
+            st.health = npc->health;
+            st.alive = npc->alive;
+        }
+        st.max_health = npc->get_max_health();
+        st.type = npc->type;
+        st.handle = npc->handle();
+        const std::uint32_t slot = st.handle.index();
+        if (slot >= snap.slot_index.size()) snap.slot_index.resize(slot + 1, FrameSnapshot::NO_INDEX);
+        snap.slot_index[slot] = static_cast<std::uint32_t>(i);
+
+        std::size_t len = std::min(npc->name.size(), sizeof(st.name) - 1);
+        std::memcpy(st.name, npc->name.data(), len);
+        st.name[len] = '\0';
+
+        if (st.alive) snap.alive_count++;
+        else snap.dead_count++;
+    }
+
+    buffer.publish();
+}
+
+void SnapshotPublisher::publishFrame(const FrameSnapshot& frame) {
+    std::lock_guard<ProfiledMutex> lck(writer_mtx);
+
+    tick = frame.tick;
+    tick_time = std::chrono::steady_clock::now();
+    if (sim_clock) tick_sim_ms = sim_clock->tickTime();
+
+    FrameSnapshot& snap = buffer.writeBuffer();
+    snap.tick = tick;
+    snap.version = ++version;
+    snap.tick_time = tick_time;
+    snap.tick_sim_ms = tick_sim_ms;
+    snap.npcs = frame.npcs;  // присваивание переиспользует ёмкость
+    snap.slot_index = frame.slot_index;
+    snap.alive_count = frame.alive_count;
+    snap.dead_count = frame.dead_count;
+
+    buffer.publish();
+}
+
+const FrameSnapshot& SnapshotPublisher::acquire() {
+    buffer.update();
+    return buffer.readBuffer();
+}
+
+static float ease_out_quartic(float elapsed_ms, float interpolation_time_ms) {
+    float t = std::clamp(elapsed_ms / interpolation_time_ms, 0.0f, 1.0f);
+
+    // Ease-out quartic, как в NPC::get_visual_position
+    float inv = 1.0f - t;
+    return 1.0f - inv * inv * inv * inv;
+}
+
+float snapshot_interpolation(const FrameSnapshot& snap,
+                             std::chrono::steady_clock::time_point now,
+                             float interpolation_time_ms)
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - snap.tick_time).count();
+    return ease_out_quartic(static_cast<float>(elapsed), interpolation_time_ms);
+}
+
+float snapshot_interpolation(const FrameSnapshot& snap, double sim_now_ms, float interpolation_time_ms) {
+    return ease_out_quartic(static_cast<float>(sim_now_ms - snap.tick_sim_ms), interpolation_time_ms);
+}
@@ -0,0 +1,101 @@
+#include "../include/sfml_backend.h"
+#include <cmath>
+
+SfmlRenderBackend::SfmlRenderBackend(sf::RenderTarget& target_)
+    : target(target_)
+{
+}
+
+void SfmlRenderBackend::setTexture(TextureId id, const sf::Texture* texture) {
+    textures[static_cast<std::size_t>(id)] = texture;
+}
+
+void SfmlRenderBackend::setSolidTexel(TextureId id, sf::Vector2f uv) {
+    solid_texture = id;
+    solid_uv = uv;
+}
+
+TextureId SfmlRenderBackend::batchTextureFor(const RenderCommand& cmd) const {
+    if (cmd.type == RenderCommandType::Quad && cmd.texture != TextureId::None) return cmd.texture;
+    return solid_texture;
+}
+
+void SfmlRenderBackend::execute(const RenderCommandList& list) {
+    draw_calls = 0;
+    target.clear(sf::Color(list.clear_color));
+
+    // Текст — тоже квады атласа, поэтому пакет разрывается только
+    // при смене текстуры (атлас <-> карта плотности)
+    for (const auto& cmd : list.commands()) {
+        TextureId tex = batchTextureFor(cmd);
+        if (tex != batch_texture) flush();
+        batch_texture = tex;
+
+        if (cmd.type == RenderCommandType::Quad) appendQuad(cmd);
+        else appendCircle(cmd);
+    }
+    flush();
+}
+
+void SfmlRenderBackend::flush() {
+    if (batch.getVertexCount() == 0) return;
+
+    sf::RenderStates states;
+    states.texture = textures[static_cast<std::size_t>(batch_texture)];
+    target.draw(batch, states);
+    draw_calls++;
+    batch.clear();
+}
+
+void SfmlRenderBackend::appendQuad(const RenderCommand& cmd) {
+    sf::Color color(cmd.color);
+
+    sf::Vector2f p0(cmd.x, cmd.y);
+    sf::Vector2f p1(cmd.x + cmd.w, cmd.y);
+    sf::Vector2f p2(cmd.x + cmd.w, cmd.y + cmd.h);
+    sf::Vector2f p3(cmd.x, cmd.y + cmd.h);
+
+    sf::Vector2f t0, t1, t2, t3;
+    if (cmd.texture == TextureId::None) {
+        t0 = t1 = t2 = t3 = solid_uv;
+    } else if (cmd.src.w > 0) {
+        float u0 = cmd.src.x, v0 = cmd.src.y;
+        float u1 = u0 + cmd.src.w, v1 = v0 + cmd.src.h;
+        t0 = sf::Vector2f(u0, v0);
+        t1 = sf::Vector2f(u1, v0);
+        t2 = sf::Vector2f(u1, v1);
+        t3 = sf::Vector2f(u0, v1);
+    } else if (const sf::Texture* tex = textures[static_cast<std::size_t>(cmd.texture)]) {
+        auto size = tex->getSize();
+        float tw = static_cast<float>(size.x);
+        float th = static_cast<float>(size.y);
+        t0 = sf::Vector2f(0, 0);
+        t1 = sf::Vector2f(tw, 0);
+        t2 = sf::Vector2f(tw, th);
+        t3 = sf::Vector2f(0, th);
+    }
+
+    batch.append(sf::Vertex(p0, color, t0));
+    batch.append(sf::Vertex(p1, color, t1));
+    batch.append(sf::Vertex(p2, color, t2));
+    batch.append(sf::Vertex(p0, color, t0));
+    batch.append(sf::Vertex(p2, color, t2));
+    batch.append(sf::Vertex(p3, color, t3));
+}
+
+void SfmlRenderBackend::appendCircle(const RenderCommand& cmd) {
+    constexpr int SEGMENTS = 24;
+    constexpr float STEP = 2.0f * 3.14159265f / SEGMENTS;
+
+    sf::Color color(cmd.color);
+    sf::Vector2f center(cmd.x, cmd.y);
+    sf::Vector2f prev(cmd.x + cmd.w, cmd.y);
+
+    for (int i = 1; i <= SEGMENTS; ++i) {
+        sf::Vector2f next(cmd.x + std::cos(i * STEP) * cmd.w, cmd.y + std::sin(i * STEP) * cmd.w);
+        batch.append(sf::Vertex(center, color, solid_uv));
+        batch.append(sf::Vertex(prev, color, solid_uv));
+        batch.append(sf::Vertex(next, color, solid_uv));
+        prev = next;
+    }
+}
@@ -0,0 +1,86 @@
+#include "../include/sim_clock.h"
+#include "../include/trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+SimulationClock::SimulationClock() : base_wall(clock::now()) {
+}
+
+double SimulationClock::nowLocked(clock::time_point wall) const {
+    if (sim_speed == UNTHROTTLED) return frontier + TICK_MS;
+    if (paused) return base_sim;
+    return base_sim + std::chrono::duration<double, std::milli>(wall - base_wall).count() * sim_speed;
+}
+
+// Запомнить текущее время как новую точку отсчёта (перед сменой скорости или паузы)
+void SimulationClock::rebase(clock::time_point wall) {
+    base_sim = nowLocked(wall);
+    base_wall = wall;
+}
+
+void SimulationClock::setSpeed(float speed) {
+    std::lock_guard<ProfiledMutex> lck(mtx);
+    rebase(clock::now());
+    sim_speed = std::max(0.0f, speed);
+}
+
+float SimulationClock::speed() const {
+    std::lock_guard<ProfiledMutex> lck(mtx);
+    return sim_speed;
+}
+
+void SimulationClock::setPaused(bool p) {
+    std::lock_guard<ProfiledMutex> lck(mtx);
+    if (paused == p) return;
+    rebase(clock::now());
+    paused = p;
+}
+
+double SimulationClock::now() const {
+    std::lock_guard<ProfiledMutex> lck(mtx);
+    return nowLocked(clock::now());
+}
+
+double SimulationClock::tickTime() const {
+    std::lock_guard<ProfiledMutex> lck(mtx);
+    return frontier;
+}
+
+bool SimulationClock::waitForNextTick(const std::atomic<bool>& running) {
+    TraceZone zone("SimulationClock::waitForNextTick");
+    std::unique_lock<ProfiledMutex> lck(mtx);
+    const double next = frontier + TICK_MS;
+
+    while (running && sim_speed != UNTHROTTLED) {
+        const auto wall = clock::now();
+        const double ahead = next - nowLocked(wall);
+        if (ahead <= 0 && !paused) {
+            // Симуляция не успевает за скоростью: отставание не догоняем
+            // рывком, а сдвигаем точку отсчёта
+            if (-ahead > 2 * TICK_MS) {
+                base_sim = next;
+                base_wall = wall;
+            }
+            break;
+        }
+
+        // Спим короткими отрезками, чтобы смена скорости и остановка
+        // подхватывались быстро
+        const double wall_ms = paused ? 50.0 : std::min(50.0, ahead / sim_speed);
+        lck.unlock();
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(wall_ms));
+        lck.lock();
+    }
+
+    if (!running) return false;
+    frontier = next;
+    return true;
+}
+
+const char* speed_label(float speed) {
+    if (speed == SimulationClock::UNTHROTTLED) return "max";
+    static thread_local char buf[16];
+    std::snprintf(buf, sizeof(buf), "x%g", speed);
+    return buf;
+}
@@ -0,0 +1,44 @@
+#include "../include/spatial_index.h"
+#include <cmath>
+
+void SnapshotGrid::build(const std::vector<NPCRenderState>& npcs, float world_w, float world_h, float cell_size) {
+    cell = cell_size;
+    // +1: координаты лежат в [0, MAP] включительно
+    cols = static_cast<int>(world_w / cell) + 1;
+    rows = static_cast<int>(world_h / cell) + 1;
+
+    const std::size_t cells = static_cast<std::size_t>(cols) * rows;
+    cell_start.assign(cells + 1, 0);
+    cell_of.resize(npcs.size());
+    max_step = 0;
+
+    constexpr std::uint32_t NONE = ~0u;
+
+    // Проход 1: клетка каждого NPC и размеры клеток
+    for (std::size_t i = 0; i < npcs.size(); ++i) {
+        const NPCRenderState& npc = npcs[i];
+        if (npc.type == NPCType::Unknown) {
+            cell_of[i] = NONE;
+            continue;
+        }
+        int c = std::clamp(cellOf(npc.x), 0, cols - 1);
+        int r = std::clamp(cellOf(npc.y), 0, rows - 1);
+        std::uint32_t k = static_cast<std::uint32_t>(r) * cols + c;
+        cell_of[i] = k;
+        cell_start[k + 1]++;
+
+        max_step = std::max(max_step, std::max(std::fabs(npc.x - npc.prev_x), std::fabs(npc.y - npc.prev_y)));
+    }
+
+    // Префиксные суммы -> начало каждой клетки
+    for (std::size_t k = 0; k < cells; ++k)
+        cell_start[k + 1] += cell_start[k];
+
+    // Проход 2: раскладка индексов (порядок внутри клетки — по возрастанию индекса)
+    items.resize(cell_start[cells]);
+    fill.assign(cell_start.begin(), cell_start.end() - 1);
+    for (std::size_t i = 0; i < npcs.size(); ++i) {
+        if (cell_of[i] == NONE) continue;
+        items[fill[cell_of[i]]++] = static_cast<std::uint32_t>(i);
+    }
+}
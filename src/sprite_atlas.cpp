@@ -0,0 +1,506 @@
+#include "../include/sprite_atlas.h"
+#include "../include/bitmap_font.h"
+#include "../include/font_5x7.h"
+#include "../include/render_commands.h"
+#include <array>
+
+// Холст атласа, на котором рисуют constexpr-функции. Координаты — внутри
+// прямоугольника r; всё, что выходит за него, отбрасывается.
+struct AtlasCanvas {
+    std::array<std::uint32_t, ATLAS_WIDTH * ATLAS_HEIGHT> px{};
+
+    constexpr void set(TextureRect r, int x, int y, std::uint32_t color) {
+        if (x >= 0 && x < r.w && y >= 0 && y < r.h)
+            px[static_cast<std::size_t>(r.y + y) * ATLAS_WIDTH + r.x + x] = color;
+    }
+
+    constexpr std::uint8_t alpha(TextureRect r, int x, int y) const {
+        return static_cast<std::uint8_t>(px[static_cast<std::size_t>(r.y + y) * ATLAS_WIDTH + r.x + x] & 0xFF);
+    }
+};
+
+// ---------------- Спрайты NPC ----------------
+// === ОРК ===
+static constexpr void paint_orc(AtlasCanvas& canvas, TextureRect r) {
+    constexpr std::uint32_t orcBody = rgba(200, 50, 50);      // Красный
+    constexpr std::uint32_t orcDark = rgba(140, 30, 30);      // Тёмно-красный
+    constexpr std::uint32_t orcEye = rgba(255, 255, 0);       // Жёлтый глаз
+    constexpr std::uint32_t orcTooth = rgba(255, 255, 255);   // Белый зуб
+    
+    // Тело (грубый овал)
+    for (int y = 10; y < 26; ++y) {
+        for (int x = 8; x < 24; ++x) {
+            int dx = x - 16;
+            int dy = y - 18;
+            if (dx*dx/64.0 + dy*dy/64.0 < 1.0) {
+                canvas.set(r, x, y, orcBody);
+            }
+        }
+    }
+    
+    // Голова
+    for (int y = 6; y < 14; ++y) {
+        for (int x = 10; x < 22; ++x) {
+            int dx = x - 16;
+            int dy = y - 10;
+            if (dx*dx/36.0 + dy*dy/16.0 < 1.0) {
+                canvas.set(r, x, y, orcBody);
+            }
+        }
+    }
+    
+    // Глаза
+    canvas.set(r, 13, 9, orcEye);
+    canvas.set(r, 19, 9, orcEye);
+    
+    // Зубы (клыки)
+    canvas.set(r, 14, 12, orcTooth);
+    canvas.set(r, 18, 12, orcTooth);
+    canvas.set(r, 14, 13, orcTooth);
+    canvas.set(r, 18, 13, orcTooth);
+    
+    // Тени для объёма
+    for (int y = 20; y < 26; ++y) {
+        for (int x = 8; x < 12; ++x) {
+            if (canvas.alpha(r, x, y) > 0) {
+                canvas.set(r, x, y, orcDark);
+            }
+        }
+    }
+}
+
+// === БЕЛКА ===
+static constexpr void paint_squirrel(AtlasCanvas& canvas, TextureRect r) {
+    constexpr std::uint32_t sqBody = rgba(180, 90, 40);       // Коричневый
+    constexpr std::uint32_t sqDark = rgba(120, 60, 20);       // Тёмно-коричневый
+    constexpr std::uint32_t sqEye = rgba(0, 0, 0);            // Чёрный глаз
+    constexpr std::uint32_t sqNose = rgba(255, 150, 150);     // Розовый нос
+    
+    // Тело (маленькое)
+    for (int y = 14; y < 24; ++y) {
+        for (int x = 12; x < 20; ++x) {
+            int dx = x - 16;
+            int dy = y - 19;
+            if (dx*dx/16.0 + dy*dy/25.0 < 1.0) {
+                canvas.set(r, x, y, sqBody);
+            }
+        }
+    }
+    
+    // Голова
+    for (int y = 8; y < 16; ++y) {
+        for (int x = 12; x < 20; ++x) {
+            int dx = x - 16;
+            int dy = y - 12;
+            if (dx*dx/16.0 + dy*dy/16.0 < 1.0) {
+                canvas.set(r, x, y, sqBody);
+            }
+        }
+    }
+    
+    // Уши (треугольные)
+    canvas.set(r, 13, 7, sqBody);
+    canvas.set(r, 13, 6, sqBody);
+    canvas.set(r, 19, 7, sqBody);
+    canvas.set(r, 19, 6, sqBody);
+    
+    // Пушистый хвост (большой и кудрявый)
+    for (int y = 16; y < 28; ++y) {
+        for (int x = 18; x < 28; ++x) {
+            int dx = x - 22;
+            int dy = y - 22;
+            if (dx*dx/36.0 + dy*dy/36.0 < 1.0) {
+                canvas.set(r, x, y, sqDark);
+            }
+        }
+    }
+    
+    // Глаза
+    canvas.set(r, 14, 11, sqEye);
+    canvas.set(r, 18, 11, sqEye);
+    
+    // Нос
+    canvas.set(r, 16, 13, sqNose);
+}
+
+// === МЕДВЕДЬ ===
+static constexpr void paint_bear(AtlasCanvas& canvas, TextureRect r) {
+    constexpr std::uint32_t bearBody = rgba(101, 67, 33);     // Коричневый
+    constexpr std::uint32_t bearDark = rgba(70, 45, 20);      // Тёмно-коричневый
+    constexpr std::uint32_t bearEye = rgba(0, 0, 0);          // Чёрный
+    constexpr std::uint32_t bearNose = rgba(50, 50, 50);      // Серый нос
+    
+    // Тело (крупное)
+    for (int y = 12; y < 28; ++y) {
+        for (int x = 6; x < 26; ++x) {
+            int dx = x - 16;
+            int dy = y - 20;
+            if (dx*dx/100.0 + dy*dy/64.0 < 1.0) {
+                canvas.set(r, x, y, bearBody);
+            }
+        }
+    }
+    
+    // Голова (большая круглая)
+    for (int y = 4; y < 16; ++y) {
+        for (int x = 10; x < 22; ++x) {
+            int dx = x - 16;
+            int dy = y - 10;
+            if (dx*dx/36.0 + dy*dy/36.0 < 1.0) {
+                canvas.set(r, x, y, bearBody);
+            }
+        }
+    }
+    
+    // Уши (круглые)
+    for (int y = 3; y < 7; ++y) {
+        for (int x = 10; x < 14; ++x) {
+            int dx = x - 12;
+            int dy = y - 5;
+            if (dx*dx/4.0 + dy*dy/4.0 < 1.0) {
+                canvas.set(r, x, y, bearDark);
+            }
+        }
+    }
+    for (int y = 3; y < 7; ++y) {
+        for (int x = 18; x < 22; ++x) {
+            int dx = x - 20;
+            int dy = y - 5;
+            if (dx*dx/4.0 + dy*dy/4.0 < 1.0) {
+                canvas.set(r, x, y, bearDark);
+            }
+        }
+    }
+    
+    // Глаза
+    canvas.set(r, 13, 9, bearEye);
+    canvas.set(r, 14, 9, bearEye);
+    canvas.set(r, 18, 9, bearEye);
+    canvas.set(r, 19, 9, bearEye);
+    
+    // Морда
+    canvas.set(r, 15, 12, bearDark);
+    canvas.set(r, 16, 12, bearNose);
+    canvas.set(r, 17, 12, bearDark);
+    canvas.set(r, 16, 13, bearDark);
+    
+    // Тени
+    for (int y = 22; y < 28; ++y) {
+        for (int x = 6; x < 12; ++x) {
+            if (canvas.alpha(r, x, y) > 0) {
+                canvas.set(r, x, y, bearDark);
+            }
+        }
+    }
+}
+
+// === ДРУИД ===
+static constexpr void paint_druid(AtlasCanvas& canvas, TextureRect r) {
+    constexpr std::uint32_t druidRobe = rgba(50, 150, 100);   // Зелёная роба
+    constexpr std::uint32_t druidDark = rgba(30, 100, 60);    // Тёмно-зелёный
+    constexpr std::uint32_t druidSkin = rgba(255, 220, 180);  // Кожа
+    constexpr std::uint32_t druidHair = rgba(100, 70, 40);    // Волосы
+    constexpr std::uint32_t druidEye = rgba(100, 150, 255);   // Голубые глаза
+    constexpr std::uint32_t druidLeaf = rgba(100, 255, 100);  // Яркий лист
+    
+    // Роба (треугольная форма)
+    for (int y = 14; y < 28; ++y) {
+        int width = (y - 14) / 2 + 4;
+        for (int x = 16 - width; x < 16 + width; ++x) {
+            canvas.set(r, x, y, druidRobe);
+        }
+    }
+    
+    // Голова
+    for (int y = 6; y < 14; ++y) {
+        for (int x = 12; x < 20; ++x) {
+            int dx = x - 16;
+            int dy = y - 10;
+            if (dx*dx/16.0 + dy*dy/16.0 < 1.0) {
+                canvas.set(r, x, y, druidSkin);
+            }
+        }
+    }
+    
+    // Волосы/борода
+    for (int x = 11; x < 21; ++x) {
+        canvas.set(r, x, 6, druidHair);
+        canvas.set(r, x, 7, druidHair);
+    }
+    canvas.set(r, 12, 13, druidHair);
+    canvas.set(r, 13, 13, druidHair);
+    canvas.set(r, 18, 13, druidHair);
+    canvas.set(r, 19, 13, druidHair);
+    
+    // Глаза
+    canvas.set(r, 13, 10, druidEye);
+    canvas.set(r, 19, 10, druidEye);
+    
+    // Магический листок над головой (символ природы)
+    canvas.set(r, 16, 3, druidLeaf);
+    canvas.set(r, 15, 4, druidLeaf);
+    canvas.set(r, 16, 4, druidLeaf);
+    canvas.set(r, 17, 4, druidLeaf);
+    canvas.set(r, 16, 5, druidLeaf);
+    
+    // Посох в руке (сбоку от робы)
+    for (int y = 16; y < 28; ++y) {
+        canvas.set(r, 22, y, druidHair);
+    }
+    canvas.set(r, 21, 15, druidLeaf);
+    canvas.set(r, 22, 15, druidLeaf);
+    canvas.set(r, 23, 15, druidLeaf);
+    
+    // Тени на робе
+    for (int y = 20; y < 28; ++y) {
+        canvas.set(r, 16 - (y-14)/2, y, druidDark);
+    }
+}
+
+// === ДРАКОН ===
+static constexpr void paint_dragon(AtlasCanvas& canvas, TextureRect r) {
+    constexpr std::uint32_t dragonBody = rgba(180, 50, 50);      // Тёмно-красный
+    constexpr std::uint32_t dragonDark = rgba(120, 30, 30);      // Очень тёмно-красный
+    constexpr std::uint32_t dragonScale = rgba(220, 80, 80);     // Светлые чешуйки
+    constexpr std::uint32_t dragonEye = rgba(255, 200, 0);       // Золотой глаз
+    constexpr std::uint32_t dragonFire = rgba(255, 150, 0);      // Огонь
+    constexpr std::uint32_t dragonHorn = rgba(240, 240, 240);    // Рога
+    
+    // Тело (массивное)
+    for (int y = 15; y < 28; ++y) {
+        for (int x = 8; x < 24; ++x) {
+            int dx = x - 16;
+            int dy = y - 21;
+            if (dx*dx/64.0 + dy*dy/49.0 < 1.0) {
+                canvas.set(r, x, y, dragonBody);
+            }
+        }
+    }
+    
+    // Голова (большая, угловатая)
+    for (int y = 6; y < 17; ++y) {
+        for (int x = 10; x < 22; ++x) {
+            int dx = x - 16;
+            int dy = y - 11;
+            if (dx*dx/36.0 + dy*dy/25.0 < 1.0) {
+                canvas.set(r, x, y, dragonBody);
+            }
+        }
+    }
+    
+    // Морда (вытянутая)
+    for (int x = 16; x < 20; ++x) {
+        canvas.set(r, x, 14, dragonDark);
+        canvas.set(r, x, 15, dragonDark);
+    }
+    
+    // Рога (два острых)
+    canvas.set(r, 12, 5, dragonHorn);
+    canvas.set(r, 12, 4, dragonHorn);
+    canvas.set(r, 12, 3, dragonHorn);
+    canvas.set(r, 11, 4, dragonHorn);
+    
+    canvas.set(r, 20, 5, dragonHorn);
+    canvas.set(r, 20, 4, dragonHorn);
+    canvas.set(r, 20, 3, dragonHorn);
+    canvas.set(r, 21, 4, dragonHorn);
+    
+    // Глаз (светящийся)
+    canvas.set(r, 13, 10, dragonEye);
+    canvas.set(r, 14, 10, dragonEye);
+    canvas.set(r, 13, 11, dragonEye);
+    canvas.set(r, 14, 11, dragonEye);
+    
+    // Зрачок
+    canvas.set(r, 13, 10, rgba(0, 0, 0));
+    
+    // Крылья (острые, сложенные)
+    // Левое крыло
+    for (int y = 12; y < 22; ++y) {
+        for (int x = 4; x < 10; ++x) {
+            int dx = x - 7;
+            int dy = y - 17;
+            if (dx*dx/9.0 + dy*dy/25.0 < 1.0) {
+                canvas.set(r, x, y, dragonDark);
+            }
+        }
+    }
+    
+    // Правое крыло
+    for (int y = 12; y < 22; ++y) {
+        for (int x = 22; x < 28; ++x) {
+            int dx = x - 25;
+            int dy = y - 17;
+            if (dx*dx/9.0 + dy*dy/25.0 < 1.0) {
+                canvas.set(r, x, y, dragonDark);
+            }
+        }
+    }
+    
+    // Чешуйки на теле (для деталей)
+    canvas.set(r, 12, 18, dragonScale);
+    canvas.set(r, 14, 20, dragonScale);
+    canvas.set(r, 16, 22, dragonScale);
+    canvas.set(r, 18, 20, dragonScale);
+    canvas.set(r, 20, 18, dragonScale);
+    
+    canvas.set(r, 11, 20, dragonScale);
+    canvas.set(r, 13, 22, dragonScale);
+    canvas.set(r, 19, 22, dragonScale);
+    canvas.set(r, 21, 20, dragonScale);
+    
+    // Пламя изо рта
+    canvas.set(r, 20, 14, dragonFire);
+    canvas.set(r, 21, 14, dragonFire);
+    canvas.set(r, 22, 14, dragonFire);
+    canvas.set(r, 21, 13, dragonFire);
+    canvas.set(r, 22, 13, rgba(255, 220, 100));
+    
+    // Хвост (острый кончик сзади)
+    canvas.set(r, 23, 26, dragonDark);
+    canvas.set(r, 24, 27, dragonDark);
+    canvas.set(r, 25, 28, dragonDark);
+    canvas.set(r, 26, 29, dragonDark);
+    
+    // Шипы на спине
+    canvas.set(r, 14, 16, dragonHorn);
+    canvas.set(r, 16, 17, dragonHorn);
+    canvas.set(r, 18, 16, dragonHorn);
+}
+
+// ---------------- Глифы эффектов (белые, окрашиваются цветом команды) ----------------
+// === Череп (убийство) ===
+static constexpr void paint_kill_glyph(AtlasCanvas& canvas, TextureRect r) {
+    constexpr std::uint32_t white = rgba(255, 255, 255);
+
+    // Черепная коробка
+    for (int y = 1; y < 12; ++y) {
+        for (int x = 2; x < 14; ++x) {
+            int dx = 2 * x - 15;
+            int dy = 2 * y - 13;
+            if (dx*dx + dy*dy < 144) canvas.set(r, x, y, white);
+        }
+    }
+    // Челюсть с зубами
+    for (int y = 11; y < 15; ++y)
+        for (int x = 5; x < 11; ++x)
+            if (y < 13 || x % 2 == 1) canvas.set(r, x, y, white);
+
+    // Глазницы и нос — прозрачные
+    for (int y = 5; y < 8; ++y) {
+        for (int x = 4; x < 7; ++x) canvas.set(r, x, y, 0);
+        for (int x = 9; x < 12; ++x) canvas.set(r, x, y, 0);
+    }
+    canvas.set(r, 7, 9, 0);
+    canvas.set(r, 8, 9, 0);
+}
+
+// === Вспышка (ранение) ===
+static constexpr void paint_hurt_glyph(AtlasCanvas& canvas, TextureRect r) {
+    constexpr std::uint32_t white = rgba(255, 255, 255);
+
+    // Восемь лучей из центра
+    for (int i = -7; i <= 7; ++i) {
+        canvas.set(r, 8 + i, 8, white);
+        canvas.set(r, 8, 8 + i, white);
+        if (i > -6 && i < 6) {
+            canvas.set(r, 8 + i, 8 + i, white);
+            canvas.set(r, 8 + i, 8 - i, white);
+        }
+    }
+    // Ядро
+    for (int y = 5; y < 12; ++y)
+        for (int x = 5; x < 12; ++x)
+            if ((x - 8) * (x - 8) + (y - 8) * (y - 8) <= 5) canvas.set(r, x, y, white);
+}
+
+// === Двойной шеврон (уклонение) ===
+static constexpr void paint_escape_glyph(AtlasCanvas& canvas, TextureRect r) {
+    constexpr std::uint32_t white = rgba(255, 255, 255);
+
+    for (int offset = 0; offset <= 6; offset += 6) {
+        for (int i = 0; i < 7; ++i) {
+            for (int t = 0; t < 2; ++t) {
+                canvas.set(r, 2 + offset + i + t, 1 + i, white);   // верхняя половина
+                canvas.set(r, 2 + offset + i + t, 14 - i, white);  // нижняя половина
+            }
+        }
+    }
+}
+
+// === Крест (лечение) ===
+static constexpr void paint_heal_glyph(AtlasCanvas& canvas, TextureRect r) {
+    constexpr std::uint32_t white = rgba(255, 255, 255);
+
+    for (int i = 1; i < 15; ++i) {
+        for (int t = 6; t < 10; ++t) {
+            canvas.set(r, t, i, white);
+            canvas.set(r, i, t, white);
+        }
+    }
+}
+
+// ---------------- Шрифт ----------------
+static constexpr void paint_font(AtlasCanvas& canvas) {
+    for (int code = FONT_FIRST; code <= FONT_LAST; ++code) {
+        const TextureRect r = font_glyph(static_cast<char>(code));
+        const std::uint8_t* columns = FONT_5X7[code - FONT_FIRST];
+        for (int x = 0; x < FONT_GLYPH_W; ++x)
+            for (int y = 0; y < FONT_GLYPH_H; ++y)
+                if (columns[x] & (1u << y)) canvas.set(r, x, y, rgba(255, 255, 255));
+    }
+}
+
+static constexpr AtlasCanvas build_atlas() {
+    AtlasCanvas canvas;
+
+    paint_bear(canvas, atlas_sprite(NPCType::Bear));
+    paint_dragon(canvas, atlas_sprite(NPCType::Dragon));
+    paint_druid(canvas, atlas_sprite(NPCType::Druid));
+    paint_orc(canvas, atlas_sprite(NPCType::Orc));
+    paint_squirrel(canvas, atlas_sprite(NPCType::Squirrel));
+
+    paint_kill_glyph(canvas, atlas_glyph(EffectType::Kill));
+    paint_hurt_glyph(canvas, atlas_glyph(EffectType::Hurt));
+    paint_escape_glyph(canvas, atlas_glyph(EffectType::Escape));
+    paint_heal_glyph(canvas, atlas_glyph(EffectType::Heal));
+
+    paint_font(canvas);
+
+    for (int y = 0; y < ATLAS_WHITE.h; ++y)
+        for (int x = 0; x < ATLAS_WHITE.w; ++x)
+            canvas.set(ATLAS_WHITE, x, y, rgba(255, 255, 255));
+
+    return canvas;
+}
+
+static constexpr std::array<std::uint8_t, ATLAS_WIDTH * ATLAS_HEIGHT * 4> to_rgba8(const AtlasCanvas& canvas) {
+    std::array<std::uint8_t, ATLAS_WIDTH * ATLAS_HEIGHT * 4> bytes{};
+    for (std::size_t i = 0; i < canvas.px.size(); ++i) {
+        bytes[i * 4 + 0] = static_cast<std::uint8_t>(canvas.px[i] >> 24);
+        bytes[i * 4 + 1] = static_cast<std::uint8_t>(canvas.px[i] >> 16);
+        bytes[i * 4 + 2] = static_cast<std::uint8_t>(canvas.px[i] >> 8);
+        bytes[i * 4 + 3] = static_cast<std::uint8_t>(canvas.px[i]);
+    }
+    return bytes;
+}
+
+// Вычисляется компилятором; в рантайме — только данные в .rodata
+static constexpr AtlasCanvas ATLAS = build_atlas();
+static constexpr auto ATLAS_RGBA8 = to_rgba8(ATLAS);
+
+const std::uint32_t* atlas_pixels() {
+    return ATLAS.px.data();
+}
+
+const std::uint8_t* atlas_rgba8() {
+    return ATLAS_RGBA8.data();
+}
+
+PixelImage make_atlas_image() {
+    PixelImage img;
+    img.width = ATLAS_WIDTH;
+    img.height = ATLAS_HEIGHT;
+    img.pixels.assign(ATLAS.px.begin(), ATLAS.px.end());
+    return img;
+}
@@ -0,0 +1,31 @@
+#include "../include/sprites.h"
+
+PixelImage::PixelImage(int w, int h, std::uint32_t fill)
+    : width(w), height(h), pixels(static_cast<std::size_t>(w) * h, fill)
+{
+}
+
+void PixelImage::toRGBA8(std::vector<std::uint8_t>& out) const {
+    out.resize(pixels.size() * 4);
+    for (std::size_t i = 0; i < pixels.size(); ++i) {
+        std::uint32_t p = pixels[i];
+        out[i * 4 + 0] = static_cast<std::uint8_t>(p >> 24);
+        out[i * 4 + 1] = static_cast<std::uint8_t>(p >> 16);
+        out[i * 4 + 2] = static_cast<std::uint8_t>(p >> 8);
+        out[i * 4 + 3] = static_cast<std::uint8_t>(p);
+    }
+}
+
+void PixelImage::toRGBA8(std::vector<std::uint8_t>& out, int x, int y, int w, int h) const {
+    out.resize(static_cast<std::size_t>(w) * h * 4);
+    std::size_t o = 0;
+    for (int row = y; row < y + h; ++row) {
+        for (int col = x; col < x + w; ++col) {
+            std::uint32_t p = get(col, row);
+            out[o++] = static_cast<std::uint8_t>(p >> 24);
+            out[o++] = static_cast<std::uint8_t>(p >> 16);
+            out[o++] = static_cast<std::uint8_t>(p >> 8);
+            out[o++] = static_cast<std::uint8_t>(p);
+        }
+    }
+}
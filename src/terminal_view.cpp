@@ -0,0 +1,207 @@
+#include "../include/terminal_view.h"
+#include "../include/trace.h"
+#include "../include/game_utils.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+// Цвета клеток: индекс 0 — цвет терминала по умолчанию.
+// Каждый код начинается со сброса (0;), поэтому смена цвета не тянет
+// за собой жирность предыдущего.
+static constexpr const char* PALETTE[] = {
+    "0",     // по умолчанию
+    "0;35",  // Unknown
+    "0;33",  // Bear
+    "1;33",  // Dragon
+    "0;36",  // Druid
+    "0;31",  // Orc
+    "0;32",  // Squirrel
+    "0;90",  // труп
+    "0;1",   // строка состояния
+};
+static constexpr std::uint8_t COLOR_DEAD = 7;
+static constexpr std::uint8_t COLOR_STATUS = 8;
+
+static std::uint8_t color_index(NPCType type, bool alive) {
+    if (!alive) return COLOR_DEAD;
+    int t = static_cast<int>(type);
+    return static_cast<std::uint8_t>(t >= 1 && t <= 5 ? t + 1 : 1);
+}
+
+const char* ansi_sgr(NPCType type, bool alive) {
+    return PALETTE[color_index(type, alive)];
+}
+
+char npc_glyph(NPCType type, bool alive) {
+    if (!alive) return '*';
+    switch (type) {
+        case NPCType::Bear:     return 'B';
+        case NPCType::Dragon:   return 'D';
+        case NPCType::Druid:    return 'd';
+        case NPCType::Orc:      return 'O';
+        case NPCType::Squirrel: return 'S';
+        default:                return '?';
+    }
+}
+
+TerminalView::TerminalView(TerminalViewConfig config, float world_w, float world_h)
+    : cfg(config)
+{
+    cfg.cols = std::max(cfg.cols, 20);
+    cfg.rows = std::max(cfg.rows, 2);
+    map_rows = cfg.rows - 1;
+    cell_w = cfg.cell > 0 ? cfg.cell : (world_w - cfg.origin_x) / cfg.cols;
+    cell_h = cell_w * 2;
+    // Вся карта должна влезть по высоте, если масштаб не задан явно
+    if (cfg.cell <= 0 && cell_h * map_rows < world_h - cfg.origin_y) {
+        cell_h = (world_h - cfg.origin_y) / map_rows;
+        cell_w = cell_h / 2;
+    }
+
+    front.assign(static_cast<std::size_t>(cfg.cols) * cfg.rows, Cell{});
+    back = front;
+}
+
+void TerminalView::putText(int row, int col, std::string_view text, std::uint8_t color) {
+    for (std::size_t i = 0; i < text.size() && col + static_cast<int>(i) < cfg.cols; ++i)
+        back[row * cfg.cols + col + i] = Cell{text[i], color};
+}
+
+void TerminalView::compose(const FrameSnapshot& snap) {
+    std::fill(back.begin(), back.end(), Cell{});
+
+    // Строка 0 — состояние; статус обновляется раз в секунду, чтобы
+    // счётчики не перерисовывались каждый кадр
+    if (frames % static_cast<std::uint64_t>(std::max(1.0, cfg.hz)) == 0 || status.empty()) {
+        char line[128];
+        std::snprintf(line, sizeof(line), " tick %llu | alive %d | dead %d | %.1f KB/s",
+                      static_cast<unsigned long long>(snap.tick), snap.alive_count, snap.dead_count,
+                      frames ? static_cast<double>(bytes) / frames * cfg.hz / 1024.0 : 0.0);
+        status = line;
+    }
+    putText(0, 0, status, COLOR_STATUS);
+
+    // Трупы рисуются первыми: живой NPC в той же клетке их перекрывает
+    for (int pass = 0; pass < 2; ++pass) {
+        const bool alive_pass = pass == 1;
+        for (const NPCRenderState& npc : snap.npcs) {
+            if (npc.alive != alive_pass || npc.type == NPCType::Unknown) continue;
+            int col = static_cast<int>((npc.x - cfg.origin_x) / cell_w);
+            int row = static_cast<int>((npc.y - cfg.origin_y) / cell_h);
+            if (col < 0 || row < 0 || col >= cfg.cols || row >= map_rows) continue;
+            back[(row + 1) * cfg.cols + col] = Cell{npc_glyph(npc.type, npc.alive), color_index(npc.type, npc.alive)};
+        }
+    }
+}
+
+static void append_int(std::string& out, int value) {
+    char digits[12];
+    auto res = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, res.ptr);
+}
+
+void TerminalView::moveTo(int row, int col) {
+    buf += "\033[";
+    append_int(buf, row + 1);
+    buf += ';';
+    append_int(buf, col + 1);
+    buf += 'H';
+    cur_row = row;
+    cur_col = col;
+}
+
+void TerminalView::setColor(std::uint8_t color) {
+    buf += "\033[";
+    buf += PALETTE[color];
+    buf += 'm';
+    cur_color = color;
+}
+
+void TerminalView::diff() {
+    for (int row = 0; row < cfg.rows; ++row) {
+        for (int col = 0; col < cfg.cols; ++col) {
+            const std::size_t i = static_cast<std::size_t>(row) * cfg.cols + col;
+            if (!full_redraw && back[i] == front[i]) continue;
+
+            if (row != cur_row || col != cur_col) {
+                // Короткий пропуск дешевле перепечатать, чем ставить курсор (ESC[r;cH — 6+ байт)
+                const int gap = col - cur_col;
+                bool reprint = row == cur_row && cur_col >= 0 && gap > 0 && gap <= 4;
+                for (int k = 0; reprint && k < gap; ++k)
+                    reprint = front[i - gap + k].color == cur_color;
+                if (reprint) {
+                    for (int k = 0; k < gap; ++k) buf += front[i - gap + k].ch;
+                    cur_col = col;
+                } else {
+                    moveTo(row, col);
+                }
+            }
+            if (back[i].color != cur_color) setColor(back[i].color);
+            buf += back[i].ch;
+            front[i] = back[i];
+            // После последнего столбца положение курсора зависит от терминала
+            cur_col = col + 1 < cfg.cols ? col + 1 : -1;
+        }
+    }
+
+    if (!buf.empty()) {
+        if (cur_color != 0) setColor(0);
+        moveTo(cfg.rows, 0);  // курсор под картой: случайный вывод не портит её
+    }
+    full_redraw = false;
+}
+
+std::size_t TerminalView::present(const FrameSnapshot& snap, std::FILE* out) {
+    auto start = std::chrono::steady_clock::now();
+    buf.clear();
+    if (full_redraw) buf += "\033[2J";
+    compose(snap);
+    diff();
+    compose_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    if (!buf.empty()) {
+        // Одна запись за кадр; print_mutex не даёт логам вклиниться в середину
+        std::lock_guard<ProfiledMutex> lck(print_mutex);
+        std::fwrite(buf.data(), 1, buf.size(), out);
+        std::fflush(out);
+    }
+    frames++;
+    bytes += buf.size();
+    return buf.size();
+}
+
+void TerminalView::run(SnapshotPublisher& snapshots, const std::atomic<bool>& running, std::FILE* out) {
+    using clock = std::chrono::steady_clock;
+    const auto interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / cfg.hz));
+    // Раз в 5 секунд — полная перерисовка: лечит экран после чужого вывода
+    const std::uint64_t refresh_every = static_cast<std::uint64_t>(cfg.hz * 5) + 1;
+
+    std::fputs("\033[?25l", out);  // спрятать курсор
+    invalidate();
+    auto next = clock::now();
+    while (running) {
+        if (frames % refresh_every == 0) invalidate();
+        {
+            TraceZone zone("TerminalView frame");
+            present(snapshots.acquire(), out);
+        }
+        // Отставший кадр не догоняем серией без пауз
+        next = std::max(next + interval, clock::now());
+        std::this_thread::sleep_until(next);
+    }
+    std::fputs("\033[0m\033[?25h\n", out);
+    std::fflush(out);
+}
+
+void TerminalView::printSummary() const {
+    if (frames == 0) return;
+    const double n = static_cast<double>(frames);
+    std::cout << "\n=== Terminal view ===\n"
+              << frames << " frames " << cfg.cols << "x" << cfg.rows << " at " << cfg.hz << " Hz\n"
+              << std::fixed << std::setprecision(1)
+              << "per frame: " << bytes / n << " bytes | compose+diff " << compose_us / n << " us\n";
+}
@@ -0,0 +1,67 @@
+#include "../include/tick_arena.h"
+#include <algorithm>
+#include <new>
+
+TickArena::TickArena(std::size_t initial_bytes)
+    : buffer(std::make_unique<std::byte[]>(initial_bytes)), buffer_size(initial_bytes), initial_size(initial_bytes)
+{
+    cursor = buffer.get();
+    limit = cursor + buffer_size;
+    heap_allocs = 1;
+}
+
+void* TickArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    auto align_up = [alignment](std::byte* p) {
+        const auto addr = reinterpret_cast<std::uintptr_t>(p);
+        return reinterpret_cast<std::byte*>((addr + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1));
+    };
+
+    std::byte* p = align_up(cursor);
+    if (p + bytes > limit) {
+        // Переполнение: новый блок из кучи, не меньше основного буфера
+        const std::size_t block = std::max(bytes + alignment, buffer_size);
+        overflow.push_back(std::make_unique<std::byte[]>(block));
+        heap_allocs++;
+        cursor = overflow.back().get();
+        limit = cursor + block;
+        p = align_up(cursor);
+    }
+
+    cursor = p + bytes;
+    used_bytes += bytes;
+    peak_bytes = std::max(peak_bytes, used_bytes);
+    return p;
+}
+
+void TickArena::replaceBuffer(std::size_t bytes) {
+    buffer.reset();  // старый буфер отдаётся до выделения нового
+    buffer = std::make_unique<std::byte[]>(bytes);
+    buffer_size = bytes;
+    heap_allocs++;
+}
+
+void TickArena::reset() {
+    reset_count++;
+    if (!overflow.empty()) {
+        // Следующий тик такого же размера должен уместиться целиком, с запасом.
+        // Сам всплеск в пик окна не идёт: если он не повторится, буфер ужмётся
+        overflow.clear();
+        replaceBuffer(used_bytes + used_bytes / 2);
+        last_growth = reset_count;
+    } else {
+        window_peak = std::max(window_peak, used_bytes);
+    }
+
+    if (reset_count % SHRINK_WINDOW == 0) {
+        // Всплеск прошёл: буфер, занятый за окно меньше чем на четверть, ужимается
+        const std::size_t target = std::max(initial_size, window_peak + window_peak / 2);
+        if (reset_count != last_growth && window_peak < buffer_size / 4 && target < buffer_size) {
+            replaceBuffer(target);
+            last_shrink = reset_count;
+        }
+        window_peak = 0;
+    }
+    cursor = buffer.get();
+    limit = cursor + buffer_size;
+    used_bytes = 0;
+}
@@ -0,0 +1,502 @@
+#include "../include/tick_scheduler.h"
+#include "../include/game_utils.h"
+#include "../include/memory_tracker.h"
+#include "../include/metrics.h"
+#include "../include/trace.h"
+#include "../include/state_hash.h"
+#include "../include/trajectory.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+const char* tick_phase_name(TickPhase phase) {
+    switch (phase) {
+        case TickPhase::Compact: return "compact";
+        case TickPhase::Move:    return "move";
+        case TickPhase::Index:   return "index";
+        case TickPhase::Detect:  return "detect";
+        case TickPhase::Resolve: return "resolve";
+        case TickPhase::Notify:  return "notify";
+        case TickPhase::Publish: return "publish";
+        case TickPhase::Count:   break;
+    }
+    return "?";
+}
+
+// Метрики конвейера; регистрируются при первом тике
+namespace {
+struct TickMetrics {
+    Histogram& tick;
+    std::array<Histogram*, TICK_PHASE_COUNT> phase;
+    Counter& ticks;
+    Counter& candidates;
+    Counter& removed;
+    Counter& spawned;
+    Gauge& live;
+};
+
+TickMetrics& tick_metrics() {
+    static TickMetrics m = [] {
+        MetricsRegistry& r = MetricsRegistry::instance();
+        TickMetrics built{
+            r.histogram("pixelrpg_tick_seconds", "Duration of a whole simulation tick.", 1e-9),
+            {},
+            r.counter("pixelrpg_ticks_total", "Simulation ticks completed."),
+            r.counter("pixelrpg_candidate_pairs_total", "NPC pairs found within interaction distance."),
+            r.counter("pixelrpg_npcs_removed_total", "Dead NPCs compacted out of the world."),
+            r.counter("pixelrpg_npcs_spawned_total", "NPCs taken into the simulation, initial population included."),
+            r.gauge("pixelrpg_npcs_live", "NPCs in the live list after the last tick.")};
+        for (std::size_t p = 0; p < TICK_PHASE_COUNT; ++p)
+            built.phase[p] = &r.histogram("pixelrpg_tick_phase_seconds", "Duration of one tick pipeline phase.", 1e-9,
+                                          std::string("phase=\"") + tick_phase_name(static_cast<TickPhase>(p)) + "\"");
+        return built;
+    }();
+    return m;
+}
+} // namespace
+
+TickScheduler::TickScheduler(NPCStore& world_, JobSystem& jobs_, int map_w_, int map_h_, int cell_size)
+    : TickScheduler(world_, jobs_, map_w_, map_h_, cell_size, InteractionManager::instance()) {}
+
+TickScheduler::TickScheduler(NPCStore& world_, JobSystem& jobs_, int map_w_, int map_h_, int cell_size,
+                             InteractionManager& interactions_)
+    : world(world_), npcs(world_.list()), jobs(jobs_), interactions(interactions_), map_w(map_w_), map_h(map_h_),
+      cell(std::max(1, cell_size)), cells_x(map_w_ / cell + 1), cells_y(map_h_ / cell + 1)
+{
+    col_of_x.resize(static_cast<std::size_t>(map_w) + 1);
+    row_of_y.resize(static_cast<std::size_t>(map_h) + 1);
+    interactions.setArena(&arena);
+
+    for (int x = 0; x <= map_w; ++x)
+        col_of_x[x] = static_cast<std::uint32_t>(std::min(x / cell, cells_x - 1));
+    for (int y = 0; y <= map_h; ++y)
+        row_of_y[y] = static_cast<std::uint32_t>(std::min(y / cell, cells_y - 1) * cells_x);
+}
+
+TickScheduler::~TickScheduler() {
+    interactions.setArena(nullptr);
+}
+
+void TickScheduler::tick() {
+    using clock = std::chrono::steady_clock;
+    last_stats = TickStats{};
+
+    TraceZone tick_zone("tick");
+    TickMetrics& metrics = tick_metrics();
+    const std::uint64_t allocs_before = memory_total_allocations();
+    const auto start = clock::now();
+    auto mark = start;
+    auto phase = [&](TickPhase p, MemSubsystem subsystem, void (TickScheduler::*fn)()) {
+        {
+            MemoryScope scope(subsystem);
+            TraceZone zone(tick_phase_name(p));
+            (this->*fn)();
+        }
+        auto now = clock::now();
+        metrics.phase[static_cast<std::size_t>(p)]->record(
+            static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - mark).count()));
+        double us = std::chrono::duration<double, std::micro>(now - mark).count();
+        last_stats.phase_us[static_cast<std::size_t>(p)] = us;
+        total_us[static_cast<std::size_t>(p)] += us;
+        mark = now;
+    };
+
+    phase(TickPhase::Compact, MemSubsystem::World, &TickScheduler::compactPhase);
+    phase(TickPhase::Move, MemSubsystem::World, &TickScheduler::movePhase);
+    phase(TickPhase::Index, MemSubsystem::Grid, &TickScheduler::indexPhase);
+    phase(TickPhase::Detect, MemSubsystem::Grid, &TickScheduler::detectPhase);
+    phase(TickPhase::Resolve, MemSubsystem::Interactions, &TickScheduler::resolvePhase);
+    phase(TickPhase::Notify, MemSubsystem::Observers, &TickScheduler::notifyPhase);
+    phase(TickPhase::Publish, MemSubsystem::Snapshots, &TickScheduler::publishPhase);
+
+    if (hashing) last_stats.world_hash = hashWorld();
+    if (recorder) recordFrame();
+    endTick();
+
+    // Считаются выделения всех потоков, включая рендер, если он работает
+    last_stats.allocations = memory_total_allocations() - allocs_before;
+    total_allocations += last_stats.allocations;
+    max_allocations = std::max(max_allocations, last_stats.allocations);
+
+    total_candidates += last_stats.candidates;
+    total_removed += last_stats.removed;
+    total_spawned += last_stats.spawned;
+    tick_count++;
+
+    metrics.tick.record(
+        static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count()));
+    metrics.ticks.add();
+    metrics.candidates.add(last_stats.candidates);
+    metrics.removed.add(last_stats.removed);
+    metrics.spawned.add(last_stats.spawned);
+    metrics.live.set(static_cast<std::int64_t>(npcs.size()));
+}
+
+template <typename Fn>
+void TickScheduler::forChunks(std::size_t count, std::size_t grain, Fn&& fn) {
+    if (npcs.size() >= PARALLEL_MIN_NPCS) {
+        jobs.parallelFor(count, grain, fn);
+        return;
+    }
+    for (std::size_t begin = 0; begin < count; begin += grain)
+        fn(begin, std::min(count, begin + grain));
+}
+
+void TickScheduler::gatherState(std::size_t from) {
+    const std::size_t n = npcs.size();
+    pos_x.resize(n);
+    pos_y.resize(n);
+    reach.resize(n);
+    health.resize(n);
+    handles.resize(n);
+    kind.resize(n);
+    alive.resize(n);
+    cell_of.resize(n);
+
+    for (std::size_t i = from; i < n; ++i) {
+        const NPC& npc = *npcs[i];
+        int x = 0, y = 0;
+        alive[i] = world.getState(npc, x, y) ? 1 : 0;
+        pos_x[i] = x;
+        pos_y[i] = y;
+        reach[i] = npc.get_interaction_distance();
+        health[i] = world.health(npc);
+        handles[i] = npc.handle();
+        kind[i] = static_cast<std::uint8_t>(npc.type);
+        move_distance[kind[i]] = npc.get_move_distance();
+        cell_of[i] = row_of_y[std::clamp(y, 0, map_h)] + col_of_x[std::clamp(x, 0, map_w)];
+    }
+}
+
+void TickScheduler::refreshVitals() {
+    // Здоровье в тике меняется только у участников найденных пар
+    for (const auto& pairs : chunk_pairs) {
+        for (const auto& [a, b] : pairs) {
+            for (const std::uint32_t i : {a, b}) {
+                health[i] = world.health(*npcs[i]);
+                alive[i] = world.isAlive(*npcs[i]) ? 1 : 0;
+            }
+        }
+    }
+}
+
+// Полный проход по упакованному состоянию (см. setHashing)
+std::uint64_t TickScheduler::hashWorld() {
+    const std::size_t n = npcs.size();
+    const std::size_t chunks = (n + HASH_GRAIN - 1) / HASH_GRAIN;
+    chunk_hashes.assign(chunks, 0);
+    forChunks(n, HASH_GRAIN, [&](std::size_t begin, std::size_t end) {
+        state_hash::Hasher h(begin);
+        for (std::size_t i = begin; i < end; ++i) {
+            h.add(static_cast<std::uint32_t>(pos_x[i]) | std::uint64_t{static_cast<std::uint32_t>(pos_y[i])} << 32);
+            h.add(handles[i].bits | std::uint64_t{static_cast<std::uint32_t>(health[i])} << 32);
+            h.add(kind[i] | std::uint64_t{alive[i]} << 8);
+        }
+        chunk_hashes[begin / HASH_GRAIN] = h.digest();
+    });
+
+    state_hash::Hasher world_hash(n);
+    for (std::uint64_t chunk : chunk_hashes) world_hash.add(chunk);
+    return world_hash.digest();
+}
+
+void TickScheduler::recordFrame() {
+    TrajectoryFrame frame;
+    frame.tick = worldTick() + 1;
+    frame.removed = world.removed();
+    frame.count = npcs.size();
+    frame.handles = handles.data();
+    frame.x = pos_x.data();
+    frame.y = pos_y.data();
+    frame.health = health.data();
+    frame.alive = alive.data();
+    frame.npcs = &npcs;
+    recorder->record(frame);
+}
+
+void TickScheduler::continueFrom(const TickScheduler& trunk) {
+    rng_seed = trunk.rng_seed;
+    tick_base = trunk.worldTick();
+}
+
+void TickScheduler::compactPhase() {
+    // Новые NPC добавляются в конец списка (NPCStore::spawn) между тиками
+    if (pos_x.size() > npcs.size()) pos_x.clear();  // список заменили целиком
+    const std::size_t known = pos_x.size();
+    if (known < npcs.size()) {
+        gatherState(known);
+        last_stats.spawned = npcs.size() - known;
+    }
+
+    // Погибшие в прошлых тиках уже показаны в снимке и разосланы наблюдателям:
+    // swap-remove из списка и то же перемещение в упакованных массивах
+    std::size_t i = 0;
+    while (i < alive.size()) {
+        if (alive[i]) {
+            ++i;
+            continue;
+        }
+        const std::size_t last = alive.size() - 1;
+        world.remove(i);
+        pos_x[i] = pos_x[last];
+        pos_y[i] = pos_y[last];
+        reach[i] = reach[last];
+        health[i] = health[last];
+        handles[i] = handles[last];
+        kind[i] = kind[last];
+        alive[i] = alive[last];
+        cell_of[i] = cell_of[last];
+        pos_x.pop_back();
+        pos_y.pop_back();
+        reach.pop_back();
+        health.pop_back();
+        handles.pop_back();
+        kind.pop_back();
+        alive.pop_back();
+        cell_of.pop_back();
+        last_stats.removed++;
+    }
+
+    // Ветвившийся мир делит куски состояния с другими мирами (NPCStore):
+    // движение пишет в каждого живого, поэтому куски с живыми копируются до него
+    if (world.sharesState()) {
+        forChunks(world.chunkCount(), COPY_GRAIN, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t c = begin; c < end; ++c) world.copyChunk(c);
+        });
+        world.refreshSharing();
+    }
+}
+
+void TickScheduler::movePhase() {
+    const std::uint64_t tick_seed = rng_seed ^ (worldTick() * 0xD1B54A32D192ED03ull);
+    const auto now = std::chrono::steady_clock::now();
+
+    forChunks(npcs.size(), MOVE_GRAIN, [&](std::size_t begin, std::size_t end) {
+        // Восемь потоков xorshift32 на кусок: один шаг ядра обрабатывает восемь NPC
+        // без зависимостей между ними, и компилятор раскладывает его по векторным регистрам
+        std::uint64_t seed = tick_seed ^ (begin / MOVE_GRAIN);
+        std::uint32_t lanes[MOVE_LANES];
+        for (auto& lane : lanes) lane = static_cast<std::uint32_t>(splitmix64(seed)) | 1u;
+
+        std::int32_t* px = pos_x.data();
+        std::int32_t* py = pos_y.data();
+        std::uint32_t* cells = cell_of.data();
+        const std::uint8_t* live = alive.data();
+        const std::uint8_t* types = kind.data();
+        const std::uint32_t* cols = col_of_x.data();
+        const std::uint32_t* rows = row_of_y.data();
+
+        // Шаг по блоку из count <= MOVE_LANES NPC начиная с base. Выборки из таблиц
+        // (дистанция по типу, клетка по координате) вынесены из арифметики, а условия
+        // записаны без ветвлений, чтобы цикл по дорожкам раскладывался в SIMD.
+        auto block = [&](std::size_t base, std::size_t count) {
+            std::int32_t dist[MOVE_LANES] = {};
+            std::int32_t can[MOVE_LANES] = {};
+            for (std::size_t l = 0; l < count; ++l) {
+                dist[l] = move_distance[types[base + l]];
+                can[l] = live[base + l];
+            }
+
+            std::int32_t x[MOVE_LANES] = {}, y[MOVE_LANES] = {};
+            for (std::size_t l = 0; l < count; ++l) {
+                x[l] = px[base + l];
+                y[l] = py[base + l];
+            }
+
+            for (std::size_t l = 0; l < MOVE_LANES; ++l) {
+                std::uint32_t r = lanes[l];
+                r ^= r << 13;
+                r ^= r >> 17;
+                r ^= r << 5;
+                lanes[l] = r;
+
+                // Сдвиг в [-d, d] умножением вместо деления по модулю
+                const std::int32_t d = dist[l];
+                const std::uint32_t span = static_cast<std::uint32_t>(2 * d + 1);
+                const std::int32_t nx = x[l] + static_cast<std::int32_t>(((r & 0xFFFFu) * span) >> 16) - d;
+                const std::int32_t ny = y[l] + static_cast<std::int32_t>(((r >> 16) * span) >> 16) - d;
+
+                // Как NPC::move: ось, выходящая за карту, не сдвигается; мёртвые стоят
+                const bool ok_x = (can[l] != 0) & (nx >= 0) & (nx <= map_w);
+                const bool ok_y = (can[l] != 0) & (ny >= 0) & (ny <= map_h);
+                x[l] = ok_x ? nx : x[l];
+                y[l] = ok_y ? ny : y[l];
+            }
+
+            for (std::size_t l = 0; l < count; ++l) {
+                px[base + l] = x[l];
+                py[base + l] = y[l];
+                cells[base + l] = rows[std::min(std::max(y[l], 0), map_h)] + cols[std::min(std::max(x[l], 0), map_w)];
+            }
+        };
+
+        std::size_t i = begin;
+        for (; i + MOVE_LANES <= end; i += MOVE_LANES) block(i, MOVE_LANES);
+        if (i < end) block(i, end - i);
+
+        // Запись в мир тем же проходом, пока кусок в кэше
+        for (std::size_t k = begin; k < end; ++k)
+            if (live[k]) world.moveTo(*npcs[k], px[k], py[k], now);
+    });
+}
+
+void TickScheduler::indexPhase() {
+    const std::size_t n = npcs.size();
+
+    // Counting sort живых NPC по клеткам
+    const std::size_t cells = static_cast<std::size_t>(cells_x) * cells_y;
+    cell_start.assign(cells + 1, 0);
+    for (std::size_t i = 0; i < n; ++i)
+        if (alive[i]) cell_start[cell_of[i] + 1]++;
+    for (std::size_t c = 0; c < cells; ++c) cell_start[c + 1] += cell_start[c];
+
+    cell_items.resize(cell_start[cells]);
+    cell_fill.assign(cell_start.begin(), cell_start.end() - 1);
+    for (std::size_t i = 0; i < n; ++i)
+        if (alive[i]) cell_items[cell_fill[cell_of[i]]++] = static_cast<std::uint32_t>(i);
+}
+
+void TickScheduler::detectPhase() {
+    const std::size_t cells = static_cast<std::size_t>(cells_x) * cells_y;
+    const std::size_t chunks = (cells + DETECT_GRAIN - 1) / DETECT_GRAIN;
+    chunk_pairs.resize(chunks);
+    chunk_pair_peak.resize(chunks);
+
+    auto close = [&](std::uint32_t a, std::uint32_t b) {
+        const int dist = std::max(reach[a], reach[b]);
+        const int dx = pos_x[a] - pos_x[b];
+        const int dy = pos_y[a] - pos_y[b];
+        return dx * dx + dy * dy <= dist * dist;
+    };
+
+    forChunks(cells, DETECT_GRAIN, [&](std::size_t begin, std::size_t end) {
+        auto& out = chunk_pairs[begin / DETECT_GRAIN];
+        out.clear();
+        // Соседи: половина окрестности, чтобы каждая пара клеток проверялась один раз
+        static constexpr int NEIGHBORS[4][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}};
+
+        for (std::size_t c = begin; c < end; ++c) {
+            const int cx = static_cast<int>(c) % cells_x;
+            const int cy = static_cast<int>(c) / cells_x;
+            const std::uint32_t* first = cell_items.data() + cell_start[c];
+            const std::uint32_t* last = cell_items.data() + cell_start[c + 1];
+
+            // Внутри клетки
+            for (const std::uint32_t* i = first; i != last; ++i)
+                for (const std::uint32_t* j = i + 1; j != last; ++j)
+                    if (close(*i, *j)) out.emplace_back(*i, *j);
+
+            // Соседние клетки
+            for (const auto& offset : NEIGHBORS) {
+                const int nx = cx + offset[0];
+                const int ny = cy + offset[1];
+                if (nx < 0 || nx >= cells_x || ny >= cells_y) continue;
+                const std::size_t nc = static_cast<std::size_t>(ny * cells_x + nx);
+                for (const std::uint32_t* i = first; i != last; ++i)
+                    for (std::uint32_t k = cell_start[nc]; k < cell_start[nc + 1]; ++k)
+                        if (close(*i, cell_items[k])) out.emplace_back(*i, cell_items[k]);
+            }
+        }
+        auto& peak = chunk_pair_peak[begin / DETECT_GRAIN];
+        peak = std::max(peak, static_cast<std::uint32_t>(out.size()));
+    });
+
+    // Очереди менеджера в арене размечаются сразу под все пары: растущий
+    // вектор оставлял бы в арене брошенные буферы до конца тика
+    std::size_t total = 0;
+    for (const auto& pairs : chunk_pairs) total += pairs.size();
+    interactions.reserve(total);
+
+    // Слияние в порядке кусков — очередь одинакова при любом числе потоков
+    for (std::size_t k = 0; k < chunks; ++k) {
+        for (const auto& [a, b] : chunk_pairs[k])
+            interactions.push({handles[a], handles[b]});
+        last_stats.candidates += chunk_pairs[k].size();
+    }
+}
+
+void TickScheduler::resolvePhase() {
+    if (interactions.combatMode() == CombatMode::Sequential) {
+        // Бой меняет здоровье обоих участников, поэтому пары разбираются по порядку
+        interactions.resolvePending();
+    } else {
+        // Двухфазный бой: расчёт от состояния на начало тика по кускам, затем фиксация
+        std::uint64_t seed_state = rng_seed + worldTick();
+        const std::size_t n = interactions.beginCompute(world.capacity(), splitmix64(seed_state));
+        forChunks(n, RESOLVE_GRAIN, [&](std::size_t begin, std::size_t end) {
+            interactions.computeRange(begin, end);
+        });
+        interactions.commitComputed();
+    }
+    refreshVitals();
+}
+
+void TickScheduler::notifyPhase() {
+    last_stats.notified = interactions.notifyPending();
+}
+
+void TickScheduler::publishPhase() {
+    if (snapshots) snapshots->publish(npcs, true, world.removed());
+}
+
+void TickScheduler::endTick() {
+    // Рост и сжатие буфера арены — память очередей боёв и сетки, а не «other»
+    MemoryScope scope(MemSubsystem::Interactions);
+    last_stats.arena_bytes = arena.used();
+    release_tick_storage(cell_start);
+    release_tick_storage(cell_items);
+    release_tick_storage(cell_fill);
+    release_tick_storage(chunk_hashes);
+    interactions.releaseTickStorage();
+    arena.reset();
+    // Всплеск, ради которого выросла арена, в пик окна пар не идёт — как и у самой арены
+    if (arena.lastGrowth() == arena.resets()) std::fill(chunk_pair_peak.begin(), chunk_pair_peak.end(), 0);
+    if (arena.resets() % TickArena::SHRINK_WINDOW == 0) {
+        MemoryScope grid_scope(MemSubsystem::Grid);
+        const bool trimmed = trimChunkPairs();
+        last_stats.shrunk = trimmed || arena.lastShrink() == arena.resets();
+    }
+}
+
+bool TickScheduler::trimChunkPairs() {
+    using Pair = std::pair<std::uint32_t, std::uint32_t>;
+    static constexpr std::size_t MIN_TRIM_PAIRS = 512;  // мелкие векторы не трогаем
+    bool trimmed = false;
+    for (std::size_t k = 0; k < chunk_pairs.size(); ++k) {
+        auto& pairs = chunk_pairs[k];
+        const std::size_t peak = chunk_pair_peak[k];
+        if (pairs.capacity() > MIN_TRIM_PAIRS && peak < pairs.capacity() / 4) {
+            std::vector<Pair> shrunk;
+            shrunk.reserve(peak + peak / 2);
+            shrunk.assign(pairs.begin(), pairs.end());
+            pairs.swap(shrunk);
+            trimmed = true;
+        }
+        chunk_pair_peak[k] = 0;
+    }
+    return trimmed;
+}
+
+void TickScheduler::printSummary() const {
+    if (tick_count == 0) return;
+    const double n = static_cast<double>(tick_count);
+    std::cout << "\n=== Tick pipeline (" << tick_count << " ticks, " << jobs.threadCount() << " threads, "
+              << jobs.stolenJobs() << " stolen jobs, "
+              << combat_mode_name(interactions.combatMode()) << " combat) ===\n"
+              << std::fixed << std::setprecision(1);
+    for (std::size_t p = 0; p < TICK_PHASE_COUNT; ++p)
+        std::cout << tick_phase_name(static_cast<TickPhase>(p)) << ' ' << total_us[p] / n << " us"
+                  << (p + 1 < TICK_PHASE_COUNT ? " | " : "\n");
+    std::cout << "tick arena: peak " << arena.peak() / 1024.0 << " KiB of " << arena.capacity() / 1024
+              << " KiB, " << arena.heapAllocations() << " heap allocations (last growth at tick "
+              << arena.lastGrowth() << ", last shrink at tick " << arena.lastShrink() << ")\n";
+    if (memory_tracking_enabled())
+        std::cout << "heap allocations/tick: " << total_allocations / n << " avg, " << max_allocations << " max\n";
+    if (hashing) {
+        std::cout << "world hash: ";
+        state_hash::write_hex(std::cout, last_stats.world_hash) << "\n";
+    }
+    std::cout << "candidate pairs/tick: " << total_candidates / n << " | removed dead: " << total_removed
+              << " | spawned: " << total_spawned << " | live list: " << npcs.size() << "\n";
+}
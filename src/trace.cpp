@@ -0,0 +1,131 @@
+#include "../include/trace.h"
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    std::int64_t start_ns;
+    std::int64_t end_ns;
+};
+
+// Кольцо одного потока: пишет только владелец, читает trace_write()
+struct ThreadBuffer {
+    std::vector<TraceEvent> ring;
+    std::atomic<std::uint64_t> head{0};  // всего записано
+    std::string name;
+    std::uint32_t tid{0};
+};
+
+std::mutex registry_mtx;
+std::vector<std::unique_ptr<ThreadBuffer>> buffers;  // живут до конца программы, дольше своих потоков
+std::size_t capacity = 0;
+std::int64_t origin_ns = 0;
+
+thread_local ThreadBuffer* tls_buffer = nullptr;
+thread_local std::string tls_name;
+
+ThreadBuffer* thread_buffer() {
+    if (tls_buffer) return tls_buffer;
+    std::lock_guard<std::mutex> lock(registry_mtx);
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->ring.resize(capacity);
+    buffer->tid = static_cast<std::uint32_t>(buffers.size() + 1);
+    buffer->name = tls_name.empty() ? "thread " + std::to_string(buffer->tid) : tls_name;
+    tls_buffer = buffers.emplace_back(std::move(buffer)).get();
+    return tls_buffer;
+}
+
+void write_escaped(std::ostream& out, const std::string& text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\';
+        out << c;
+    }
+}
+
+} // namespace
+
+namespace trace_detail {
+
+std::atomic<bool> enabled{false};
+
+std::int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void record(const char* name, std::int64_t start_ns, std::int64_t end_ns) {
+    ThreadBuffer* buffer = thread_buffer();
+    const std::uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    buffer->ring[head & (buffer->ring.size() - 1)] = {name, start_ns, end_ns};
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+} // namespace trace_detail
+
+void trace_start(std::size_t events_per_thread) {
+    {
+        std::lock_guard<std::mutex> lock(registry_mtx);
+        capacity = std::bit_ceil(std::max<std::size_t>(events_per_thread, 2));
+        origin_ns = trace_detail::now_ns();
+    }
+    trace_detail::enabled.store(true, std::memory_order_release);
+}
+
+void trace_thread_name(const std::string& name) {
+    tls_name = name;
+    if (tls_buffer) {
+        std::lock_guard<std::mutex> lock(registry_mtx);
+        tls_buffer->name = name;
+    }
+}
+
+bool trace_write(const std::string& path) {
+    trace_detail::enabled.store(false, std::memory_order_release);
+
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.good()) {
+        std::cerr << "Cannot write trace to " << path << "\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mtx);
+    std::uint64_t written = 0, dropped = 0;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+        << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"PixelRPG\"}}";
+    out << std::fixed << std::setprecision(3);
+    for (const auto& buffer : buffers) {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":\"";
+        write_escaped(out, buffer->name);
+        out << "\"}}";
+
+        // Кольцо в порядке записи: от самой старой уцелевшей зоны
+        const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+        const std::uint64_t size = buffer->ring.size();
+        const std::uint64_t first = head > size ? head - size : 0;
+        dropped += first;
+        for (std::uint64_t i = first; i < head; ++i) {
+            const TraceEvent& ev = buffer->ring[i & (size - 1)];
+            out << ",\n{\"name\":\"";
+            write_escaped(out, ev.name);
+            out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"ts\":" << (ev.start_ns - origin_ns) / 1000.0
+                << ",\"dur\":" << (ev.end_ns - ev.start_ns) / 1000.0 << "}";
+        }
+        written += head - first;
+    }
+    out << "\n]}\n";
+
+    std::cout << "Trace: " << written << " zones from " << buffers.size() << " threads written to " << path;
+    if (dropped > 0) std::cout << " (" << dropped << " oldest overwritten)";
+    std::cout << "\n";
+    return out.good();
+}
@@ -0,0 +1,483 @@
+#include "../include/trajectory.h"
+#include "../include/trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+constexpr char FILE_MAGIC[8] = {'P', 'X', 'R', 'T', 'R', 'A', 'J', '1'};
+constexpr char INDEX_MAGIC[8] = {'P', 'X', 'R', 'I', 'N', 'D', 'X', '1'};
+constexpr std::uint64_t HEADER_SIZE = 8 + 4 * 3;
+constexpr std::uint64_t FRAME_HEADER_SIZE = 1 + 4;       // тип, длина содержимого
+constexpr std::uint64_t TRAILER_SIZE = 8 * 3 + 8;        // смещение индекса, кадров, опорных, метка
+
+constexpr std::uint8_t FRAME_KEY = 'K';
+constexpr std::uint8_t FRAME_DELTA = 'D';
+
+// Байт элемента кадра: два бита вида и флаги
+constexpr std::uint8_t ENTRY_SAME = 0;   // тот же NPC, что и на этом месте в прошлом кадре
+constexpr std::uint8_t ENTRY_MOVED = 1;  // NPC с другого места прошлого кадра (swap-remove)
+constexpr std::uint8_t ENTRY_NEW = 2;    // NPC, которого в прошлом кадре не было
+constexpr std::uint8_t ENTRY_KIND_MASK = 3;
+constexpr std::uint8_t ENTRY_ALIVE = 1 << 2;
+constexpr std::uint8_t ENTRY_MOVED_POS = 1 << 3;
+constexpr std::uint8_t ENTRY_HEALTH = 1 << 4;
+
+constexpr std::uint32_t NO_PREV = 0xFFFFFFFFu;
+
+void put_varint(std::vector<std::uint8_t>& buf, std::uint64_t v) {
+    while (v >= 0x80) {
+        buf.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    buf.push_back(static_cast<std::uint8_t>(v));
+}
+
+void put_svarint(std::vector<std::uint8_t>& buf, std::int64_t v) {
+    put_varint(buf, (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63));
+}
+
+template <typename T>
+void write_le(std::ostream& os, T v) {
+    char bytes[sizeof(T)];
+    for (std::size_t i = 0; i < sizeof(T); ++i) bytes[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+    os.write(bytes, sizeof(T));
+}
+
+template <typename T>
+bool read_le(std::istream& is, T& v) {
+    unsigned char bytes[sizeof(T)];
+    if (!is.read(reinterpret_cast<char*>(bytes), sizeof(T))) return false;
+    v = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i) v |= static_cast<T>(bytes[i]) << (8 * i);
+    return true;
+}
+
+// Чтение содержимого кадра; при выходе за границу ok становится false
+struct Cursor {
+    const std::uint8_t* p;
+    const std::uint8_t* end;
+    bool ok{true};
+
+    std::uint8_t byte() {
+        if (p == end) {
+            ok = false;
+            return 0;
+        }
+        return *p++;
+    }
+
+    std::uint64_t varint() {
+        std::uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const std::uint8_t b = byte();
+            v |= std::uint64_t{b & 0x7Fu} << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+
+    std::int64_t svarint() {
+        const std::uint64_t v = varint();
+        return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+    }
+};
+
+} // namespace
+
+TrajectoryRecorder::TrajectoryRecorder(const std::string& path_, std::uint32_t keyframe_interval_, int map_w,
+                                       int map_h)
+    : out(path_, std::ios::binary | std::ios::trunc), path(path_), keyframe_interval(std::max(1u, keyframe_interval_))
+{
+    out.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    write_le<std::uint32_t>(out, keyframe_interval);
+    write_le<std::uint32_t>(out, static_cast<std::uint32_t>(map_w));
+    write_le<std::uint32_t>(out, static_cast<std::uint32_t>(map_h));
+    bytes = HEADER_SIZE;
+}
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+    finish();
+}
+
+void TrajectoryRecorder::record(const TrajectoryFrame& frame) {
+    if (finished || !out) return;
+    TraceZone zone("record");
+
+    const bool key = frames % keyframe_interval == 0;
+    payload.clear();
+    put_varint(payload, frame.tick);
+    put_varint(payload, frame.removed);
+    put_varint(payload, frame.count);
+
+    for (std::size_t i = 0; i < frame.count; ++i) {
+        const NPCHandle h = frame.handles[i];
+        const std::int32_t x = frame.x[i], y = frame.y[i], hp = frame.health[i];
+        std::uint8_t tag = frame.alive[i] ? ENTRY_ALIVE : 0;
+
+        std::uint32_t from = NO_PREV;
+        if (!key) {
+            if (i < prev.size() && prev[i].handle == h) from = static_cast<std::uint32_t>(i);
+            else if (h.index() < prev_index_of_slot.size() && prev_index_of_slot[h.index()] != NO_PREV &&
+                     prev[prev_index_of_slot[h.index()]].handle == h)
+                from = prev_index_of_slot[h.index()];
+        }
+
+        if (from == NO_PREV) {
+            const NPC& npc = *(*frame.npcs)[i];
+            const std::size_t name_len = std::min<std::size_t>(npc.name.size(), sizeof(NPCRenderState::name) - 1);
+            payload.push_back(tag | ENTRY_NEW);
+            put_varint(payload, h.bits);
+            payload.push_back(static_cast<std::uint8_t>(npc.type));
+            put_varint(payload, static_cast<std::uint64_t>(npc.get_max_health()));
+            payload.push_back(static_cast<std::uint8_t>(name_len));
+            payload.insert(payload.end(), npc.name.begin(), npc.name.begin() + static_cast<std::ptrdiff_t>(name_len));
+            put_svarint(payload, x);
+            put_svarint(payload, y);
+            put_svarint(payload, hp);
+            continue;
+        }
+
+        const Entry& p = prev[from];
+        const bool moved_pos = p.x != x || p.y != y;
+        const bool health_changed = p.health != hp;
+        tag |= from == i ? ENTRY_SAME : ENTRY_MOVED;
+        if (moved_pos) tag |= ENTRY_MOVED_POS;
+        if (health_changed) tag |= ENTRY_HEALTH;
+        payload.push_back(tag);
+        if (from != i) put_varint(payload, from);
+        if (moved_pos) {
+            put_svarint(payload, std::int64_t{x} - p.x);
+            put_svarint(payload, std::int64_t{y} - p.y);
+        }
+        if (health_changed) put_svarint(payload, std::int64_t{hp} - p.health);
+    }
+
+    if (key) keyframes.emplace_back(frame.tick, bytes);
+    out.put(static_cast<char>(key ? FRAME_KEY : FRAME_DELTA));
+    write_le<std::uint32_t>(out, static_cast<std::uint32_t>(payload.size()));
+    out.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+    bytes += FRAME_HEADER_SIZE + payload.size();
+    frames++;
+    npc_entries += frame.count;
+
+    // Состояние для следующего разностного кадра
+    for (const Entry& e : prev)
+        if (e.handle.index() < prev_index_of_slot.size()) prev_index_of_slot[e.handle.index()] = NO_PREV;
+    prev.resize(frame.count);
+    for (std::size_t i = 0; i < frame.count; ++i) {
+        prev[i] = Entry{frame.handles[i], frame.x[i], frame.y[i], frame.health[i]};
+        const std::uint32_t slot = frame.handles[i].index();
+        if (slot >= prev_index_of_slot.size()) prev_index_of_slot.resize(slot + 1, NO_PREV);
+        prev_index_of_slot[slot] = static_cast<std::uint32_t>(i);
+    }
+}
+
+void TrajectoryRecorder::finish() {
+    if (finished) return;
+    finished = true;
+    if (!out) return;
+
+    const std::uint64_t index_offset = bytes;
+    for (const auto& [tick, offset] : keyframes) {
+        write_le<std::uint64_t>(out, tick);
+        write_le<std::uint64_t>(out, offset);
+    }
+    write_le<std::uint64_t>(out, index_offset);
+    write_le<std::uint64_t>(out, frames);
+    write_le<std::uint64_t>(out, keyframes.size());
+    out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    bytes += keyframes.size() * 16 + TRAILER_SIZE;
+    out.flush();
+}
+
+void TrajectoryRecorder::printSummary() const {
+    if (frames == 0) return;
+    std::cout << "\n=== Trajectory recording: " << path << " ===\n"
+              << std::fixed << std::setprecision(1) << frames << " frames (" << keyframes.size()
+              << " keyframes, every " << keyframe_interval << " ticks), " << bytes / 1024.0 << " KiB, "
+              << static_cast<double>(bytes) / frames << " bytes/frame";
+    if (npc_entries) std::cout << ", " << static_cast<double>(bytes) / npc_entries << " bytes/NPC";
+    std::cout << (out ? "\n" : " (write failed)\n");
+}
+
+bool TrajectoryReader::open(const std::string& path, std::string& error) {
+    in.open(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    char magic[sizeof(FILE_MAGIC)];
+    std::uint32_t mw = 0, mh = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0 ||
+        !read_le(in, keyframe_interval) || !read_le(in, mw) || !read_le(in, mh)) {
+        error = path + " is not a trajectory recording";
+        return false;
+    }
+    map_w = static_cast<int>(mw);
+    map_h = static_cast<int>(mh);
+    frames_begin = HEADER_SIZE;
+
+    in.seekg(0, std::ios::end);
+    const std::uint64_t size = static_cast<std::uint64_t>(in.tellg());
+
+    // Индекс из хвоста; если его нет или он не сходится — проход по кадрам
+    bool indexed = false;
+    if (size >= HEADER_SIZE + TRAILER_SIZE) {
+        std::uint64_t index_offset = 0, frames = 0, keys = 0;
+        char tail[sizeof(INDEX_MAGIC)];
+        in.seekg(static_cast<std::streamoff>(size - TRAILER_SIZE));
+        if (read_le(in, index_offset) && read_le(in, frames) && read_le(in, keys) && in.read(tail, sizeof(tail)) &&
+            std::memcmp(tail, INDEX_MAGIC, sizeof(tail)) == 0 && index_offset >= frames_begin &&
+            index_offset + keys * 16 + TRAILER_SIZE == size) {
+            in.seekg(static_cast<std::streamoff>(index_offset));
+            keyframes.resize(keys);
+            indexed = true;
+            for (auto& [tick, offset] : keyframes) indexed = indexed && read_le(in, tick) && read_le(in, offset);
+            frames_end = index_offset;
+            frame_count = frames;
+        }
+    }
+    if (!indexed) {
+        frames_end = size;
+        if (!scanFrames()) {
+            error = path + ": no complete keyframe";
+            return false;
+        }
+    }
+    if (keyframes.empty()) {
+        error = path + ": recording has no frames";
+        return false;
+    }
+    in.clear();
+
+    // Последний тик — по последнему кадру от последнего опорного
+    FrameSnapshot last;
+    if (!seek(~std::uint64_t{0}, last)) {
+        error = path + ": corrupt frame data";
+        return false;
+    }
+    last_tick = last.tick;
+    return true;
+}
+
+bool TrajectoryReader::scanFrames() {
+    keyframes.clear();
+    frame_count = 0;
+    std::uint64_t offset = frames_begin;
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(offset));
+    for (;;) {
+        const int type = in.get();
+        std::uint32_t len = 0;
+        if (type == std::char_traits<char>::eof() || !read_le(in, len)) break;
+        if (offset + FRAME_HEADER_SIZE + len > frames_end) break;  // недописанный кадр
+        if (type == FRAME_KEY) {
+            payload.resize(len);
+            in.read(reinterpret_cast<char*>(payload.data()), len);
+            Cursor c{payload.data(), payload.data() + payload.size()};
+            const std::uint64_t tick = c.varint();
+            if (!c.ok) break;
+            keyframes.emplace_back(tick, offset);
+        } else if (type == FRAME_DELTA) {
+            in.seekg(len, std::ios::cur);
+        } else {
+            break;
+        }
+        if (!in) break;
+        offset += FRAME_HEADER_SIZE + len;
+        frame_count++;
+    }
+    frames_end = offset;
+    return !keyframes.empty();
+}
+
+bool TrajectoryReader::seek(std::uint64_t tick, FrameSnapshot& out) {
+    TraceZone zone("trajectory seek");
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), tick,
+                               [](std::uint64_t t, const auto& key) { return t < key.first; });
+    if (it != keyframes.begin()) --it;
+    cursor = it->second;
+    prev.clear();
+    prev_handles.clear();
+    std::fill(prev_index_of_slot.begin(), prev_index_of_slot.end(), NO_PREV);
+
+    if (!next(out)) return false;
+    FrameSnapshot ahead;
+    while (out.tick < tick && cursor < frames_end) {
+        if (!next(ahead)) return false;
+        std::swap(out, ahead);
+    }
+    return true;
+}
+
+bool TrajectoryReader::next(FrameSnapshot& out) {
+    if (cursor >= frames_end) return false;
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(cursor));
+    const int type = in.get();
+    std::uint32_t len = 0;
+    if (!read_le(in, len) || cursor + FRAME_HEADER_SIZE + len > frames_end) return false;
+    payload.resize(len);
+    if (!in.read(reinterpret_cast<char*>(payload.data()), len)) return false;
+    if (!decode(static_cast<std::uint8_t>(type), out)) return false;
+    cursor += FRAME_HEADER_SIZE + len;
+    return true;
+}
+
+bool TrajectoryReader::decode(std::uint8_t type, FrameSnapshot& out) {
+    // Разностный кадр ссылается на prev: seek() всегда начинает с опорного
+    if (type != FRAME_KEY && type != FRAME_DELTA) return false;
+
+    Cursor c{payload.data(), payload.data() + payload.size()};
+    out.tick = c.varint();
+    const std::uint64_t removed = c.varint();
+    const std::uint64_t count = c.varint();
+    if (!c.ok || count > payload.size()) return false;  // каждый элемент занимает хотя бы байт
+
+    out.npcs.resize(count);
+    std::vector<NPCHandle> handles(count);
+    out.alive_count = 0;
+    out.dead_count = static_cast<int>(removed);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint8_t tag = c.byte();
+        NPCRenderState& st = out.npcs[i];
+        std::int64_t x, y, hp;
+        const std::uint8_t entry_kind = tag & ENTRY_KIND_MASK;
+
+        if (entry_kind == ENTRY_NEW) {
+            handles[i].bits = static_cast<std::uint32_t>(c.varint());
+            // Тип индексирует таблицы спрайтов и глифов: битый файл не должен выйти за них
+            const std::uint8_t type = c.byte();
+            if (type >= static_cast<std::uint8_t>(NPCType::Count)) return false;
+            st.type = static_cast<NPCType>(type);
+            st.max_health = static_cast<int>(c.varint());
+            const std::uint8_t name_len = std::min<std::uint8_t>(c.byte(), sizeof(st.name) - 1);
+            for (std::uint8_t k = 0; k < name_len; ++k) st.name[k] = static_cast<char>(c.byte());
+            st.name[name_len] = '\0';
+            x = c.svarint();
+            y = c.svarint();
+            hp = c.svarint();
+
+            // Плавный переход через опорный кадр: прошлая позиция того же NPC, если он был
+            const std::uint32_t slot = handles[i].index();
+            const std::uint32_t from = slot < prev_index_of_slot.size() ? prev_index_of_slot[slot] : NO_PREV;
+            if (from != NO_PREV && prev_handles[from] == handles[i]) {
+                st.prev_x = prev[from].x;
+                st.prev_y = prev[from].y;
+            } else {
+                st.prev_x = static_cast<float>(x);
+                st.prev_y = static_cast<float>(y);
+            }
+        } else {
+            const std::uint64_t from = entry_kind == ENTRY_MOVED ? c.varint() : i;
+            if (entry_kind > ENTRY_MOVED || from >= prev.size()) return false;
+            const NPCRenderState& p = prev[from];
+            handles[i] = prev_handles[from];
+            x = static_cast<std::int64_t>(p.x);
+            y = static_cast<std::int64_t>(p.y);
+            hp = p.health;
+            if (tag & ENTRY_MOVED_POS) {
+                x += c.svarint();
+                y += c.svarint();
+            }
+            if (tag & ENTRY_HEALTH) hp += c.svarint();
+            st.type = p.type;
+            st.max_health = p.max_health;
+            std::memcpy(st.name, p.name, sizeof(st.name));
+            st.prev_x = p.x;
+            st.prev_y = p.y;
+        }
+        if (!c.ok) return false;
+
+        st.x = static_cast<float>(x);
+        st.y = static_cast<float>(y);
+        st.health = static_cast<int>(hp);
+        st.alive = (tag & ENTRY_ALIVE) != 0;
+        st.handle = handles[i];
+        if (st.alive) out.alive_count++;
+        else out.dead_count++;
+    }
+
+    // Индекс слотов кадра и состояние для следующего разностного кадра
+    for (NPCHandle h : prev_handles)
+        if (h.index() < prev_index_of_slot.size()) prev_index_of_slot[h.index()] = NO_PREV;
+    out.slot_index.assign(out.slot_index.size(), FrameSnapshot::NO_INDEX);
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint32_t slot = handles[i].index();
+        if (slot >= out.slot_index.size()) out.slot_index.resize(slot + 1, FrameSnapshot::NO_INDEX);
+        if (slot >= prev_index_of_slot.size()) prev_index_of_slot.resize(slot + 1, NO_PREV);
+        out.slot_index[slot] = static_cast<std::uint32_t>(i);
+        prev_index_of_slot[slot] = static_cast<std::uint32_t>(i);
+    }
+    prev = out.npcs;
+    prev_handles = std::move(handles);
+    return true;
+}
+
+TrajectoryPlayer::TrajectoryPlayer(TrajectoryReader& reader_, SnapshotPublisher& publisher_, SimulationClock& clock_)
+    : reader(reader_), publisher(publisher_), clock(clock_) {}
+
+void TrajectoryPlayer::seekTo(std::uint64_t tick) {
+    const auto start = std::chrono::steady_clock::now();
+    if (!reader.seek(tick, frame)) return;
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    seeks++;
+    seek_ms_total += ms;
+    seek_ms_max = std::max(seek_ms_max, ms);
+    publisher.publishFrame(frame);
+    shown++;
+}
+
+void TrajectoryPlayer::run(std::uint64_t start_tick, std::atomic<bool>& running, std::atomic<bool>& paused,
+                           bool stop_at_end) {
+    using namespace std::chrono_literals;
+    seekTo(std::max(start_tick, reader.firstTick()));
+
+    while (running) {
+        if (const std::int64_t delta = pending_seek.exchange(0, std::memory_order_relaxed)) {
+            const std::int64_t target = static_cast<std::int64_t>(frame.tick) + delta;
+            seekTo(static_cast<std::uint64_t>(std::clamp<std::int64_t>(
+                target, static_cast<std::int64_t>(reader.firstTick()), static_cast<std::int64_t>(reader.lastTick()))));
+            continue;
+        }
+
+        clock.setPaused(paused);
+        if (paused) {
+            std::this_thread::sleep_for(20ms);
+            continue;
+        }
+
+        // Один кадр записи на TICK_MS времени симуляции, как и при записи
+        if (!clock.waitForNextTick(running)) break;
+        if (!reader.next(frame)) {
+            reached_end = true;
+            if (stop_at_end) {
+                running = false;
+                break;
+            }
+            paused = true;
+            continue;
+        }
+        publisher.publishFrame(frame);
+        shown++;
+    }
+}
+
+void TrajectoryPlayer::printSummary() const {
+    std::cout << "\n=== Trajectory playback (ticks " << reader.firstTick() << "-" << reader.lastTick() << ", "
+              << reader.frameCount() << " frames, keyframe every " << reader.keyframeInterval() << ") ===\n"
+              << std::fixed << std::setprecision(1) << "frames shown: " << shown << " | last tick " << frame.tick
+              << ": " << frame.alive_count << " alive, " << frame.dead_count << " dead"
+              << (reached_end ? " (end of recording)\n" : "\n");
+    if (seeks)
+        std::cout << "seeks: " << seeks << ", " << std::setprecision(3) << seek_ms_total / seeks << " ms avg, "
+                  << seek_ms_max << " ms max\n";
+}
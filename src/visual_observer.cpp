@@ -0,0 +1,86 @@
+#include "../include/visual_observer.h"
+#include "../include/render_commands.h"
+#include "../include/memory_tracker.h"
+#include "../include/trace.h"
+
+// Singleton implementation
+std::shared_ptr<IInteractionObserver> VisualObserver::get() {
+    static VisualObserver instance;
+    return std::shared_ptr<IInteractionObserver>(&instance, [](IInteractionObserver*) {});
+}
+
+void VisualObserver::on_interaction([[maybe_unused]] const NPCStore& world, NPCHandle actor,
+                                  NPCHandle target, InteractionOutcome outcome) {
+    TraceZone zone("VisualObserver::on_interaction");
+    if (!actor.valid() || !target.valid() || outcome == InteractionOutcome::NoInteraction) return;
+    
+    // Никаких блокировок и вывода: поток взаимодействий не должен ждать GUI.
+    // Позицию в снимке даёт FrameSnapshot::find(); он же отвергает ссылки на
+    // слоты, которые к кадру заняли другие NPC
+    if (!events.push(EffectEvent{actor, target, outcome}))
+        dropped_events.fetch_add(1, std::memory_order_relaxed);
+}
+
+void VisualObserver::consumeEvents(const FrameSnapshot& snap, float t, std::int64_t now_ms) {
+    TraceZone zone("VisualObserver::consumeEvents");
+    MemoryScope scope(MemSubsystem::Effects);
+    effect_store.expire(now_ms);
+    
+    EffectEvent ev;
+    while (events.pop(ev)) {
+        const NPCRenderState* actor_state = snap.find(ev.actor);
+        const NPCRenderState* target_state = snap.find(ev.target);
+        if (!actor_state || !target_state) continue;
+        
+        const NPCRenderState& actor = *actor_state;
+        const NPCRenderState& target = *target_state;
+        
+        float target_x = target.prev_x + (target.x - target.prev_x) * t;
+        float target_y = target.prev_y + (target.y - target.prev_y) * t;
+        
+        switch (ev.outcome) {
+            case InteractionOutcome::TargetKilled:
+                lastInteractionMessage = std::string(actor.name) + " killed " + target.name;
+                addEffect(EffectType::Kill, target_x, target_y, 800.0f, rgba(255, 120, 20), now_ms);
+                addParticles(target_x, target_y, 25, rgba(255, 50, 0));
+                break;
+                
+            case InteractionOutcome::TargetHurted:
+                lastInteractionMessage = std::string(actor.name) + " hurt " + target.name;
+                addEffect(EffectType::Hurt, target_x, target_y, 400.0f, rgba(255, 255, 0), now_ms);
+                addParticles(target_x, target_y, 10, rgba(255, 100, 0));
+                break;
+                
+            case InteractionOutcome::TargetEscaped:
+                lastInteractionMessage = std::string(target.name) + " escaped from " + actor.name;
+                addEffect(EffectType::Escape, target_x, target_y, 500.0f, rgba(0, 255, 0), now_ms);
+                break;
+                
+            case InteractionOutcome::TargetHealed:
+                lastInteractionMessage = std::string(actor.name) + " healed " + target.name;
+                addEffect(EffectType::Heal, target_x, target_y, 800.0f, rgba(0, 255, 255), now_ms);
+                addParticles(target_x, target_y, 15, rgba(100, 255, 200));
+                break;
+                
+            case InteractionOutcome::NoInteraction:
+                break;
+        }
+    }
+}
+
+void VisualObserver::addEffect(EffectType type, float x, float y, float duration_ms, std::uint32_t color, std::int64_t now_ms) {
+    effect_store.add(type, x, y, duration_ms, color, now_ms);
+}
+
+void VisualObserver::addParticles(float x, float y, int count, std::uint32_t color) {
+    particle_pool.spawn(x, y, count, color, 0.5f);
+}
+
+void VisualObserver::setParticleBudget(std::size_t budget) {
+    particle_pool.setFrameBudget(budget);
+}
+
+void VisualObserver::updateParticles(float dt) {
+    MemoryScope scope(MemSubsystem::Effects);
+    particle_pool.update(dt);
+}
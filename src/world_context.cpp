@@ -0,0 +1,32 @@
+#include "../include/world_context.h"
+#include "../include/memory_tracker.h"
+
+WorldContext::WorldContext(std::uint64_t seed) : rand(seed) {
+    manager.setStore(&world);
+    manager.setRandom(&rand);
+}
+
+WorldContext::WorldContext(WorldContext& parent, int)
+    : world(list, parent.world), rand(parent.rand), factory(parent.factory, rand) {
+    manager.setStore(&world);
+    manager.setRandom(&rand);
+    manager.setCombatMode(parent.manager.combatMode());
+}
+
+std::unique_ptr<WorldContext> WorldContext::fork() {
+    return std::unique_ptr<WorldContext>(new WorldContext(*this, 0));
+}
+
+void WorldContext::subscribe(std::shared_ptr<IInteractionObserver> observer) {
+    // Наблюдатель записывается в сам NPC: унаследованные от родителя сначала копируются
+    world.copyInherited();
+    for (auto& npc : list) npc->subscribe(observer);
+    observers.push_back(std::move(observer));
+}
+
+NPCHandle WorldContext::spawn() {
+    MemoryScope scope(MemSubsystem::World);
+    auto npc = factory.make();
+    for (const auto& observer : observers) npc->subscribe(observer);
+    return world.spawn(std::move(npc));
+}
@@ -0,0 +1,153 @@
+#include "../include/world_fork.h"
+#include "../include/job_system.h"
+#include "../include/sim_clock.h"
+#include "../include/state_hash.h"
+#include "../include/tick_scheduler.h"
+#include "../include/trace.h"
+#include "../include/world_context.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+BranchResult run_branch(WorldContext& world, const TickScheduler& trunk_scheduler, double spawn_debt,
+                        const BranchSpec& spec, std::uint64_t ticks, JobSystem& jobs) {
+    TraceZone zone("branch");
+    const auto start = std::chrono::steady_clock::now();
+    BranchResult out;
+    out.spec = spec;
+
+    world.interactions().setCombatMode(spec.combat);
+    TickScheduler scheduler(world.store(), jobs, MAP_X, MAP_Y, CELL_SIZE, world.interactions());
+    scheduler.continueFrom(trunk_scheduler);
+    if (spec.seed != 0) {
+        // Тот же порядок, что и у свежего мира: генераторы, затем зерно планировщика
+        world.random().seed(spec.seed);
+        scheduler.setSeed(world.random().engine()());
+    }
+    scheduler.setHashing(true);
+
+    for (std::uint64_t t = 0; t < ticks; ++t) {
+        spawn_debt += spec.spawn_rate * SimulationClock::TICK_MS / 1000.0;
+        for (; spawn_debt >= 1.0; spawn_debt -= 1.0) world.spawn();
+        scheduler.tick();
+    }
+
+    out.world_hash = scheduler.last().world_hash;
+    out.world_tick = scheduler.worldTick();
+    for (const auto& npc : world.npcs()) {
+        if (!world.store().isAlive(*npc)) continue;
+        out.survivors[static_cast<std::size_t>(npc->type)]++;
+        out.live++;
+    }
+    out.copied_chunks = world.store().copiedChunks();
+    out.chunks = world.store().chunkCount();
+    out.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return out;
+}
+
+} // namespace
+
+std::vector<BranchResult> run_branches(WorldContext& trunk, const TickScheduler& trunk_scheduler,
+                                       double spawn_debt, const std::vector<BranchSpec>& specs,
+                                       std::uint64_t ticks, JobSystem& jobs) {
+    // fork() меняет счётчики общих кусков ствола — только из одного потока
+    std::vector<std::unique_ptr<WorldContext>> worlds;
+    worlds.reserve(specs.size());
+    for (std::size_t i = 0; i < specs.size(); ++i) worlds.push_back(trunk.fork());
+
+    std::vector<BranchResult> results(specs.size());
+    // Как в run_batch: пул делит либо ветки, либо фазы одной ветки. Вложенный
+    // parallelFor на том же пуле ждал бы целую чужую ветку внутри своего тика
+    if (specs.size() >= jobs.threadCount()) {
+        jobs.parallelFor(specs.size(), 1, [&](std::size_t begin, std::size_t end) {
+            JobSystem serial(1);
+            for (std::size_t i = begin; i < end; ++i)
+                results[i] = run_branch(*worlds[i], trunk_scheduler, spawn_debt, specs[i], ticks, serial);
+        });
+    } else {
+        for (std::size_t i = 0; i < specs.size(); ++i)
+            results[i] = run_branch(*worlds[i], trunk_scheduler, spawn_debt, specs[i], ticks, jobs);
+    }
+    return results;
+}
+
+bool run_fork_study(const ForkSetup& setup, const std::string& csv_path) {
+    using clock = std::chrono::steady_clock;
+    std::cout << "=== Fork: seed " << setup.seed << ", " << setup.npcs << " NPCs, fork at tick " << setup.fork_tick
+              << ", " << setup.branches << " branches x " << setup.ticks << " ticks, spawn rate "
+              << setup.spawn_rate << " ===\n";
+
+    // Ствол в порядке run_lockstep: те же хэши, что и у main с --seed
+    JobSystem jobs(setup.threads);
+    WorldContext trunk(setup.seed);
+    trunk.interactions().setCombatMode(setup.combat);
+    for (int i = 0; i < setup.npcs; ++i) trunk.spawn();
+    TickScheduler scheduler(trunk.store(), jobs, MAP_X, MAP_Y, CELL_SIZE, trunk.interactions());
+    scheduler.setSeed(trunk.random().engine()());
+    scheduler.setHashing(true);
+
+    const auto trunk_start = clock::now();
+    double spawn_debt = 0;
+    for (std::uint64_t t = 0; t < setup.fork_tick; ++t) {
+        spawn_debt += setup.spawn_rate * SimulationClock::TICK_MS / 1000.0;
+        for (; spawn_debt >= 1.0; spawn_debt -= 1.0) trunk.spawn();
+        scheduler.tick();
+    }
+    const double trunk_ms = std::chrono::duration<double, std::milli>(clock::now() - trunk_start).count();
+    std::cout << "trunk: " << trunk.store().size() << " NPCs at tick " << scheduler.worldTick() << ", hash ";
+    state_hash::write_hex(std::cout, scheduler.last().world_hash) << " (" << std::fixed << std::setprecision(1) << trunk_ms << " ms)\n";
+
+    std::vector<BranchSpec> specs(setup.branches);
+    for (std::size_t i = 0; i < specs.size(); ++i) {
+        specs[i].spawn_rate = setup.spawn_rate;
+        specs[i].combat = i == 0 ? setup.combat : setup.branch_combat;
+        std::uint64_t state = setup.seed + i;
+        specs[i].seed = i == 0 ? 0 : splitmix64(state) | 1u;
+    }
+
+    const auto start = clock::now();
+    const std::vector<BranchResult> results = run_branches(trunk, scheduler, spawn_debt, specs, setup.ticks, jobs);
+    const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+    std::cout << std::setprecision(1) << seconds * 1000.0 << " ms for all branches, "
+              << static_cast<double>(results.size()) * setup.ticks / std::max(seconds, 1e-9) << " branch ticks/s\n";
+
+    std::cout << std::left << std::setw(8) << "branch" << std::setw(22) << "seed" << std::setw(12) << "combat"
+              << std::setw(18) << "hash" << std::right << std::setw(7) << "live";
+    for (std::size_t t = 1; t < NPC_TYPE_COUNT; ++t) std::cout << std::setw(10) << type_to_string(static_cast<NPCType>(t));
+    std::cout << std::setw(10) << "copied" << std::setw(10) << "ms" << '\n';
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BranchResult& r = results[i];
+        std::cout << std::left << std::setw(8) << i << std::setw(22)
+                  << (r.spec.seed == 0 ? std::string("control") : std::to_string(r.spec.seed)) << std::setw(12)
+                  << combat_mode_name(r.spec.combat);
+        state_hash::write_hex(std::cout, r.world_hash) << "  " << std::right << std::setw(7) << r.live;
+        for (std::size_t t = 1; t < NPC_TYPE_COUNT; ++t) std::cout << std::setw(10) << r.survivors[t];
+        std::cout << std::setw(5) << r.copied_chunks << '/' << std::left << std::setw(4) << r.chunks << std::right
+                  << std::setw(10) << r.ms << '\n';
+    }
+    std::cout << "control branch = main --seed " << setup.seed << " --ticks " << setup.fork_tick + setup.ticks << "\n";
+
+    if (csv_path.empty()) return true;
+    std::ofstream f(csv_path, std::ios::trunc);
+    f << "branch,seed,combat,world_tick,hash,live";
+    for (std::size_t t = 1; t < NPC_TYPE_COUNT; ++t) f << ",survivors_" << type_to_string(static_cast<NPCType>(t));
+    f << ",copied_chunks,chunks,ms\n" << std::fixed << std::setprecision(3);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BranchResult& r = results[i];
+        f << i << ',' << r.spec.seed << ',' << combat_mode_name(r.spec.combat) << ',' << r.world_tick << ',';
+        state_hash::write_hex(f, r.world_hash) << ',' << r.live;
+        for (std::size_t t = 1; t < NPC_TYPE_COUNT; ++t) f << ',' << r.survivors[t];
+        f << ',' << r.copied_chunks << ',' << r.chunks << ',' << r.ms << '\n';
+    }
+    if (!f.good()) {
+        std::cerr << "Cannot write " << csv_path << "\n";
+        return false;
+    }
+    std::cout << "per-branch rows: " << csv_path << "\n";
+    return true;
+}